@@ -52,6 +52,9 @@ namespace SSC {
       DWORD mainThread = GetCurrentThreadId();
 #elif defined(__linux__)
       Bridge *bridge;
+      // work handed to the GTK thread, drained in batches per idle callback
+      static MPSCQueue<std::function<void()>> dispatchQueue;
+      static std::atomic<bool> isDispatchScheduled;
 #endif
 
       static std::atomic<bool> isReady;
@@ -74,6 +77,7 @@ namespace SSC {
     public:
       App *app;
       Core *core;
+      BufferRegistry buffers;
 
       Bridge (App *app) {
         this->core = new Core();
@@ -81,9 +85,16 @@ namespace SSC {
       }
 
       bool route (SSC::String msg, char *buf, size_t bufsize);
+      bool queueBuffer (int index, SSC::String seq, Buffer buffer);
       void send (Parse cmd, SSC::String seq, SSC::String msg, Post post);
       bool invoke (Parse cmd, char *buf, size_t bufsize, Callback cb);
       bool invoke (Parse cmd, Callback cb);
+      bool queuePost (int index, SSC::String seq, SSC::String msg, Post post);
+      void pollPosts (int index, WebKitURISchemeRequest *request);
+      void flushPosts (int index);
+      void queueDelivery (int index, SSC::String seq, SSC::String value);
+      void flushDeliveries (int index);
+      SSC::String getDeliveryStats ();
   };
 #endif
 
@@ -3,7 +3,121 @@
 #include "app.hh"
 
 namespace SSC {
-  static Map bufferQueue;
+  constexpr uint64_t POST_CHANNEL_IDLE_TIMEOUT = 1000; // in milliseconds
+  constexpr size_t POST_CHANNEL_BATCH_SIZE = 256; // posts per response
+  constexpr size_t POST_CHANNEL_FRAME_HEADER_SIZE = 5 * sizeof(uint32_t);
+
+  /**
+   * Unsolicited posts for one window, delivered in batches to the
+   * `ipc://post.poll` request the window's runtime keeps open.
+   */
+  struct PostChannel {
+    struct Entry {
+      uint64_t id;
+      SSC::String seq;
+      SSC::String params;
+    };
+
+    std::deque<Entry> queue;
+    WebKitURISchemeRequest *request = nullptr;
+    uint64_t lastPollAt = 0;
+    bool isFlushScheduled = false;
+  };
+
+  constexpr size_t DELIVERY_QUEUE_MAX_COUNT = 256; // flushed early past this
+  constexpr size_t DELIVERY_QUEUE_MAX_BYTES = 256 * 1024; // or past this
+
+  /**
+   * Results for one window waiting to be resolved in its webview. They go
+   * out as a single `_ipc.deliver()` script per idle tick instead of one
+   * script per result.
+   */
+  struct DeliveryQueue {
+    struct Entry {
+      SSC::String seq;
+      SSC::String value;
+    };
+
+    std::vector<Entry> entries;
+    size_t bytes = 0;
+    std::chrono::steady_clock::time_point firstQueuedAt;
+    bool isFlushScheduled = false;
+  };
+
+  struct DeliveryStats {
+    uint64_t flushes = 0;
+    uint64_t delivered = 0;
+    uint64_t largestBatch = 0;
+    uint64_t totalLatency = 0; // in microseconds
+    uint64_t maxLatency = 0; // in microseconds
+  };
+
+  static std::map<int, DeliveryQueue> deliveryQueues;
+  static DeliveryStats deliveryStats;
+  static std::mutex deliveryQueuesMutex;
+
+  /**
+   * Results of an `ipc://batch` request, answered in one reply once every
+   * sub-command has called back once.
+   */
+  // sub-commands still unanswered by then are replied to with a timeout error
+  constexpr uint64_t BATCH_TIMEOUT = 30 * 1000; // in milliseconds
+
+  struct BatchResults {
+    std::mutex mutex;
+    SSC::Vector<SSC::String> messages;
+    SSC::Vector<bool> isDone;
+    size_t remaining = 0;
+    uint64_t timer = 0;
+  };
+
+  static std::map<int, PostChannel> postChannels;
+  static std::mutex postChannelsMutex;
+
+  // the stream holds a reference to `buffer` until WebKit is done with it
+  static void addBufferToInputStream (GInputStream *stream, const Buffer &buffer) {
+    auto bytes = g_bytes_new_with_free_func(
+      buffer.data(),
+      buffer.size(),
+      Buffer::release,
+      buffer.retain()
+    );
+
+    g_memory_input_stream_add_bytes(G_MEMORY_INPUT_STREAM(stream), bytes);
+    g_bytes_unref(bytes);
+  }
+
+  static GInputStream* createBufferInputStream (const Buffer &buffer) {
+    auto stream = g_memory_input_stream_new();
+    addBufferToInputStream(stream, buffer);
+    return stream;
+  }
+
+#if SSC_IPC_FRAMES
+  static SSC::String readRequestBody (WebKitURISchemeRequest *request) {
+    SSC::String body;
+    auto stream = webkit_uri_scheme_request_get_http_body(request);
+
+    if (stream == nullptr) {
+      return body;
+    }
+
+    constexpr size_t CHUNK_SIZE = 64 * 1024;
+    size_t size = 0;
+    gssize read = 0;
+
+    // read straight into the body, growing it a chunk at a time
+    do {
+      body.resize(size + CHUNK_SIZE);
+      read = g_input_stream_read(stream, body.data() + size, CHUNK_SIZE, nullptr, nullptr);
+      size += read > 0 ? read : 0;
+    } while (read > 0);
+
+    body.resize(size);
+    g_object_unref(stream);
+    return body;
+  }
+#endif
 
   struct CallbackContext {
     Callback cb;
@@ -13,6 +127,8 @@ namespace SSC {
   };
 
   std::atomic<bool> App::isReady {false};
+  std::atomic<bool> App::isDispatchScheduled {false};
+  MPSCQueue<std::function<void()>> App::dispatchQueue;
 
   App::App (int instanceId)  {
     this->bridge =  new Bridge(this);
@@ -29,24 +145,96 @@ namespace SSC {
 
         Parse cmd(msg);
 
-        auto invoked = app->bridge->invoke(cmd, [=](auto seq, auto result, auto post) {
-          auto size = post.body != nullptr ? post.length : result.size();
-          auto body = post.body != nullptr ? post.body : result.c_str();
+        if (cmd.name == "post.poll") {
+          app->bridge->pollPosts(cmd.index, request);
+          return;
+        }
+
+        char *buf = nullptr;
+        size_t bufsize = 0;
+        auto isFrame = false;
+
+#if SSC_IPC_FRAMES
+        // a frame is the request body and `buf` views its bytes field,
+        // otherwise `buf` is the body itself (such as `fs.write` data)
+        auto body = readRequestBody(request);
+
+        if (cmd.name == "frame") {
+          isFrame = true;
+
+          if (auto frame = decodeIPCRequestFrame(body.data(), body.size())) {
+            cmd = frame->cmd;
+            buf = (char *) frame->body;
+            bufsize = frame->bodySize;
+          }
+        } else if (body.size() > 0) {
+          buf = body.data();
+          bufsize = body.size();
+        }
+#endif
+
+        auto finish = [=](SSC::String seq, SSC::String result, Post post) {
+          GInputStream *stream = nullptr;
+          size_t size = 0;
+
+          if (isFrame) {
+            // the post body follows the frame without being copied into it
+            auto frame = encodeIPCResponseFrame(seq, result, post);
+            stream = createBufferInputStream(frame);
+            size = frame.size();
+
+            if (post.body) {
+              addBufferToInputStream(stream, post.body);
+              size += post.body.size();
+            }
+          } else {
+            auto body = post.body ? post.body : Buffer::copy(result);
+            stream = createBufferInputStream(body);
+            size = body.size();
+          }
 
-          // `post.body` is free'd with `freeFunction`
-          post.bodyNeedsFree = false;
-          auto freeFunction = post.body != nullptr ? free : nullptr;
-          auto stream = g_memory_input_stream_new_from_data(body, size, freeFunction);
           auto response = webkit_uri_scheme_response_new(stream, size);
 
+          // lets callers tell a result message from a binary body
           webkit_uri_scheme_response_set_content_type(
             response,
-            "application/octet-stream"
+            isFrame || post.body ? "application/octet-stream" : "application/json"
           );
 
           webkit_uri_scheme_request_finish_with_response(request, response);
 
           g_object_unref(stream);
+        };
+
+        if (isFrame && cmd.name == "frame") {
+          finish("", R"MSG({
+            "err": {
+              "type": "InternalError",
+              "message": "Malformed IPC frame"
+            }
+          })MSG", Post{});
+          return;
+        }
+
+        auto responded = std::make_shared<std::atomic<bool>>(false);
+
+        auto invoked = app->bridge->invoke(cmd, buf, bufsize, [=](auto seq, auto result, auto post) {
+          // a scheme request is answered once, anything after it (such as
+          // `udp.readStart` datagrams) goes out like a `route()` result
+          if (seq == "-1" || responded->exchange(true)) {
+            app->bridge->send(cmd, seq, result, post);
+            return;
+          }
+
+#if SSC_LINUX_EVENT_LOOP_THREAD
+          // results arrive on the event loop thread, but WebKit must only be
+          // called from the GTK thread
+          app->dispatch([=]() {
+            finish(seq, result, post);
+          });
+#else
+          finish(seq, result, post);
+#endif
         });
 
         if (!invoked) {
@@ -68,6 +256,11 @@ namespace SSC {
             }
           })MSG", uri);
 
+          if (isFrame) {
+            finish(cmd.get("seq"), msg, Post{});
+            return;
+          }
+
           auto stream = g_memory_input_stream_new_from_data(msg.c_str(), msg.size(), 0);
           auto response = webkit_uri_scheme_response_new(stream, msg.size());
 
@@ -106,16 +299,34 @@ namespace SSC {
   }
 
   void App::dispatch(std::function<void()> f) {
+    dispatchQueue.push(std::move(f));
+
+    // only one idle callback is pending at a time, it drains everything
+    // queued before it runs so a burst of results costs one GTK wakeup
+    if (isDispatchScheduled.exchange(true)) {
+      return;
+    }
+
     g_idle_add_full(
       G_PRIORITY_HIGH_IDLE,
-      (GSourceFunc)([](void* f) -> int {
-        (*static_cast<std::function<void()>*>(f))();
+      (GSourceFunc)([](void*) -> int {
+        std::function<void()> f = nullptr;
+
+        // reset before draining so a concurrent `dispatch()` schedules again
+        App::isDispatchScheduled.exchange(false);
+
+        // anything dispatched while draining is left for the next idle callback
+        auto pending = App::dispatchQueue.size();
+
+        while (pending-- > 0 && App::dispatchQueue.pop(f)) {
+          if (f != nullptr) f();
+          f = nullptr;
+        }
+
         return G_SOURCE_REMOVE;
       }),
-      new std::function<void()>(f),
-      [](void* f) {
-        delete static_cast<std::function<void()>*>(f);
-      }
+      nullptr,
+      nullptr
     );
   }
 
@@ -123,16 +334,20 @@ namespace SSC {
     return this->invoke(cmd, nullptr, 0, cb);
   }
 
-  bool Bridge::invoke (Parse cmd, char *buf, size_t bufsize, Callback cb) {
-    auto seq = cmd.get("seq");
+  using BridgeCommandRouter = CommandRouter<Bridge*, Parse, String, char*, size_t, Callback>;
+
+  static BridgeCommandRouter& getCommandRouter ();
 
-    if (cmd.name == "post" || cmd.name == "data") {
+  static BridgeCommandRouter* createCommandRouter () {
+    auto router = new BridgeCommandRouter();
+
+    router->on(COMMAND_POST, [](auto bridge, auto cmd, auto seq, auto buf, auto bufsize, auto cb) {
       auto id = cmd.get("id");
 
       if (id.size() == 0) {
         auto err = SSC::format(R"MSG({
           "err": {
-            "id", "$S",
+            "id": "$S",
             "type": "InternalError",
             "message": "'id' is required"
           }
@@ -142,12 +357,15 @@ namespace SSC {
         return true;
       }
 
-      auto pid = std::stoull(id);
+      auto pid = cmd.getU64("id").value_or(0);
+
+      Post post;
 
-      if (!this->core->hasPost(pid)) {
+      // the response takes ownership of the body, so it is not freed here
+      if (!bridge->core->takePost(pid, post)) {
         auto err = SSC::format(R"MSG({
           "err": {
-            "id", "$S",
+            "id": "$S",
             "type": "InternalError",
             "message": "Invalid 'id' for post"
           }
@@ -157,49 +375,102 @@ namespace SSC {
         return true;
       }
 
-      auto post = this->core->getPost(pid);
       cb(seq, "{}", post);
-      this->core->removePost(pid);
       return true;
-    }
+    });
 
-    if (cmd.name == "getPlatformOS" || cmd.name == "os.platform") {
+    router->on(COMMAND_OS_PLATFORM, [](auto bridge, auto cmd, auto seq, auto buf, auto bufsize, auto cb) {
       auto msg = SSC::format(R"JSON({
         "data": "$S"
       })JSON", SSC::platform.os);
 
       cb(seq, msg, Post{});
       return true;
-    }
+    });
 
-    if (cmd.name == "getPlatformType" || cmd.name == "os.type") {
+    router->on(COMMAND_OS_TYPE, [](auto bridge, auto cmd, auto seq, auto buf, auto bufsize, auto cb) {
       auto msg = SSC::format(R"JSON({
         "data": "$S"
       })JSON", SSC::platform.os);
 
       cb(seq, msg, Post{});
       return true;
-    }
+    });
 
-    if (cmd.name == "getPlatformArch" || cmd.name == "os.arch") {
+    router->on(COMMAND_OS_ARCH, [](auto bridge, auto cmd, auto seq, auto buf, auto bufsize, auto cb) {
       auto msg = SSC::format(R"JSON({
         "data": "$S"
       })JSON", SSC::platform.arch);
 
       cb(seq, msg, Post{});
       return true;
-    }
+    });
 
-    if (cmd.name == "getNetworkInterfaces" || cmd.name == "os.networkInterfaces") {
-      this->app->dispatch([=, this] {
-        auto msg = this->core->getNetworkInterfaces();
+    router->on(COMMAND_OS_NETWORK_INTERFACES, [](auto bridge, auto cmd, auto seq, auto buf, auto bufsize, auto cb) {
+      bridge->app->dispatch([=] {
+        auto msg = bridge->core->getNetworkInterfaces();
         cb(seq, msg, Post{});
       });
       return true;
-    }
+    });
+
+    router->on(COMMAND_TIMER_SET, [](auto bridge, auto cmd, auto seq, auto buf, auto bufsize, auto cb) {
+      if (cmd.get("id").size() == 0 || cmd.get("timeout").size() == 0) {
+        auto err = SSC::format(R"MSG({
+          "err": {
+            "type": "InternalError",
+            "message": ".id and .timeout are required"
+          }
+        })MSG");
+
+        cb(seq, err, Post{});
+        return true;
+      }
+
+      auto id = cmd.getU64("id").value_or(0);
+      auto timeout = cmd.getU64("timeout").value_or(0);
+      auto interval = cmd.getU64("interval").value_or(0);
+      bridge->core->timerSet(seq, id, timeout, interval, cb);
+      return true;
+    });
+
+    router->on(COMMAND_TIMER_CLEAR, [](auto bridge, auto cmd, auto seq, auto buf, auto bufsize, auto cb) {
+      if (cmd.get("id").size() == 0) {
+        auto err = SSC::format(R"MSG({
+          "err": {
+            "type": "InternalError",
+            "message": ".id is required"
+          }
+        })MSG");
+
+        cb(seq, err, Post{});
+        return true;
+      }
+
+      auto id = cmd.getU64("id").value_or(0);
+      bridge->core->timerClear(seq, id, cb);
+      return true;
+    });
+
+    router->on(COMMAND_LOOP_STATS, [](auto bridge, auto cmd, auto seq, auto buf, auto bufsize, auto cb) {
+      // read directly on the UI thread so a stalled loop is still observable
+      auto msg = bridge->core->getEventLoopStats();
+      cb(seq, msg, Post{});
+      return true;
+    });
+
+    router->on(COMMAND_POSTS_STATS, [](auto bridge, auto cmd, auto seq, auto buf, auto bufsize, auto cb) {
+      auto msg = bridge->core->getPostsStats();
+      cb(seq, msg, Post{});
+      return true;
+    });
+
+    router->on(COMMAND_WINDOW_EVAL, [](auto bridge, auto cmd, auto seq, auto buf, auto bufsize, auto cb) {
+      if (cmd.index < 0) {
+        return false;
+      }
 
-    if (cmd.name == "window.eval" && cmd.index >= 0) {
-      auto windowFactory = reinterpret_cast<WindowFactory<Window, App> *>(app->getWindowFactory());
+      auto windowFactory = reinterpret_cast<WindowFactory<Window, App> *>(bridge->app->getWindowFactory());
       if (windowFactory == nullptr) {
         // @TODO(jwerle): print warning
         return false;
@@ -211,8 +482,8 @@ namespace SSC {
         return false;
       }
 
-      auto value = decodeURIComponent(cmd.get("value"));
-      auto ctx = new CallbackContext { cb, seq, window, (void *) this };
+      auto value = cmd.getDecoded("value");
+      auto ctx = new CallbackContext { cb, seq, window, (void *) bridge };
 
       webkit_web_view_run_javascript(
         WEBKIT_WEB_VIEW(window->webview),
@@ -284,27 +555,23 @@ namespace SSC {
       );
 
       return true;
-    }
+    });
 
-    if (cmd.name == "dnsLookup" || cmd.name == "dns.lookup") {
+    router->on(COMMAND_DNS_LOOKUP, [](auto bridge, auto cmd, auto seq, auto buf, auto bufsize, auto cb) {
       auto hostname = cmd.get("hostname");
-      auto strFamily = cmd.get("family");
-      int family = 0;
+      auto family = cmd.getInt("family").value_or(0);
 
-      if (strFamily.size() > 0) {
-        try {
-          family = std::stoi(strFamily);
-        } catch (...) {
-        }
-      }
-
-      this->app->dispatch([=, this] {
-        this->core->dnsLookup(seq, hostname, family, cb);
+      bridge->app->dispatch([=] {
+        bridge->core->dnsLookup(seq, hostname, family, cb);
       });
       return true;
-    }
+    });
+
+    router->on(COMMAND_BUFFER_QUEUE, [](auto bridge, auto cmd, auto seq, auto buf, auto bufsize, auto cb) {
+      if (buf == nullptr) {
+        return false;
+      }
 
-    if (cmd.name == "buffer.queue" && buf != nullptr) {
       if (seq.size() == 0) {
         auto err = SSC::format(R"MSG({
           "err": {
@@ -317,30 +584,37 @@ namespace SSC {
         return true;
       }
 
-      auto bufferKey = std::to_string(cmd.index) + seq;
-      auto str = SSC::String();
-      str.assign(buf, bufsize);
-      bufferQueue[bufferKey] = str;
+      if (!bridge->queueBuffer(cmd.index, seq, Buffer::copy(buf, bufsize))) {
+        auto err = SSC::format(R"MSG({
+          "err": {
+            "type": "InternalError",
+            "message": "Unable to queue buffer for 'seq'"
+          }
+        })MSG");
+
+        cb(seq, err, Post{});
+      }
+
       return true;
-    }
+    });
 
-    if (cmd.name == "event") {
-      this->app->dispatch([=, this] {
-        auto event = decodeURIComponent(cmd.get("value"));
-        auto data = decodeURIComponent(cmd.get("data"));
+    router->on(COMMAND_EVENT, [](auto bridge, auto cmd, auto seq, auto buf, auto bufsize, auto cb) {
+      bridge->app->dispatch([=] {
+        auto event = cmd.getDecoded("value");
+        auto data = cmd.getDecoded("data");
         auto seq = cmd.get("seq");
 
-        this->core->handleEvent(seq, event, data, cb);
+        bridge->core->handleEvent(seq, event, data, cb);
       });
       return true;
-    }
+    });
 
-    if (cmd.name == "getFSConstants" || cmd.name == "fs.constants") {
-      cb(seq, this->core->getFSConstants(), Post{});
+    router->on(COMMAND_FS_CONSTANTS, [](auto bridge, auto cmd, auto seq, auto buf, auto bufsize, auto cb) {
+      cb(seq, bridge->core->getFSConstants(), Post{});
       return true;
-    }
+    });
 
-    if (cmd.name == "fsAccess" || cmd.name == "fs.access") {
+    router->on(COMMAND_FS_ACCESS, [](auto bridge, auto cmd, auto seq, auto buf, auto bufsize, auto cb) {
       if (cmd.get("path").size() == 0) {
         auto err = SSC::format(R"MSG({
           "err": {
@@ -365,16 +639,16 @@ namespace SSC {
         return true;
       }
 
-      this->app->dispatch([=, this] {
-        auto path = decodeURIComponent(cmd.get("path"));
-        auto mode = std::stoi(cmd.get("mode"));
+      bridge->app->dispatch([=] {
+        auto path = cmd.getDecoded("path");
+        auto mode = cmd.getInt("mode").value_or(0);
 
-        this->core->fsAccess(seq, path, mode, cb);
+        bridge->core->fsAccess(seq, path, mode, cb);
       });
       return true;
-    }
+    });
 
-    if (cmd.name == "fsChmod" || cmd.name == "fs.chmod") {
+    router->on(COMMAND_FS_CHMOD, [](auto bridge, auto cmd, auto seq, auto buf, auto bufsize, auto cb) {
       if (cmd.get("path").size() == 0) {
         auto err = SSC::format(R"MSG({
           "err": {
@@ -399,16 +673,16 @@ namespace SSC {
         return true;
       }
 
-      this->app->dispatch([=, this] {
-        auto path = decodeURIComponent(cmd.get("path"));
-        auto mode = std::stoi(cmd.get("mode"));
+      bridge->app->dispatch([=] {
+        auto path = cmd.getDecoded("path");
+        auto mode = cmd.getInt("mode").value_or(0);
 
-        this->core->fsChmod(seq, path, mode, cb);
+        bridge->core->fsChmod(seq, path, mode, cb);
       });
       return true;
-    }
+    });
 
-    if (cmd.name == "fsClose" || cmd.name == "fs.close") {
+    router->on(COMMAND_FS_CLOSE, [](auto bridge, auto cmd, auto seq, auto buf, auto bufsize, auto cb) {
       if (cmd.get("id").size() == 0) {
         auto err = SSC::format(R"MSG({
           "err": {
@@ -421,14 +695,14 @@ namespace SSC {
         return true;
       }
 
-      this->app->dispatch([=, this] {
-        auto id = std::stoull(cmd.get("id"));
-        this->core->fsClose(seq, id, cb);
+      bridge->app->dispatch([=] {
+        auto id = cmd.getU64("id").value_or(0);
+        bridge->core->fsClose(seq, id, cb);
       });
       return true;
-    }
+    });
 
-    if (cmd.name == "fsClosedir" || cmd.name == "fs.closedir") {
+    router->on(COMMAND_FS_CLOSEDIR, [](auto bridge, auto cmd, auto seq, auto buf, auto bufsize, auto cb) {
       if (cmd.get("id").size() == 0) {
         auto err = SSC::format(R"MSG({
           "err": {
@@ -441,21 +715,21 @@ namespace SSC {
         return true;
       }
 
-      this->app->dispatch([=, this] {
-        auto id = std::stoull(cmd.get("id"));
-        this->core->fsClosedir(seq, id, cb);
+      bridge->app->dispatch([=] {
+        auto id = cmd.getU64("id").value_or(0);
+        bridge->core->fsClosedir(seq, id, cb);
       });
       return true;
-    }
+    });
 
-    if (cmd.name == "fsGetOpenDescriptors" || cmd.name == "fs.getOpenDescriptors") {
-      this->app->dispatch([=, this] {
-        this->core->fsGetOpenDescriptors(seq, cb);
+    router->on(COMMAND_FS_GET_OPEN_DESCRIPTORS, [](auto bridge, auto cmd, auto seq, auto buf, auto bufsize, auto cb) {
+      bridge->app->dispatch([=] {
+        bridge->core->fsGetOpenDescriptors(seq, cb);
       });
       return true;
-    }
+    });
 
-    if (cmd.name == "fsCloseOpenDescriptor" || cmd.name == "fs.closeOpenDescriptor") {
+    router->on(COMMAND_FS_CLOSE_OPEN_DESCRIPTOR, [](auto bridge, auto cmd, auto seq, auto buf, auto bufsize, auto cb) {
       if (cmd.get("id").size() == 0) {
         auto err = SSC::format(R"MSG({
           "err": {
@@ -468,47 +742,47 @@ namespace SSC {
         return true;
       }
 
-      this->app->dispatch([=, this] {
-        auto id = std::stoull(cmd.get("id"));
-        this->core->fsCloseOpenDescriptor(seq, id, cb);
+      bridge->app->dispatch([=] {
+        auto id = cmd.getU64("id").value_or(0);
+        bridge->core->fsCloseOpenDescriptor(seq, id, cb);
       });
       return true;
-    }
+    });
 
-    if (cmd.name == "fsCloseOpenDescriptors" || cmd.name == "fs.closeOpenDescriptors") {
-      this->app->dispatch([=, this] {
+    router->on(COMMAND_FS_CLOSE_OPEN_DESCRIPTORS, [](auto bridge, auto cmd, auto seq, auto buf, auto bufsize, auto cb) {
+      bridge->app->dispatch([=] {
         auto preserveRetained = cmd.get("retain") != "false";
-        this->core->fsCloseOpenDescriptors(seq, preserveRetained, cb);
+        bridge->core->fsCloseOpenDescriptors(seq, preserveRetained, cb);
       });
       return true;
-    }
+    });
 
-    if (cmd.name == "fsCopyFile" || cmd.name == "fs.copyFile") {
-      this->app->dispatch([=, this] {
+    router->on(COMMAND_FS_COPY_FILE, [](auto bridge, auto cmd, auto seq, auto buf, auto bufsize, auto cb) {
+      bridge->app->dispatch([=] {
         auto src = cmd.get("src");
         auto dest = cmd.get("dest");
-        auto mode = std::stoi(cmd.get("dest"));
+        auto mode = cmd.getInt("dest").value_or(0);
 
-        this->core->fsCopyFile(seq, src, dest, mode, cb);
+        bridge->core->fsCopyFile(seq, src, dest, mode, cb);
       });
       return true;
-    }
+    });
 
-    if (cmd.name == "fsOpen" || cmd.name == "fs.open") {
-      this->app->dispatch([=, this] {
+    router->on(COMMAND_FS_OPEN, [](auto bridge, auto cmd, auto seq, auto buf, auto bufsize, auto cb) {
+      bridge->app->dispatch([=] {
         auto seq = cmd.get("seq");
-        auto path = decodeURIComponent(cmd.get("path"));
-        auto flags = std::stoi(cmd.get("flags"));
-        auto mode = std::stoi(cmd.get("mode"));
-        auto id = std::stoull(cmd.get("id"));
+        auto path = cmd.getDecoded("path");
+        auto flags = cmd.getInt("flags").value_or(0);
+        auto mode = cmd.getInt("mode").value_or(0);
+        auto id = cmd.getU64("id").value_or(0);
 
-        this->core->fsOpen(seq, id, path, flags, mode, cb);
+        bridge->core->fsOpen(seq, id, path, flags, mode, cb);
       });
 
       return true;
-    }
+    });
 
-    if (cmd.name == "fsOpendir" || cmd.name == "fs.opendir") {
+    router->on(COMMAND_FS_OPENDIR, [](auto bridge, auto cmd, auto seq, auto buf, auto bufsize, auto cb) {
       if (cmd.get("id").size() == 0) {
         auto err = SSC::format(R"MSG({
           "err": {
@@ -533,36 +807,46 @@ namespace SSC {
         return true;
       }
 
-      this->app->dispatch([=, this] {
-        auto path = decodeURIComponent(cmd.get("path"));
-        auto id = std::stoull(cmd.get("id"));
+      bridge->app->dispatch([=] {
+        auto path = cmd.getDecoded("path");
+        auto id = cmd.getU64("id").value_or(0);
 
-        this->core->fsOpendir(seq, id, path,  cb);
+        bridge->core->fsOpendir(seq, id, path,  cb);
       });
       return true;
-    }
+    });
 
-    if (cmd.name == "fsRead" || cmd.name == "fs.read") {
-      this->app->dispatch([=, this] {
-        auto id = std::stoull(cmd.get("id"));
-        auto size = std::stoi(cmd.get("size"));
-        auto offset = std::stoi(cmd.get("offset"));
+    router->on(COMMAND_FS_READ, [](auto bridge, auto cmd, auto seq, auto buf, auto bufsize, auto cb) {
+      bridge->app->dispatch([=] {
+        auto id = cmd.getU64("id").value_or(0);
+        auto size = cmd.getInt("size").value_or(0);
+        auto offset = cmd.getInt("offset").value_or(0);
 
-        this->core->fsRead(seq, id, size, offset, cb);
+        bridge->core->fsRead(seq, id, size, offset, cb);
       });
       return true;
-    }
+    });
 
-    if (cmd.name == "fsRetainOpenDescriptor" || cmd.name == "fs.retainOpenDescriptor") {
-      this->app->dispatch([=, this] {
-        auto id = std::stoull(cmd.get("id"));
+    router->on(COMMAND_FS_READ_STREAM, [](auto bridge, auto cmd, auto seq, auto buf, auto bufsize, auto cb) {
+      bridge->app->dispatch([=] {
+        auto id = cmd.getU64("id").value_or(0);
+        auto offset = cmd.getI64("offset").value_or(0);
 
-        this->core->fsRetainOpenDescriptor(seq, id, cb);
+        bridge->core->fsReadStream(seq, id, offset, cb);
       });
       return true;
-    }
+    });
 
-    if (cmd.name == "fsReaddir" || cmd.name == "fs.readdir") {
+    router->on(COMMAND_FS_RETAIN_OPEN_DESCRIPTOR, [](auto bridge, auto cmd, auto seq, auto buf, auto bufsize, auto cb) {
+      bridge->app->dispatch([=] {
+        auto id = cmd.getU64("id").value_or(0);
+
+        bridge->core->fsRetainOpenDescriptor(seq, id, cb);
+      });
+      return true;
+    });
+
+    router->on(COMMAND_FS_READDIR, [](auto bridge, auto cmd, auto seq, auto buf, auto bufsize, auto cb) {
       if (cmd.get("id").size() == 0) {
         auto err = SSC::format(R"MSG({
           "err": {
@@ -575,52 +859,143 @@ namespace SSC {
         return true;
       }
 
-      this->app->dispatch([=, this] {
-        auto id = std::stoull(cmd.get("id"));
-        auto entries = std::stoi(cmd.get("entries", "256"));
+      bridge->app->dispatch([=] {
+        auto id = cmd.getU64("id").value_or(0);
+        auto entries = cmd.getInt("entries").value_or(256);
 
-        this->core->fsReaddir(seq, id, entries, cb);
+        bridge->core->fsReaddir(seq, id, entries, cb);
       });
       return true;
-    }
+    });
 
-    if (cmd.name == "fsWrite" || cmd.name == "fs.write") {
-      auto bufferKey = std::to_string(cmd.index) + seq;
-      if (bufferQueue.count(bufferKey)) {
-          auto id = std::stoull(cmd.get("id"));
-          auto offset = std::stoi(cmd.get("offset"));
-          auto buffer = bufferQueue[bufferKey];
-          bufferQueue.erase(bufferQueue.find(bufferKey));
+    router->on(COMMAND_FS_READV, [](auto bridge, auto cmd, auto seq, auto buf, auto bufsize, auto cb) {
+      auto offsets = cmd.getI64List("offsets");
+      auto sizes = cmd.getI64List("sizes");
+      auto segments = getFSSegments(offsets, sizes);
 
-        this->app->dispatch([=, this] {
-          this->core->fsWrite(seq, id, buffer, offset, cb);
-        });
+      if (!segments) {
+        auto err = SSC::format(R"MSG({
+          "err": {
+            "type": "InternalError",
+            "message": "'offsets' and 'sizes' must list the same number of non-negative integers"
+          }
+        })MSG");
+
+        cb(seq, err, Post{});
+        return true;
       }
 
+      bridge->app->dispatch([=] {
+        auto id = cmd.getU64("id").value_or(0);
+        bridge->core->fsReadv(seq, id, *segments, cb);
+      });
       return true;
-    }
+    });
+
+    router->on(COMMAND_FS_STAT, [](auto bridge, auto cmd, auto seq, auto buf, auto bufsize, auto cb) {
+      auto path = cmd.getDecoded("path");
+
+      bridge->app->dispatch([=] {
+        bridge->core->fsStat(seq, path, cb);
+      });
+      return true;
+    });
+
+    router->on(COMMAND_FS_WRITE, [](auto bridge, auto cmd, auto seq, auto buf, auto bufsize, auto cb) {
+      auto id = cmd.getU64("id").value_or(0);
+      auto offset = cmd.getInt("offset").value_or(0);
+      auto number = BufferRegistry::parseSeq(seq);
+      Buffer buffer;
+
+      // frames and request bodies carry their bytes, otherwise they were
+      // sent with `buffer.queue`
+      if (buf != nullptr) {
+        buffer = Buffer::copy(buf, bufsize);
+      } else if (!number || !bridge->buffers.take(cmd.index, *number, buffer)) {
+        auto err = SSC::format(R"MSG({
+          "source": "fs.write",
+          "err": {
+            "type": "NotFoundError",
+            "message": "No buffer was queued for this request"
+          }
+        })MSG");
+
+        cb(seq, err, Post{});
+        return true;
+      }
+
+      bridge->app->dispatch([=] {
+        bridge->core->fsWrite(seq, id, buffer, offset, cb);
+      });
+
+      return true;
+    });
+
+    router->on(COMMAND_FS_WRITEV, [](auto bridge, auto cmd, auto seq, auto buf, auto bufsize, auto cb) {
+      auto id = cmd.getU64("id").value_or(0);
+      auto offset = cmd.getI64("offset").value_or(-1);
+      auto sizes = getFSWriteSizes(cmd.getI64List("sizes"));
+      auto number = BufferRegistry::parseSeq(seq);
+      Buffer buffer;
+
+      if (buf != nullptr) {
+        buffer = Buffer::copy(buf, bufsize);
+      } else if (!number || !bridge->buffers.take(cmd.index, *number, buffer)) {
+        auto err = SSC::format(R"MSG({
+          "source": "fs.writev",
+          "err": {
+            "type": "NotFoundError",
+            "message": "No buffer was queued for this request"
+          }
+        })MSG");
+
+        cb(seq, err, Post{});
+        return true;
+      }
 
-    if (cmd.name == "udpClose" || cmd.name == "udp.close") {
+      if (!sizes) {
+        auto err = SSC::format(R"MSG({
+          "err": {
+            "type": "InternalError",
+            "message": "'sizes' must list non-negative integers"
+          }
+        })MSG");
+
+        cb(seq, err, Post{});
+        return true;
+      }
+
+      // no `sizes` writes the whole body as one buffer
+      if (sizes->empty()) {
+        sizes->push_back(buffer.size());
+      }
+
+      bridge->app->dispatch([=] {
+        bridge->core->fsWritev(seq, id, buffer, *sizes, offset, cb);
+      });
+
+      return true;
+    });
+
+    router->on(COMMAND_UDP_CLOSE, [](auto bridge, auto cmd, auto seq, auto buf, auto bufsize, auto cb) {
       uint64_t peerId = 0ll;
       SSC::String err = "";
 
       if (cmd.get("id").size() == 0) {
         err = ".id is required";
+      } else if (auto parsed = cmd.getU64("id")) {
+        peerId = *parsed;
       } else {
-        try {
-          peerId = std::stoull(cmd.get("id"));
-        } catch (...) {
-          err = "property .id is invalid";
-        }
+        err = "property .id is invalid";
       }
 
-      this->app->dispatch([=, this] {
-        this->core->close(seq, peerId, cb);
+      bridge->app->dispatch([=] {
+        bridge->core->close(seq, peerId, cb);
       });
       return true;
-    }
+    });
 
-    if (cmd.name == "udpBind" || cmd.name == "udp.bind") {
+    router->on(COMMAND_UDP_BIND, [](auto bridge, auto cmd, auto seq, auto buf, auto bufsize, auto cb) {
       if (cmd.get("id").size() == 0) {
         auto err = SSC::format(R"MSG({
           "err": {
@@ -645,7 +1020,7 @@ namespace SSC {
         return true;
       }
 
-      this->app->dispatch([=, this] {
+      bridge->app->dispatch([=] {
         auto ip = cmd.get("address");
         auto reuseAddr = cmd.get("reuseAddr") == "true";
         int port;
@@ -655,15 +1030,15 @@ namespace SSC {
           ip = "0.0.0.0";
         }
 
-        port = std::stoi(cmd.get("port"));
-        peerId = std::stoull(cmd.get("id"));
+        port = cmd.getInt("port").value_or(0);
+        peerId = cmd.getU64("id").value_or(0);
 
-        this->core->udpBind(seq, peerId, ip, port, reuseAddr, cb);
+        bridge->core->udpBind(seq, peerId, ip, port, reuseAddr, cb);
       });
       return true;
-    }
+    });
 
-    if (cmd.name == "udpConnect" || cmd.name == "udp.connect") {
+    router->on(COMMAND_UDP_CONNECT, [](auto bridge, auto cmd, auto seq, auto buf, auto bufsize, auto cb) {
       auto strId = cmd.get("id");
       SSC::String err = "";
       uint64_t peerId = 0ll;
@@ -673,22 +1048,18 @@ namespace SSC {
 
       if (strId.size() == 0) {
         err = "invalid peerId";
+      } else if (auto parsed = cmd.getU64("id")) {
+        peerId = *parsed;
       } else {
-        try {
-          peerId = std::stoull(cmd.get("id"));
-        } catch (...) {
-          err = "invalid peerId";
-        }
+        err = "invalid peerId";
       }
 
       if (strPort.size() == 0) {
         err = "invalid port";
+      } else if (auto parsed = cmd.getInt("port")) {
+        port = *parsed;
       } else {
-        try {
-          port = std::stoi(strPort);
-        } catch (...) {
-          err = "invalid port";
-        }
+        err = "invalid port";
       }
 
       if (port == 0) {
@@ -709,14 +1080,14 @@ namespace SSC {
         ip = "0.0.0.0";
       }
 
-      this->app->dispatch([=, this] {
-        this->core->udpConnect(seq, peerId, ip, port, cb);
+      bridge->app->dispatch([=] {
+        bridge->core->udpConnect(seq, peerId, ip, port, cb);
       });
 
       return true;
-    }
+    });
 
-    if (cmd.name == "udpDisconnect" || cmd.name == "udp.disconnect") {
+    router->on(COMMAND_UDP_DISCONNECT, [](auto bridge, auto cmd, auto seq, auto buf, auto bufsize, auto cb) {
       auto strId = cmd.get("id");
 
       if (strId.size() == 0) {
@@ -729,15 +1100,15 @@ namespace SSC {
         return true;
       }
 
-      auto peerId = std::stoull(strId);
+      auto peerId = cmd.getU64("id").value_or(0);
 
-      this->app->dispatch([=, this] {
-        this->core->udpDisconnect(seq, peerId, cb);
+      bridge->app->dispatch([=] {
+        bridge->core->udpDisconnect(seq, peerId, cb);
       });
       return true;
-    }
+    });
 
-    if (cmd.name == "udpGetPeerName" || cmd.name == "udp.getPeerName") {
+    router->on(COMMAND_UDP_GET_PEER_NAME, [](auto bridge, auto cmd, auto seq, auto buf, auto bufsize, auto cb) {
       auto strId = cmd.get("id");
 
       if (strId.size() == 0) {
@@ -750,15 +1121,15 @@ namespace SSC {
         return true;
       }
 
-      auto peerId = std::stoull(strId);
+      auto peerId = cmd.getU64("id").value_or(0);
 
-      this->app->dispatch([=, this] {
-        this->core->udpGetPeerName(seq, peerId, cb);
+      bridge->app->dispatch([=] {
+        bridge->core->udpGetPeerName(seq, peerId, cb);
       });
       return true;
-    }
+    });
 
-    if (cmd.name == "udpGetSockName" || cmd.name == "udp.getSockName") {
+    router->on(COMMAND_UDP_GET_SOCK_NAME, [](auto bridge, auto cmd, auto seq, auto buf, auto bufsize, auto cb) {
       auto strId = cmd.get("id");
 
       if (strId.size() == 0) {
@@ -771,15 +1142,15 @@ namespace SSC {
         return true;
       }
 
-      auto peerId = std::stoull(strId);
+      auto peerId = cmd.getU64("id").value_or(0);
 
-      this->app->dispatch([=, this] {
-        this->core->udpGetSockName(seq, peerId, cb);
+      bridge->app->dispatch([=] {
+        bridge->core->udpGetSockName(seq, peerId, cb);
       });
       return true;
-    }
+    });
 
-    if (cmd.name == "udpGetState" || cmd.name == "udp.getState") {
+    router->on(COMMAND_UDP_GET_STATE, [](auto bridge, auto cmd, auto seq, auto buf, auto bufsize, auto cb) {
       auto strId = cmd.get("id");
 
       if (strId.size() == 0) {
@@ -792,15 +1163,15 @@ namespace SSC {
         return true;
       }
 
-      auto peerId = std::stoull(strId);
+      auto peerId = cmd.getU64("id").value_or(0);
 
-      this->app->dispatch([=, this] {
-        this->core->udpGetState(seq, peerId, cb);
+      bridge->app->dispatch([=] {
+        bridge->core->udpGetState(seq, peerId, cb);
       });
       return true;
-    }
+    });
 
-    if (cmd.name == "udpReadStart" || cmd.name == "udp.readStart") {
+    router->on(COMMAND_UDP_READ_START, [](auto bridge, auto cmd, auto seq, auto buf, auto bufsize, auto cb) {
       if (cmd.get("id").size() == 0) {
         auto err = SSC::format(R"MSG({
           "err": {
@@ -813,14 +1184,14 @@ namespace SSC {
         return true;
       }
 
-      auto peerId = std::stoull(cmd.get("id"));
-      this->app->dispatch([=, this] {
-        this->core->udpReadStart(seq, peerId, cb);
+      auto peerId = cmd.getU64("id").value_or(0);
+      bridge->app->dispatch([=] {
+        bridge->core->udpReadStart(seq, peerId, cb);
       });
       return true;
-    }
+    });
 
-    if (cmd.name == "udpReadStop" || cmd.name == "udp.readStop") {
+    router->on(COMMAND_UDP_READ_STOP, [](auto bridge, auto cmd, auto seq, auto buf, auto bufsize, auto cb) {
       if (cmd.get("id").size() == 0) {
         auto err = SSC::format(R"MSG({
           "err": {
@@ -833,14 +1204,14 @@ namespace SSC {
         return true;
       }
 
-      auto peerId = std::stoull(cmd.get("id"));
-      this->app->dispatch([=, this] {
-        this->core->udpReadStop(seq, peerId, cb);
+      auto peerId = cmd.getU64("id").value_or(0);
+      bridge->app->dispatch([=] {
+        bridge->core->udpReadStop(seq, peerId, cb);
       });
       return true;
-    }
+    });
 
-    if (cmd.name == "udpSend" || cmd.name == "udp.send") {
+    router->on(COMMAND_UDP_SEND, [](auto bridge, auto cmd, auto seq, auto buf, auto bufsize, auto cb) {
       int offset = 0;
       int port = 0;
       uint64_t peerId;
@@ -852,16 +1223,16 @@ namespace SSC {
       auto ip = cmd.get("address");
 
       if (strOffset.size() > 0) {
-        try {
-          offset = std::stoi(strOffset);
-        } catch (...) {
+        if (auto parsed = cmd.getInt("offset"); parsed && *parsed >= 0) {
+          offset = *parsed;
+        } else {
           err = "invalid offset";
         }
       }
 
-      try {
-        port = std::stoi(strPort);
-      } catch (...) {
+      if (auto parsed = cmd.getInt("port")) {
+        port = *parsed;
+      } else {
         err = "invalid port";
       }
 
@@ -869,9 +1240,9 @@ namespace SSC {
         ip = "0.0.0.0";
       }
 
-      try {
-        peerId = std::stoull(cmd.get("id"));
-      } catch (...) {
+      if (auto parsed = cmd.getU64("id")) {
+        peerId = *parsed;
+      } else {
         err = "invalid id";
       }
 
@@ -881,23 +1252,39 @@ namespace SSC {
             "message": "$S"
           }
         })MSG", err);
+        cb(seq, msg, Post{});
+        return true;
+      }
+
+      auto number = BufferRegistry::parseSeq(seq);
+      Buffer buffer;
+
+      // frames and request bodies carry their bytes, otherwise they were
+      // sent with `buffer.queue`
+      if (buf != nullptr) {
+        buffer = Buffer::copy(buf, bufsize);
+      } else if (!number || !bridge->buffers.take(cmd.index, *number, buffer)) {
+        auto err = SSC::format(R"MSG({
+          "source": "udp.send",
+          "err": {
+            "type": "NotFoundError",
+            "message": "No buffer was queued for this request"
+          }
+        })MSG");
+
         cb(seq, err, Post{});
         return true;
       }
 
-      this->app->dispatch([=, this] {
-        auto bufferKey = std::to_string(cmd.index) + seq;
-        auto buffer = bufferQueue[bufferKey];
-        auto data = buffer.data();
-        auto size = buffer.size();
+      buffer = buffer.slice(offset, buffer.size());
 
-        bufferQueue.erase(bufferQueue.find(bufferKey));
-        this->core->udpSend(seq, peerId, data, size, port, ip, ephemeral, cb);
+      bridge->app->dispatch([=] {
+        bridge->core->udpSend(seq, peerId, buffer, port, ip, ephemeral, cb);
       });
       return true;
-    }
+    });
 
-    if (cmd.name == "bufferSize") {
+    router->on(COMMAND_BUFFER_SIZE, [](auto bridge, auto cmd, auto seq, auto buf, auto bufsize, auto cb) {
       if (cmd.get("id").size() == 0) {
         auto err = SSC::format(R"MSG({
           "source": "bufferSize",
@@ -911,18 +1298,165 @@ namespace SSC {
         return true;
       }
 
-      auto buffer = std::stoi(cmd.get("buffer", "0"));
-      auto size = std::stoi(cmd.get("size", "0"));
-      auto id  = std::stoull(cmd.get("id"));
+      auto buffer = cmd.getInt("buffer").value_or(0);
+      auto size = cmd.getInt("size").value_or(0);
+      auto id  = cmd.getU64("id").value_or(0);
 
-      this->app->dispatch([=, this] {
-        this->core->bufferSize(seq, id, size, buffer, cb);
+      bridge->app->dispatch([=] {
+        bridge->core->bufferSize(seq, id, size, buffer, cb);
+      });
+
+      return true;
+    });
+    router->on(COMMAND_BATCH, [](auto bridge, auto cmd, auto seq, auto buf, auto bufsize, auto cb) {
+      // one `ipc://` URI per line, each dispatched like a routed command
+      auto commands = split(cmd.getDecoded("commands"), '\n');
+      auto results = std::make_shared<BatchResults>();
+
+      results->messages.resize(commands.size());
+      results->isDone.resize(commands.size(), false);
+      results->remaining = commands.size();
+
+      auto reply = [=]() {
+        StringStream data;
+
+        for (size_t i = 0; i < results->messages.size(); ++i) {
+          data << (i > 0 ? "," : "") << results->messages[i];
+        }
+
+        cb(seq, SSC::format(R"MSG({ "source": "batch", "data": [$S] })MSG", data.str()), Post{});
+      };
+
+      if (commands.size() == 0) {
+        reply();
+        return true;
+      }
+
+      auto done = [=](size_t i, SSC::String message) {
+        std::unique_lock<std::mutex> lock(results->mutex);
+
+        // later results (such as `udp.readStart` datagrams) are not part of the reply
+        if (results->isDone[i]) {
+          return;
+        }
+
+        // results are spliced in as is, so anything that is not a JSON object
+        // or array (such as a `window.eval` value) goes in as a JSON string
+        auto start = message.find_first_not_of(" \t\r\n");
+        auto isJSON = start != SSC::String::npos && (message[start] == '{' || message[start] == '[');
+
+        results->isDone[i] = true;
+
+        if (message.size() == 0) {
+          results->messages[i] = "null";
+        } else if (isJSON) {
+          results->messages[i] = message;
+        } else {
+          results->messages[i] = JSONWriter(message.size() + 16).value(message).str();
+        }
+
+        if (--results->remaining == 0) {
+          lock.unlock();
+          bridge->core->clearTimer(results->timer);
+          reply();
+        }
+      };
+
+      // a handler that never calls back must not hold up the whole batch
+      results->timer = rand64();
+      bridge->core->setTimer(results->timer, BATCH_TIMEOUT, 0, [=]() {
+        std::unique_lock<std::mutex> lock(results->mutex);
+
+        if (results->remaining == 0) {
+          return;
+        }
+
+        for (size_t i = 0; i < results->messages.size(); ++i) {
+          if (!results->isDone[i]) {
+            results->isDone[i] = true;
+            results->messages[i] = R"MSG({ "err": { "type": "TimeoutError", "message": "Timed out" } })MSG";
+          }
+        }
+
+        results->remaining = 0;
+        lock.unlock();
+        reply();
       });
 
+      for (size_t i = 0; i < commands.size(); ++i) {
+        Parse sub(commands[i]);
+
+        if (sub.name == "batch" || sub.name.size() == 0) {
+          done(i, R"MSG({ "err": { "type": "InternalError", "message": "Invalid batch command" } })MSG");
+          continue;
+        }
+
+        auto invoked = bridge->invoke(sub, nullptr, 0, [=](auto subSeq, auto message, auto post) {
+          if (subSeq == "-1") {
+            bridge->send(sub, subSeq, message, post);
+            return;
+          }
+
+          done(i, message);
+        });
+
+        if (!invoked) {
+          done(i, R"MSG({ "err": { "type": "NotFoundError", "message": "Not found" } })MSG");
+        }
+      }
+
       return true;
+    });
+
+    router->on(COMMAND_IPC_STATS, [](auto bridge, auto cmd, auto seq, auto buf, auto bufsize, auto cb) {
+      cb(seq, bridge->getDeliveryStats(), Post{});
+      return true;
+    });
+
+    router->on(COMMAND_IPC_NEGOTIATE, [](auto bridge, auto cmd, auto seq, auto buf, auto bufsize, auto cb) {
+      // the highest version both sides speak, 0 is the `ipc://` URI format
+#if SSC_IPC_FRAMES
+      auto version = std::min(cmd.getInt("version").value_or(0), (int) IPC_FRAME_VERSION);
+      auto transport = "body";
+#elif SSC_IPC_TYPED_ARRAYS
+      auto version = 0;
+      auto transport = "typed-array";
+#else
+      auto version = 0;
+      auto transport = "string";
+#endif
+
+      cb(seq, getIPCNegotiateResult(version, transport), Post{});
+      return true;
+    });
+
+    router->on(COMMAND_COMMANDS_STATS, [](auto bridge, auto cmd, auto seq, auto buf, auto bufsize, auto cb) {
+      cb(seq, getCommandRouter().getStats(), Post{});
+      return true;
+    });
+
+    return router;
+  }
+
+  static BridgeCommandRouter& getCommandRouter () {
+    // handlers are registered once, on first use, and shared by every bridge
+    static auto router = createCommandRouter();
+    return *router;
+  }
+
+  bool Bridge::invoke (Parse cmd, char *buf, size_t bufsize, Callback cb) {
+    auto seq = cmd.get("seq");
+    return getCommandRouter().invoke(cmd.name, this, cmd, seq, buf, bufsize, cb);
+  }
+
+  bool Bridge::queueBuffer (int index, SSC::String seq, Buffer buffer) {
+    auto number = BufferRegistry::parseSeq(seq);
+
+    if (!number) {
+      return false;
     }
 
-    return false;
+    return this->buffers.put(index, *number, std::move(buffer));
   }
 
   bool Bridge::route (SSC::String msg, char *buf, size_t bufsize) {
@@ -957,6 +1491,10 @@ namespace SSC {
       return;
     }
 
+    if (seq == "-1" && this->queuePost(cmd.index, seq, msg, post)) {
+      return;
+    }
+
     if (post.body || seq == "-1") {
       auto script = this->core->createPost(seq, msg, post);
       window->eval(script);
@@ -964,9 +1502,276 @@ namespace SSC {
     }
 
     if (seq != "-1" && seq.size() > 0) {
-      msg = SSC::getResolveToRenderProcessJavaScript(seq, "0", encodeURIComponent(msg));
+      this->queueDelivery(cmd.index, seq, encodeURIComponent(msg));
+      return;
     }
 
     window->eval(msg);
   }
+
+  void Bridge::queueDelivery (int index, SSC::String seq, SSC::String value) {
+    auto isFull = false;
+
+    {
+      std::lock_guard<std::mutex> guard(deliveryQueuesMutex);
+      auto &queue = deliveryQueues[index];
+
+      if (queue.entries.size() == 0) {
+        queue.firstQueuedAt = std::chrono::steady_clock::now();
+      }
+
+      queue.bytes += seq.size() + value.size();
+      queue.entries.push_back({ seq, value });
+
+      isFull = (
+        queue.entries.size() >= DELIVERY_QUEUE_MAX_COUNT ||
+        queue.bytes >= DELIVERY_QUEUE_MAX_BYTES
+      );
+
+      if (!isFull) {
+        if (queue.isFlushScheduled) {
+          return;
+        }
+
+        queue.isFlushScheduled = true;
+      }
+    }
+
+    if (isFull) {
+      this->flushDeliveries(index);
+      return;
+    }
+
+    // results queued before the idle callback runs go out with it
+    this->app->dispatch([=, this] {
+      this->flushDeliveries(index);
+    });
+  }
+
+  void Bridge::flushDeliveries (int index) {
+    std::vector<DeliveryQueue::Entry> entries;
+
+    {
+      std::lock_guard<std::mutex> guard(deliveryQueuesMutex);
+      auto &queue = deliveryQueues[index];
+
+      if (queue.entries.size() == 0) {
+        queue.isFlushScheduled = false;
+        return;
+      }
+
+      auto latency = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - queue.firstQueuedAt
+      ).count();
+
+      deliveryStats.flushes++;
+      deliveryStats.delivered += queue.entries.size();
+      deliveryStats.largestBatch = std::max(deliveryStats.largestBatch, (uint64_t) queue.entries.size());
+      deliveryStats.totalLatency += latency;
+      deliveryStats.maxLatency = std::max(deliveryStats.maxLatency, (uint64_t) latency);
+
+      std::swap(entries, queue.entries);
+      queue.bytes = 0;
+      queue.isFlushScheduled = false;
+    }
+
+    auto windowFactory = reinterpret_cast<WindowFactory<Window, App> *>(app->getWindowFactory());
+    auto window = windowFactory != nullptr ? windowFactory->getWindow(index) : nullptr;
+
+    if (window == nullptr) {
+      return;
+    }
+
+    // values are URI encoded, so they are safe in single quotes
+    SSC::String script = ";window._ipc.deliver([";
+
+    for (size_t i = 0; i < entries.size(); ++i) {
+      script += (i > 0 ? ",['" : "['") + entries[i].seq + "',0,'" + entries[i].value + "']";
+    }
+
+    script += "]);";
+    window->eval(script);
+  }
+
+  SSC::String Bridge::getDeliveryStats () {
+    std::lock_guard<std::mutex> guard(deliveryQueuesMutex);
+    auto flushes = deliveryStats.flushes;
+
+    return SSC::format(R"MSG({
+      "source": "ipc.stats",
+      "data": {
+        "flushes": $S,
+        "delivered": $S,
+        "averageBatch": $S,
+        "largestBatch": $S,
+        "averageFlushLatency": $S,
+        "maxFlushLatency": $S
+      }
+    })MSG",
+      std::to_string(flushes),
+      std::to_string(deliveryStats.delivered),
+      std::to_string(flushes > 0 ? deliveryStats.delivered / flushes : 0),
+      std::to_string(deliveryStats.largestBatch),
+      std::to_string(flushes > 0 ? deliveryStats.totalLatency / flushes : 0),
+      std::to_string(deliveryStats.maxLatency)
+    );
+  }
+
+  static uint64_t nowInMilliseconds () {
+    return std::chrono::time_point_cast<std::chrono::milliseconds>(
+      std::chrono::steady_clock::now()
+    )
+      .time_since_epoch()
+      .count();
+  }
+
+  static void writeUInt32 (char *bytes, uint32_t value) {
+    for (int i = 0; i < 4; ++i) {
+      bytes[i] = (char) ((value >> (8 * i)) & 0xff);
+    }
+  }
+
+  static void finishPostChannelRequest (WebKitURISchemeRequest *request, const Buffer &buffer) {
+    auto stream = createBufferInputStream(buffer);
+    auto response = webkit_uri_scheme_response_new(stream, buffer.size());
+
+    webkit_uri_scheme_response_set_content_type(
+      response,
+      "application/octet-stream"
+    );
+
+    webkit_uri_scheme_request_finish_with_response(request, response);
+
+    g_object_unref(stream);
+    g_object_unref(request);
+  }
+
+  // queues an unsolicited post for the window's channel, returns `false` if
+  // nothing has polled it recently so the caller falls back to `createPost()`
+  bool Bridge::queuePost (int index, SSC::String seq, SSC::String msg, Post post) {
+    std::lock_guard<std::mutex> guard(postChannelsMutex);
+    auto &channel = postChannels[index];
+
+    if (
+      channel.request == nullptr &&
+      nowInMilliseconds() - channel.lastPollAt > POST_CHANNEL_IDLE_TIMEOUT
+    ) {
+      return false;
+    }
+
+    if (post.id == 0) {
+      post.id = SSC::rand64();
+    }
+
+    // held in the posts store until delivered so it counts against its
+    // byte budget and expires if the window never picks it up
+    this->core->putPost(post.id, post);
+    channel.queue.push_back({ post.id, seq, msg });
+
+    // posts queued before the flush runs go out in the same response
+    if (channel.request != nullptr && !channel.isFlushScheduled) {
+      channel.isFlushScheduled = true;
+      this->app->dispatch([=, this] {
+        this->flushPosts(index);
+      });
+    }
+
+    return true;
+  }
+
+  // must be called on the GTK thread
+  void Bridge::pollPosts (int index, WebKitURISchemeRequest *request) {
+    WebKitURISchemeRequest *previous = nullptr;
+
+    {
+      std::lock_guard<std::mutex> guard(postChannelsMutex);
+      auto &channel = postChannels[index];
+
+      // a reloaded page polls again before the old request is answered
+      previous = channel.request;
+      channel.request = request;
+      g_object_ref(request);
+      channel.lastPollAt = nowInMilliseconds();
+    }
+
+    if (previous != nullptr) {
+      finishPostChannelRequest(previous, Buffer::heap(0));
+    }
+
+    this->flushPosts(index);
+  }
+
+  // must be called on the GTK thread
+  void Bridge::flushPosts (int index) {
+    std::vector<PostChannel::Entry> entries;
+    WebKitURISchemeRequest *request = nullptr;
+
+    {
+      std::lock_guard<std::mutex> guard(postChannelsMutex);
+      auto &channel = postChannels[index];
+      channel.isFlushScheduled = false;
+
+      if (channel.request == nullptr || channel.queue.size() == 0) {
+        return;
+      }
+
+      auto count = std::min(channel.queue.size(), POST_CHANNEL_BATCH_SIZE);
+      for (size_t i = 0; i < count; ++i) {
+        entries.push_back(std::move(channel.queue.front()));
+        channel.queue.pop_front();
+      }
+
+      request = channel.request;
+      channel.request = nullptr;
+      channel.lastPollAt = nowInMilliseconds();
+    }
+
+    std::vector<Post> posts;
+    size_t size = 0;
+
+    for (auto &entry : entries) {
+      Post post;
+
+      // expired while queued, delivered without a body
+      this->core->takePost(entry.id, post);
+
+      auto sid = std::to_string(entry.id);
+      size += POST_CHANNEL_FRAME_HEADER_SIZE + sid.size() + entry.seq.size();
+      size += entry.params.size() + post.headers.size() + post.body.size();
+      posts.push_back(std::move(post));
+    }
+
+    //  <header>                                             | <data>
+    // sid(4) + seq(4) + params(4) + headers(4) + body(4) LE | sid + seq + params + headers + body
+    auto buffer = Buffer::heap(size);
+    auto bytes = buffer.data();
+    size_t offset = 0;
+
+    for (size_t i = 0; i < entries.size(); ++i) {
+      auto &entry = entries[i];
+      auto &post = posts[i];
+      auto sid = std::to_string(entry.id);
+      auto length = post.body.size();
+      SSC::String fields[] = { sid, entry.seq, entry.params, post.headers };
+
+      for (size_t j = 0; j < 4; ++j) {
+        writeUInt32(bytes + offset + j * 4, (uint32_t) fields[j].size());
+      }
+
+      writeUInt32(bytes + offset + 16, (uint32_t) length);
+      offset += POST_CHANNEL_FRAME_HEADER_SIZE;
+
+      for (auto &field : fields) {
+        memcpy(bytes + offset, field.data(), field.size());
+        offset += field.size();
+      }
+
+      if (length > 0) {
+        memcpy(bytes + offset, post.body.data(), length);
+        offset += length;
+      }
+    }
+
+    finishPostChannelRequest(request, buffer);
+  }
 }
@@ -6,6 +6,20 @@
 #define DebugLog(...)
 #endif
 
+// wraps `buffer` without copying, the data holds a reference to it until
+// it is deallocated (returned retained)
+static NSData* dataWithBuffer (const SSC::Buffer& buffer) {
+  auto reference = buffer.retain();
+
+  return [[NSData alloc]
+    initWithBytesNoCopy: (void*) buffer.data()
+                 length: buffer.size()
+            deallocator: ^(void* bytes, NSUInteger length) {
+              SSC::Buffer::release(reference);
+            }
+  ];
+}
+
 @implementation SSCNavigationDelegate
 - (void) webview: (SSCBridgedWebView*) webview
     decidePolicyForNavigationAction: (WKNavigationAction*) navigationAction
@@ -53,11 +67,14 @@
 
   if (cmd.name == "post" || cmd.name == "data") {
     NSMutableDictionary* httpHeaders = [NSMutableDictionary dictionary];
-    uint64_t postId = std::stoull(cmd.get("id"));
-    auto post = self.bridge.core->getPost(postId);
+    uint64_t postId = cmd.getU64("id").value_or(0);
+    SSC::Post post;
+
+    // the response data holds its own reference to `post.body`
+    self.bridge.core->takePost(postId, post);
 
     httpHeaders[@"access-control-allow-origin"] = @"*";
-    httpHeaders[@"content-length"] = [@(post.length) stringValue];
+    httpHeaders[@"content-length"] = [@(post.body.size()) stringValue];
 
     if (post.headers.size() > 0) {
       auto lines = SSC::split(SSC::trim(post.headers), '\n');
@@ -80,8 +97,11 @@
     [task didReceiveResponse: httpResponse];
 
     if (post.body) {
-      NSData *data = [NSData dataWithBytes: post.body length: post.length];
+      NSData *data = dataWithBuffer(post.body);
       [task didReceiveData: data];
+      #if !__has_feature(objc_arc)
+      [data release];
+      #endif
     } else {
       NSString* str = [NSString stringWithUTF8String: ""];
       NSData* data = [str dataUsingEncoding: NSUTF8StringEncoding];
@@ -93,16 +113,6 @@
     [httpResponse release];
     #endif
 
-    // 16ms timeout before removing post and potentially freeing `post.body`
-    NSTimeInterval timeout = 0.16;
-    auto block = ^(NSTimer* timer) {
-      dispatch_async(dispatch_get_main_queue(), ^{
-        self.bridge.core->removePost(postId);
-      });
-    };
-
-    [NSTimer timerWithTimeInterval: timeout repeats: NO block: block ];
-
     return;
   }
 
@@ -587,13 +597,15 @@
 
   SSC::Post post;
   post.id = SSC::rand64();
-  post.body = (char*)characteristic.value.bytes;
-  post.length = (int)characteristic.value.length;
+  post.body = SSC::Buffer::copy(
+    (const char*)characteristic.value.bytes,
+    characteristic.value.length
+  );
 
   post.headers = SSC::format(R"MSG(
     content-type: application/octet-stream
     content-length: $i
-  )MSG", post.length);
+  )MSG", (int)post.body.size());
 
   SSC::String seq = "-1";
 
@@ -641,219 +653,44 @@
 }
 @end
 
-@implementation Bridge
-- (id) init {
-  self = [super init];
-  tasks = std::unique_ptr<SSC::Tasks>(new SSC::Tasks());
-  return self;
-}
-
-- (SSC::Task) getTask: (SSC::String) id {
-  std::lock_guard<std::recursive_mutex> guard(tasksMutex);
-  if (tasks->find(id) == tasks->end()) return SSC::Task{};
-  return tasks->at(id);
-}
-
-- (bool) hasTask: (SSC::String) id {
-  std::lock_guard<std::recursive_mutex> guard(tasksMutex);
-  if (id.size() == 0) return false;
-  return tasks->find(id) != tasks->end();
-}
-
-- (void) removeTask: (SSC::String) id {
-  std::lock_guard<std::recursive_mutex> guard(tasksMutex);
-  if (tasks->find(id) == tasks->end()) return;
-  tasks->erase(id);
-}
-
-- (void) putTask: (SSC::String) id task: (SSC::Task) task {
-  std::lock_guard<std::recursive_mutex> guard(tasksMutex);
-  tasks->insert_or_assign(id, task);
-}
-
-- (void) setBluetooth: (SSCBluetoothDelegate*)bd {
-  _bluetooth = bd;
-  [_bluetooth initBluetooth];
-  _bluetooth.bridge = self;
-}
-
-- (void) initNetworkStatusObserver {
-  dispatch_queue_attr_t attrs = dispatch_queue_attr_make_with_qos_class(
-    DISPATCH_QUEUE_SERIAL,
-    QOS_CLASS_UTILITY,
-    DISPATCH_QUEUE_PRIORITY_DEFAULT
-  );
-
-  self.monitorQueue = dispatch_queue_create("co.socketsupply.queue.network-monitor", attrs);
-
-  // self.monitor = nw_path_monitor_create_with_type(nw_interface_type_wifi);
-  self.monitor = nw_path_monitor_create();
-  nw_path_monitor_set_queue(self.monitor, self.monitorQueue);
-  nw_path_monitor_set_update_handler(self.monitor, ^(nw_path_t path) {
-    nw_path_status_t status = nw_path_get_status(path);
-
-    SSC::String name;
-    SSC::String message;
-
-    switch (status) {
-      case nw_path_status_invalid: {
-        name = "offline";
-        message = "Network path is invalid";
-        break;
-      }
-      case nw_path_status_satisfied: {
-        name = "online";
-        message = "Network is usable";
-        break;
-      }
-      case nw_path_status_satisfiable: {
-        name = "online";
-        message = "Network may be usable";
-        break;
-      }
-      case nw_path_status_unsatisfied: {
-        name = "offline";
-        message = "Network is not usable";
-        break;
-      }
-    }
-
-    dispatch_async(dispatch_get_main_queue(), ^{
-      [self emit: name msg: SSC::format(R"JSON({
-        "message": "$S"
-      })JSON", message)];
-    });
-  });
-
-  nw_path_monitor_start(self.monitor);
-}
-
-- (void) setWebview: (SSCBridgedWebView*)wv {
-  _webview = wv;
-}
-
-- (void) setCore: (SSC::Core*)core; {
-  _core = core;
-}
-
-- (void) emit: (SSC::String)name msg: (SSC::String)msg {
-  msg = SSC::getEmitToRenderProcessJavaScript(name, SSC::encodeURIComponent(msg));
-  NSString* script = [NSString stringWithUTF8String: msg.c_str()];
-  [self.webview evaluateJavaScript: script completionHandler: nil];
-}
-
-- (void) send: (SSC::String)seq msg: (SSC::String)msg post: (SSC::Post)post {
-  if (seq != "-1" && [self hasTask: seq]) {
-    auto task = [self getTask: seq];
-    [self removeTask: seq];
-
-    #if !__has_feature(objc_arc)
-    [task retain];
-    #endif
-
-    dispatch_async(dispatch_get_main_queue(), ^{
-      NSMutableDictionary* httpHeaders = [[NSMutableDictionary alloc] init];
-      auto length = post.body ? post.length : msg.size();
-
-      httpHeaders[@"access-control-allow-origin"] = @"*";
-      httpHeaders[@"access-control-allow-methods"] = @"*";
-      httpHeaders[@"content-length"] = [@(length) stringValue];
-
-      NSHTTPURLResponse *httpResponse = [[NSHTTPURLResponse alloc]
-         initWithURL: task.request.URL
-          statusCode: 200
-         HTTPVersion: @"HTTP/1.1"
-        headerFields: httpHeaders
-      ];
-
-      [task didReceiveResponse: httpResponse];
-
-      if (post.body) {
-        NSData *data = [NSData dataWithBytes: post.body length: post.length];
-        [task didReceiveData: data];
-      } else if (msg.size() > 0) {
-        NSString* str = [NSString stringWithUTF8String: msg.c_str()];
-        NSData *data = [str dataUsingEncoding: NSUTF8StringEncoding];
-        [task didReceiveData: data];
-      }
-
-      [task didFinish];
-      #if !__has_feature(objc_arc)
-      [httpHeaders release];
-      [httpResponse release];
-      #endif
-    });
-    return;
-  }
-
-  if (post.body || seq == "-1") {
-    dispatch_async(dispatch_get_main_queue(), ^{
-      auto src = self.core->createPost(seq, msg, post);
-      NSString* script = [NSString stringWithUTF8String: src.c_str()];
-      [self.webview evaluateJavaScript: script completionHandler: nil];
-    });
-    return;
-  }
-
-  if (seq != "-1" && seq.size() > 0) { // this had a sequence, we need to try to resolve it.
-    msg = SSC::getResolveToRenderProcessJavaScript(seq, "0", SSC::encodeURIComponent(msg));
-  }
-
-  if (msg.size() > 0) {
-    dispatch_async(dispatch_get_main_queue(), ^{
-      NSString* script = [NSString stringWithUTF8String: msg.c_str()];
-      [self.webview evaluateJavaScript: script completionHandler: nil];
-    });
-  }
-}
+using BridgeCommandRouter = SSC::CommandRouter<Bridge*, SSC::Parse, SSC::String, char*, size_t>;
 
--(void)userNotificationCenter:(UNUserNotificationCenter *)center willPresentNotification:(UNNotification *)notification withCompletionHandler:(void (^)(UNNotificationPresentationOptions options))completionHandler {
-  completionHandler(UNNotificationPresentationOptionList | UNNotificationPresentationOptionBanner);
-}
+static BridgeCommandRouter& getCommandRouter ();
 
-// returns true if routable (regardless of success)
-- (bool) route: (SSC::String)msg buf: (char*)buf bufsize: (size_t)bufsize{
+static BridgeCommandRouter* createCommandRouter () {
   using namespace SSC;
 
-  if (msg.find("ipc://") != 0) return false;
-
-  Parse cmd(msg);
-  auto seq = cmd.get("seq");
-  // NSLog(@"Route<%s> - [%s:%i]", cmd.name.c_str(), buf, (int)bufsize);
-
-  uint64_t peerId = 0;
+  auto router = new BridgeCommandRouter();
 
   /// ipc bluetooth-start
   /// @param serviceId String
   ///
-  if (cmd.name == "bluetooth-start" || cmd.name == "bluetooth.start") {
+  router->on(COMMAND_BLUETOOTH_START, [](Bridge* bridge, auto cmd, auto seq, auto buf, auto bufsize) {
     dispatch_async(queue, ^{
-      [self.bluetooth startService: seq sid: cmd.get("serviceId")];
+      [bridge.bluetooth startService: seq sid: cmd.get("serviceId")];
     });
     return true;
-  }
+  });
 
-  if (cmd.name == "bluetooth-subscribe" || cmd.name == "bluetooth.subscribe") {
+  router->on(COMMAND_BLUETOOTH_SUBSCRIBE, [](Bridge* bridge, auto cmd, auto seq, auto buf, auto bufsize) {
     auto cid = cmd.get("characteristicId");
     auto sid = cmd.get("serviceId");
-    auto seq = cmd.get("seq");
 
     dispatch_async(queue, ^{
-      [self.bluetooth subscribeCharacteristic: seq sid: sid cid: cid];
+      [bridge.bluetooth subscribeCharacteristic: seq sid: sid cid: cid];
     });
     return true;
-  }
+  });
 
-  if (cmd.name == "bluetooth-publish" || cmd.name == "bluetooth.publish") {
+  router->on(COMMAND_BLUETOOTH_PUBLISH, [](Bridge* bridge, auto cmd, auto seq, auto buf, auto bufsize) {
     auto sid = cmd.get("serviceId");
     auto cid = cmd.get("characteristicId");
-    auto seq = cmd.get("seq");
 
     if (sid.size() != 36) {
       auto msg = SSC::format(R"MSG({ "err": { "message": "invalid serviceId" } })MSG");
 
       dispatch_async(queue, ^{
-        [self send: seq msg: msg post: Post{}];
+        [bridge send: seq msg: msg post: Post{}];
       });
       return true;
     }
@@ -861,7 +698,7 @@
     if (sid.size() != 36) {
       auto msg = SSC::format(R"MSG({ "err": { "message": "invalid characteristicId" } })MSG");
       dispatch_async(queue, ^{
-        [self send: seq msg: msg post: Post{}];
+        [bridge send: seq msg: msg post: Post{}];
       });
       return true;
     }
@@ -870,18 +707,18 @@
     int len;
 
     if (buf != nullptr) {
-      len = std::stoi(cmd.get("length"));
+      len = cmd.getInt("length").value_or(0);
       value = buf;
     } else {
       value = cmd.get("value").data();
       len = (int) cmd.get("value").size();
     }
 
-    [self.bluetooth publishCharacteristic: seq buf: value len: len sid: sid cid: cid];
+    [bridge.bluetooth publishCharacteristic: seq buf: value len: len sid: sid cid: cid];
     return true;
-  }
+  });
 
-  if (cmd.name == "notify") {
+  router->on(COMMAND_NOTIFY, [](Bridge* bridge, auto cmd, auto seq, auto buf, auto bufsize) {
     UNMutableNotificationContent* content = [[UNMutableNotificationContent alloc] init];
     content.body = [NSString stringWithUTF8String: cmd.get("body").c_str()];
     content.title = [NSString stringWithUTF8String: cmd.get("title").c_str()];
@@ -905,10 +742,10 @@
       }
     }];
     return true;
-  }
+  });
 
-  if (cmd.name == "log") {
-    auto value = decodeURIComponent(cmd.get("value"));
+  router->on(COMMAND_LOG, [](Bridge* bridge, auto cmd, auto seq, auto buf, auto bufsize) {
+    auto value = cmd.getDecoded("value");
     if (platform.os == "mac" || platform.os == "ios") {
       printf("%s\n", value.c_str());
       NSLog(@"DEBUG - %s\n", value.c_str());
@@ -916,38 +753,36 @@
       DebugLog(@"%s", value.c_str());
     }
     return true;
-  }
+  });
 
-  if (cmd.name == "event") {
-    auto event = decodeURIComponent(cmd.get("value"));
-    auto data = decodeURIComponent(cmd.get("data"));
-    auto seq = cmd.get("seq");
+  router->on(COMMAND_EVENT, [](Bridge* bridge, auto cmd, auto seq, auto buf, auto bufsize) {
+    auto event = cmd.getDecoded("value");
+    auto data = cmd.getDecoded("data");
 
     dispatch_async(queue, ^{
-      self.core->handleEvent(seq, event, data, [=](auto seq, auto msg, auto post) {
-        [self send: seq msg: msg post: Post{}];
+      bridge.core->handleEvent(seq, event, data, [=](auto seq, auto msg, auto post) {
+        [bridge send: seq msg: msg post: Post{}];
       });
     });
     return true;
-  }
+  });
 
-  if (cmd.name == "window.eval") {
-    SSC::String value = decodeURIComponent(cmd.get("value"));
-    auto seq = cmd.get("seq");
+  router->on(COMMAND_WINDOW_EVAL, [](Bridge* bridge, auto cmd, auto seq, auto buf, auto bufsize) {
+    SSC::String value = cmd.getDecoded("value");
 
     NSString* script = [NSString stringWithUTF8String: value.c_str()];
     dispatch_async(dispatch_get_main_queue(), ^{
-      [self.webview evaluateJavaScript: script completionHandler: ^(id result, NSError *error) {
+      [bridge.webview evaluateJavaScript: script completionHandler: ^(id result, NSError *error) {
         if (result) {
           auto msg = SSC::String([[NSString stringWithFormat:@"%@", result] UTF8String]);
-          [self send: seq msg: msg post: Post{}];
+          [bridge send: seq msg: msg post: Post{}];
         } else if (error) {
           auto exception = error.userInfo[@"WKJavaScriptExceptionMessage"];
           auto message = [[NSString stringWithFormat:@"%@", exception] UTF8String];
           auto err = encodeURIComponent(SSC::String(message));
 
           if (err == "(null)") {
-            [self send: seq msg: "null" post: Post{}];
+            [bridge send: seq msg: "null" post: Post{}];
             return;
           }
 
@@ -956,276 +791,386 @@
             err
           );
 
-          [self send: seq msg: msg post: Post{}];
+          [bridge send: seq msg: msg post: Post{}];
         } else {
-          [self send: seq msg: "undefined" post: Post{}];
+          [bridge send: seq msg: "undefined" post: Post{}];
         }
       }];
     });
 
     return true;
-  }
+  });
 
-  if (cmd.name == "getFSConstants" || cmd.name == "fs.constants") {
+  router->on(COMMAND_FS_CONSTANTS, [](Bridge* bridge, auto cmd, auto seq, auto buf, auto bufsize) {
     dispatch_async(queue, ^{
-      auto constants = self.core->getFSConstants();
-      [self send: seq msg: constants post: Post{}];
+      auto constants = bridge.core->getFSConstants();
+      [bridge send: seq msg: constants post: Post{}];
     });
     return true;
-  }
+  });
 
-  if (cmd.name == "fsGetOpenDescriptors" || cmd.name == "fs.getOpenDescriptors") {
+  router->on(COMMAND_FS_GET_OPEN_DESCRIPTORS, [](Bridge* bridge, auto cmd, auto seq, auto buf, auto bufsize) {
     dispatch_async(queue, ^{
-      self.core->fsGetOpenDescriptors(seq, [=](auto seq, auto msg, auto post) {
-        [self send: seq msg: msg post: post];
+      bridge.core->fsGetOpenDescriptors(seq, [=](auto seq, auto msg, auto post) {
+        [bridge send: seq msg: msg post: post];
       });
     });
     return true;
-  }
+  });
 
-  if (cmd.name == "fsRetainOpenDescriptor" || cmd.name == "fs.retainOpenDescriptor") {
-    auto id = std::stoull(cmd.get("id"));
+  router->on(COMMAND_FS_RETAIN_OPEN_DESCRIPTOR, [](Bridge* bridge, auto cmd, auto seq, auto buf, auto bufsize) {
+    auto id = cmd.getU64("id").value_or(0);
 
     dispatch_async(queue, ^{
-      self.core->fsRetainOpenDescriptor(seq, id, [=](auto seq, auto msg, auto post) {
-        [self send: seq msg: msg post: post];
+      bridge.core->fsRetainOpenDescriptor(seq, id, [=](auto seq, auto msg, auto post) {
+        [bridge send: seq msg: msg post: post];
       });
     });
     return true;
-  }
+  });
 
-  if (cmd.name == "fsRmdir" || cmd.name == "fs.rmdir") {
-    auto path = decodeURIComponent(cmd.get("path"));
+  router->on(COMMAND_FS_RMDIR, [](Bridge* bridge, auto cmd, auto seq, auto buf, auto bufsize) {
+    auto path = cmd.getDecoded("path");
 
     dispatch_async(queue, ^{
-      self.core->fsRmdir(seq, path, [=](auto seq, auto msg, auto post) {
-        [self send: seq msg: msg post: post];
+      bridge.core->fsRmdir(seq, path, [=](auto seq, auto msg, auto post) {
+        [bridge send: seq msg: msg post: post];
       });
     });
     return true;
-  }
+  });
 
-  if (cmd.name == "fsAccess" || cmd.name == "fs.access") {
-    auto path = decodeURIComponent(cmd.get("path"));
-    auto mode = std::stoi(cmd.get("mode"));
+  router->on(COMMAND_FS_ACCESS, [](Bridge* bridge, auto cmd, auto seq, auto buf, auto bufsize) {
+    auto path = cmd.getDecoded("path");
+    auto mode = cmd.getInt("mode").value_or(0);
 
     dispatch_async(queue, ^{
-      self.core->fsAccess(seq, path, mode, [=](auto seq, auto msg, auto post) {
-        [self send: seq msg: msg post: post];
+      bridge.core->fsAccess(seq, path, mode, [=](auto seq, auto msg, auto post) {
+        [bridge send: seq msg: msg post: post];
       });
     });
     return true;
-  }
+  });
 
-  if (cmd.name == "fsOpen" || cmd.name == "fs.open") {
-    auto cid = std::stoull(cmd.get("id"));
-    auto path = decodeURIComponent(cmd.get("path"));
-    auto flags = std::stoi(cmd.get("flags"));
-    auto mode = std::stoi(cmd.get("mode"));
+  router->on(COMMAND_FS_OPEN, [](Bridge* bridge, auto cmd, auto seq, auto buf, auto bufsize) {
+    auto cid = cmd.getU64("id").value_or(0);
+    auto path = cmd.getDecoded("path");
+    auto flags = cmd.getInt("flags").value_or(0);
+    auto mode = cmd.getInt("mode").value_or(0);
 
     dispatch_async(queue, ^{
-      self.core->fsOpen(seq, cid, path, flags, mode, [=](auto seq, auto msg, auto post) {
-        [self send: seq msg: msg post: post];
+      bridge.core->fsOpen(seq, cid, path, flags, mode, [=](auto seq, auto msg, auto post) {
+        [bridge send: seq msg: msg post: post];
       });
     });
     return true;
-  }
+  });
 
-  if (cmd.name == "fsClose" || cmd.name == "fs.close") {
-    auto id = std::stoull(cmd.get("id"));
+  router->on(COMMAND_FS_CLOSE, [](Bridge* bridge, auto cmd, auto seq, auto buf, auto bufsize) {
+    auto id = cmd.getU64("id").value_or(0);
 
     dispatch_async(queue, ^{
-      self.core->fsClose(seq, id, [=](auto seq, auto msg, auto post) {
-        [self send: seq msg: msg post: post];
+      bridge.core->fsClose(seq, id, [=](auto seq, auto msg, auto post) {
+        [bridge send: seq msg: msg post: post];
       });
     });
     return true;
-  }
+  });
 
-  if (cmd.name == "fsCloseOpenDescriptor" || cmd.name == "fs.closeOpenDescriptor") {
-    auto id = std::stoull(cmd.get("id"));
+  router->on(COMMAND_FS_CLOSE_OPEN_DESCRIPTOR, [](Bridge* bridge, auto cmd, auto seq, auto buf, auto bufsize) {
+    auto id = cmd.getU64("id").value_or(0);
 
     dispatch_async(queue, ^{
-      self.core->fsCloseOpenDescriptor(seq, id, [=](auto seq, auto msg, auto post) {
-        [self send: seq msg: msg post: post];
+      bridge.core->fsCloseOpenDescriptor(seq, id, [=](auto seq, auto msg, auto post) {
+        [bridge send: seq msg: msg post: post];
       });
     });
     return true;
-  }
+  });
 
-  if (cmd.name == "fsCloseOpenDescriptors" || cmd.name == "fs.closeOpenDescriptors") {
+  router->on(COMMAND_FS_CLOSE_OPEN_DESCRIPTORS, [](Bridge* bridge, auto cmd, auto seq, auto buf, auto bufsize) {
     auto preserveRetained = cmd.get("retain") != "false";
     dispatch_async(queue, ^{
-      self.core->fsCloseOpenDescriptors(seq, preserveRetained, [=](auto seq, auto msg, auto post) {
-        [self send: seq msg: msg post: post];
+      bridge.core->fsCloseOpenDescriptors(seq, preserveRetained, [=](auto seq, auto msg, auto post) {
+        [bridge send: seq msg: msg post: post];
       });
     });
     return true;
-  }
+  });
 
-  if (cmd.name == "fsRead" || cmd.name == "fs.read") {
-    auto id = std::stoull(cmd.get("id"));
-    auto size = std::stoi(cmd.get("size"));
-    auto offset = std::stoi(cmd.get("offset"));
+  router->on(COMMAND_FS_READ, [](Bridge* bridge, auto cmd, auto seq, auto buf, auto bufsize) {
+    auto id = cmd.getU64("id").value_or(0);
+    auto size = cmd.getInt("size").value_or(0);
+    auto offset = cmd.getInt("offset").value_or(0);
 
     dispatch_async(queue, ^{
-      self.core->fsRead(seq, id, size, offset, [=](auto seq, auto msg, auto post) {
-        [self send: seq msg: msg post: post];
+      bridge.core->fsRead(seq, id, size, offset, [=](auto seq, auto msg, auto post) {
+        [bridge send: seq msg: msg post: post];
       });
     });
     return true;
-  }
+  });
 
-  if (cmd.name == "fsWrite" || cmd.name == "fs.write") {
-    auto id = std::stoull(cmd.get("id"));
-    auto offset = std::stoull(cmd.get("offset"));
-    auto data = SSC::String(buf, bufsize);
+  router->on(COMMAND_FS_READ_STREAM, [](Bridge* bridge, auto cmd, auto seq, auto buf, auto bufsize) {
+    auto id = cmd.getU64("id").value_or(0);
+    auto offset = cmd.getI64("offset").value_or(0);
 
     dispatch_async(queue, ^{
-      self.core->fsWrite(seq, id, data, offset, [=](auto seq, auto msg, auto post) {
-        [self send: seq msg: msg post: post];
+      bridge.core->fsReadStream(seq, id, offset, [=](auto seq, auto msg, auto post) {
+        [bridge send: seq msg: msg post: post];
       });
     });
     return true;
-  }
+  });
 
-  if (cmd.name == "fsStat" || cmd.name == "fs.stat") {
-    auto path = decodeURIComponent(cmd.get("path"));
+  router->on(COMMAND_FS_WRITE, [](Bridge* bridge, auto cmd, auto seq, auto buf, auto bufsize) {
+    auto id = cmd.getU64("id").value_or(0);
+    auto offset = cmd.getU64("offset").value_or(0);
+    auto data = SSC::String(buf, bufsize);
 
     dispatch_async(queue, ^{
-      self.core->fsStat(seq, path, [=](auto seq, auto msg, auto post) {
-        [self send: seq msg: msg post: post];
+      bridge.core->fsWrite(seq, id, data, offset, [=](auto seq, auto msg, auto post) {
+        [bridge send: seq msg: msg post: post];
       });
     });
     return true;
-  }
+  });
 
-  if (cmd.name == "fsFStat" || cmd.name == "fs.fstat") {
-    auto id = std::stoull(cmd.get("id"));
+  router->on(COMMAND_FS_READV, [](Bridge* bridge, auto cmd, auto seq, auto buf, auto bufsize) {
+    auto id = cmd.getU64("id").value_or(0);
+    auto segments = getFSSegments(cmd.getI64List("offsets"), cmd.getI64List("sizes"));
+
+    if (!segments) {
+      auto err = SSC::format(R"MSG({
+        "err": {
+          "type": "InternalError",
+          "message": "'offsets' and 'sizes' must list the same number of non-negative integers"
+        }
+      })MSG");
+
+      [bridge send: seq msg: err post: Post{}];
+      return true;
+    }
 
     dispatch_async(queue, ^{
-      self.core->fsFStat(seq, id, [=](auto seq, auto msg, auto post) {
-        [self send: seq msg: msg post: post];
+      bridge.core->fsReadv(seq, id, *segments, [=](auto seq, auto msg, auto post) {
+        [bridge send: seq msg: msg post: post];
       });
     });
     return true;
-  }
+  });
+
+  router->on(COMMAND_FS_WRITEV, [](Bridge* bridge, auto cmd, auto seq, auto buf, auto bufsize) {
+    auto id = cmd.getU64("id").value_or(0);
+    auto offset = cmd.getI64("offset").value_or(-1);
+    auto sizes = getFSWriteSizes(cmd.getI64List("sizes"));
+    auto data = Buffer::copy(buf, bufsize);
+
+    if (!sizes) {
+      auto err = SSC::format(R"MSG({
+        "err": {
+          "type": "InternalError",
+          "message": "'sizes' must list non-negative integers"
+        }
+      })MSG");
+
+      [bridge send: seq msg: err post: Post{}];
+      return true;
+    }
 
-  if (cmd.name == "fsUnlink" || cmd.name == "fs.unlink") {
-    auto path = decodeURIComponent(cmd.get("path"));
+    // no `sizes` writes the whole body as one buffer
+    if (sizes->empty()) {
+      sizes->push_back(data.size());
+    }
 
     dispatch_async(queue, ^{
-      self.core->fsUnlink(seq, path, [=](auto seq, auto msg, auto post) {
-        [self send: seq msg: msg post: post];
+      bridge.core->fsWritev(seq, id, data, *sizes, offset, [=](auto seq, auto msg, auto post) {
+        [bridge send: seq msg: msg post: post];
       });
     });
     return true;
-  }
+  });
 
-  if (cmd.name == "fsRename" || cmd.name == "fs.rename") {
-    auto src = decodeURIComponent(cmd.get("src"));
-    auto dst = decodeURIComponent(cmd.get("dst"));
+  router->on(COMMAND_FS_STAT, [](Bridge* bridge, auto cmd, auto seq, auto buf, auto bufsize) {
+    auto path = cmd.getDecoded("path");
 
     dispatch_async(queue, ^{
-      self.core->fsRename(seq, src, dst, [=](auto seq, auto msg, auto post) {
-        [self send: seq msg: msg post: post];
+      bridge.core->fsStat(seq, path, [=](auto seq, auto msg, auto post) {
+        [bridge send: seq msg: msg post: post];
       });
     });
     return true;
-  }
+  });
 
-  if (cmd.name == "fsCopyFile" || cmd.name == "fs.copyFile") {
-    auto flags = std::stoi(cmd.get("flags", "0"));
-    auto src = decodeURIComponent(cmd.get("src"));
-    auto dst = decodeURIComponent(cmd.get("dst"));
+  router->on(COMMAND_FS_FSTAT, [](Bridge* bridge, auto cmd, auto seq, auto buf, auto bufsize) {
+    auto id = cmd.getU64("id").value_or(0);
 
     dispatch_async(queue, ^{
-      self.core->fsCopyFile(seq, src, dst, flags, [=](auto seq, auto msg, auto post) {
-        [self send: seq msg: msg post: post];
+      bridge.core->fsFStat(seq, id, [=](auto seq, auto msg, auto post) {
+        [bridge send: seq msg: msg post: post];
       });
     });
     return true;
-  }
+  });
 
-  if (cmd.name == "fsMkdir" || cmd.name == "fs.mkdir") {
-    auto path = decodeURIComponent(cmd.get("path"));
-    auto mode = std::stoi(cmd.get("mode"));
+  router->on(COMMAND_FS_UNLINK, [](Bridge* bridge, auto cmd, auto seq, auto buf, auto bufsize) {
+    auto path = cmd.getDecoded("path");
 
     dispatch_async(queue, ^{
-      self.core->fsMkdir(seq, path, mode, [=](auto seq, auto msg, auto post) {
-        [self send: seq msg: msg post: post];
+      bridge.core->fsUnlink(seq, path, [=](auto seq, auto msg, auto post) {
+        [bridge send: seq msg: msg post: post];
       });
     });
     return true;
-  }
+  });
 
-  if (cmd.name == "fsOpendir" || cmd.name == "fs.opendir") {
-    auto id = std::stoull(cmd.get("id"));
-    auto path = decodeURIComponent(cmd.get("path"));
+  router->on(COMMAND_FS_RENAME, [](Bridge* bridge, auto cmd, auto seq, auto buf, auto bufsize) {
+    auto src = cmd.getDecoded("src");
+    auto dst = cmd.getDecoded("dst");
 
     dispatch_async(queue, ^{
-      self.core->fsOpendir(seq, id, path, [=](auto seq, auto msg, auto post) {
-        [self send: seq msg: msg post: post];
+      bridge.core->fsRename(seq, src, dst, [=](auto seq, auto msg, auto post) {
+        [bridge send: seq msg: msg post: post];
       });
     });
     return true;
-  }
+  });
 
-  if (cmd.name == "fsReaddir" || cmd.name == "fs.readdir") {
-    auto id = std::stoull(cmd.get("id"));
-    auto entries = std::stoi(cmd.get("entries", "256"));
+  router->on(COMMAND_FS_COPY_FILE, [](Bridge* bridge, auto cmd, auto seq, auto buf, auto bufsize) {
+    auto flags = cmd.getInt("flags").value_or(0);
+    auto src = cmd.getDecoded("src");
+    auto dst = cmd.getDecoded("dst");
 
     dispatch_async(queue, ^{
-      self.core->fsReaddir(seq, id, entries, [=](auto seq, auto msg, auto post) {
-        [self send: seq msg: msg post: post];
+      bridge.core->fsCopyFile(seq, src, dst, flags, [=](auto seq, auto msg, auto post) {
+        [bridge send: seq msg: msg post: post];
       });
     });
     return true;
-  }
+  });
 
-  if (cmd.name == "fsClosedir" || cmd.name == "fs.closedir") {
-    auto id = std::stoull(cmd.get("id"));
+  router->on(COMMAND_FS_MKDIR, [](Bridge* bridge, auto cmd, auto seq, auto buf, auto bufsize) {
+    auto path = cmd.getDecoded("path");
+    auto mode = cmd.getInt("mode").value_or(0);
 
     dispatch_async(queue, ^{
-      self.core->fsClosedir(seq, id, [=](auto seq, auto msg, auto post) {
-        [self send: seq msg: msg post: post];
+      bridge.core->fsMkdir(seq, path, mode, [=](auto seq, auto msg, auto post) {
+        [bridge send: seq msg: msg post: post];
       });
     });
     return true;
-  }
+  });
 
-  // TODO this is a generalization that doesnt work
-  if (cmd.get("id").size() != 0) {
-    try {
-      peerId = std::stoull(cmd.get("id"));
-    } catch (...) {
-      auto msg = SSC::format(R"MSG({
-        "err": { "message": "invalid peerId" }
-      })MSG");
-      [self send: seq msg: msg post: Post{}];
-      return true;
-    }
-  }
+  router->on(COMMAND_FS_OPENDIR, [](Bridge* bridge, auto cmd, auto seq, auto buf, auto bufsize) {
+    auto id = cmd.getU64("id").value_or(0);
+    auto path = cmd.getDecoded("path");
+
+    dispatch_async(queue, ^{
+      bridge.core->fsOpendir(seq, id, path, [=](auto seq, auto msg, auto post) {
+        [bridge send: seq msg: msg post: post];
+      });
+    });
+    return true;
+  });
+
+  router->on(COMMAND_FS_READDIR, [](Bridge* bridge, auto cmd, auto seq, auto buf, auto bufsize) {
+    auto id = cmd.getU64("id").value_or(0);
+    auto entries = cmd.getInt("entries").value_or(256);
+
+    dispatch_async(queue, ^{
+      bridge.core->fsReaddir(seq, id, entries, [=](auto seq, auto msg, auto post) {
+        [bridge send: seq msg: msg post: post];
+      });
+    });
+    return true;
+  });
 
-  if (cmd.name == "external" || cmd.name == "open.external") {
-    NSString *url = [NSString stringWithUTF8String:SSC::decodeURIComponent(cmd.get("value")).c_str()];
+  router->on(COMMAND_FS_CLOSEDIR, [](Bridge* bridge, auto cmd, auto seq, auto buf, auto bufsize) {
+    auto id = cmd.getU64("id").value_or(0);
+
+    dispatch_async(queue, ^{
+      bridge.core->fsClosedir(seq, id, [=](auto seq, auto msg, auto post) {
+        [bridge send: seq msg: msg post: post];
+      });
+    });
+    return true;
+  });
+
+  router->on(COMMAND_OPEN_EXTERNAL, [](Bridge* bridge, auto cmd, auto seq, auto buf, auto bufsize) {
+    NSString *url = [NSString stringWithUTF8String:cmd.getDecoded("value").c_str()];
     #if MACOS == 1
       [[NSWorkspace sharedWorkspace] openURL:[NSURL URLWithString: url]];
     #else
       [[UIApplication sharedApplication] openURL: [NSURL URLWithString:url] options: @{} completionHandler: nil];
     #endif
     return true;
-  }
+  });
 
-  if (cmd.name == "getNetworkInterfaces" || cmd.name == "os.networkInterfaces") {
+  router->on(COMMAND_OS_NETWORK_INTERFACES, [](Bridge* bridge, auto cmd, auto seq, auto buf, auto bufsize) {
     dispatch_async(queue, ^{
-      auto msg = self.core->getNetworkInterfaces();
-      [self send: seq msg: msg post: Post{}];
+      auto msg = bridge.core->getNetworkInterfaces();
+      [bridge send: seq msg: msg post: Post{}];
     });
     return true;
-  }
+  });
+
+  router->on(COMMAND_TIMER_SET, [](Bridge* bridge, auto cmd, auto seq, auto buf, auto bufsize) {
+    uint64_t id;
+    uint64_t timeout;
+    uint64_t interval;
 
-  if (cmd.name == "cwd" || cmd.name == "process.cwd") {
+    auto parsedId = cmd.getU64("id");
+    auto parsedTimeout = cmd.getU64("timeout");
+
+    if (!parsedId || !parsedTimeout) {
+      auto msg = SSC::format(R"({ "err": { "message": "properties 'id' and 'timeout' required" } })");
+      [bridge send: seq msg: msg post: Post{}];
+      return true;
+    }
+
+    id = *parsedId;
+    timeout = *parsedTimeout;
+    interval = cmd.getU64("interval").value_or(0);
+
+    bridge.core->timerSet(seq, id, timeout, interval, [=](auto seq, auto msg, auto post) {
+      [bridge send: seq msg: msg post: post];
+    });
+
+    return true;
+  });
+
+  router->on(COMMAND_TIMER_CLEAR, [](Bridge* bridge, auto cmd, auto seq, auto buf, auto bufsize) {
+    uint64_t id;
+
+    if (auto parsed = cmd.getU64("id")) {
+      id = *parsed;
+    } else {
+      auto msg = SSC::format(R"({ "err": { "message": "property 'id' required" } })");
+      [bridge send: seq msg: msg post: Post{}];
+      return true;
+    }
+
+    bridge.core->timerClear(seq, id, [=](auto seq, auto msg, auto post) {
+      [bridge send: seq msg: msg post: post];
+    });
+
+    return true;
+  });
+
+  router->on(COMMAND_LOOP_STATS, [](Bridge* bridge, auto cmd, auto seq, auto buf, auto bufsize) {
+    // read directly so a stalled loop is still observable
+    auto msg = bridge.core->getEventLoopStats();
+    [bridge send: seq msg: msg post: Post{}];
+    return true;
+  });
+
+  router->on(COMMAND_POSTS_STATS, [](Bridge* bridge, auto cmd, auto seq, auto buf, auto bufsize) {
+    auto msg = bridge.core->getPostsStats();
+    [bridge send: seq msg: msg post: Post{}];
+    return true;
+  });
+
+  router->on(COMMAND_PROCESS_CWD, [](Bridge* bridge, auto cmd, auto seq, auto buf, auto bufsize) {
     NSFileManager *fileManager;
     NSString *currentDirectoryPath;
 
@@ -1238,55 +1183,55 @@
         "source": "process.cwd",
         "data": "$S"
       })JSON", SSC::String([cwd UTF8String]));
-      [self send: seq msg: msg post: Post{}];
+      [bridge send: seq msg: msg post: Post{}];
     });
     return true;
-  }
+  });
 
-  if (cmd.name == "getPlatformOS" || cmd.name == "os.platform") {
+  router->on(COMMAND_OS_PLATFORM, [](Bridge* bridge, auto cmd, auto seq, auto buf, auto bufsize) {
     dispatch_async(queue, ^{
       auto msg = SSC::format(R"JSON({
         "source": "os.platform",
         "data": "$S"
       })JSON", SSC::platform.os);
 
-      [self send: seq msg: msg post: Post{}];
+      [bridge send: seq msg: msg post: Post{}];
     });
     return true;
-  }
+  });
 
-  if (cmd.name == "getPlatformType" || cmd.name == "os.type") {
+  router->on(COMMAND_OS_TYPE, [](Bridge* bridge, auto cmd, auto seq, auto buf, auto bufsize) {
     dispatch_async(queue, ^{
       auto msg = SSC::format(R"JSON({
         "source": "os.type",
         "data": "$S"
       })JSON", SSC::platform.os);
 
-      [self send: seq msg: msg post: Post{}];
+      [bridge send: seq msg: msg post: Post{}];
     });
     return true;
-  }
+  });
 
-  if (cmd.name == "getPlatformArch" || cmd.name == "os.arch") {
+  router->on(COMMAND_OS_ARCH, [](Bridge* bridge, auto cmd, auto seq, auto buf, auto bufsize) {
     dispatch_async(queue, ^{
       auto msg = SSC::format(R"JSON({
         "source": "os.arch",
         "data": "$S"
       })JSON", SSC::platform.arch);
 
-      [self send: seq msg: msg post: Post{}];
+      [bridge send: seq msg: msg post: Post{}];
     });
     return true;
-  }
+  });
 
-  if (cmd.name == "bufferSize") {
-    auto buffer = std::stoi(cmd.get("buffer", "0"));
-    auto size = std::stoi(cmd.get("size", "0"));
+  router->on(COMMAND_BUFFER_SIZE, [](Bridge* bridge, auto cmd, auto seq, auto buf, auto bufsize) {
+    auto buffer = cmd.getInt("buffer").value_or(0);
+    auto size = cmd.getInt("size").value_or(0);
     uint64_t id = 0ll;
 
-    try {
-      id = std::stoull(cmd.get("id"));
-    } catch (...) {
+    if (auto parsed = cmd.getU64("id")) {
+      id = *parsed;
+    } else {
       dispatch_async(queue, ^{
         auto err = SSC::format(R"MSG({
           "source": "bufferSize",
@@ -1296,31 +1241,31 @@
           }
         })MSG");
 
-        [self send: seq msg: err post: Post{}];
+        [bridge send: seq msg: err post: Post{}];
       });
       return true;
     }
 
     dispatch_async(queue, ^{
-      self.core->bufferSize(seq, id, size, buffer, [=](auto seq, auto msg, auto post) {
-        [self send: seq msg: msg post: post];
+      bridge.core->bufferSize(seq, id, size, buffer, [=](auto seq, auto msg, auto post) {
+        [bridge send: seq msg: msg post: post];
       });
     });
     return true;
-  }
+  });
 
-  if (cmd.name == "udpClose" || cmd.name == "udp.close" || cmd.name == "close") {
-    auto peerId = std::stoull(cmd.get("id"));
+  router->on(COMMAND_UDP_CLOSE, [](Bridge* bridge, auto cmd, auto seq, auto buf, auto bufsize) {
+    auto peerId = cmd.getU64("id").value_or(0);
 
     dispatch_async(queue, ^{
-      self.core->close(seq, peerId, [=](auto seq, auto msg, auto post) {
-        [self send: seq msg: msg post: post];
+      bridge.core->close(seq, peerId, [=](auto seq, auto msg, auto post) {
+        [bridge send: seq msg: msg post: post];
       });
     });
     return true;
-  }
+  });
 
-  if (cmd.name == "udpConnect" || cmd.name == "udp.connect") {
+  router->on(COMMAND_UDP_CONNECT, [](Bridge* bridge, auto cmd, auto seq, auto buf, auto bufsize) {
     auto strId = cmd.get("id");
     SSC::String err = "";
     uint64_t peerId = 0ll;
@@ -1330,22 +1275,18 @@
 
     if (strId.size() == 0) {
       err = "invalid peerId";
+    } else if (auto parsed = cmd.getU64("id")) {
+      peerId = *parsed;
     } else {
-      try {
-        peerId = std::stoull(cmd.get("id"));
-      } catch (...) {
-        err = "invalid peerId";
-      }
+      err = "invalid peerId";
     }
 
     if (strPort.size() == 0) {
       err = "invalid port";
+    } else if (auto parsed = cmd.getInt("port")) {
+      port = *parsed;
     } else {
-      try {
-        port = std::stoi(strPort);
-      } catch (...) {
-        err = "invalid port";
-      }
+      err = "invalid port";
     }
 
     if (port == 0) {
@@ -1359,7 +1300,7 @@
           "message": "$S"
         }
       })MSG", err);
-      [self send: seq msg: msg post: Post{}];
+      [bridge send: seq msg: msg post: Post{}];
       return true;
     }
 
@@ -1368,14 +1309,14 @@
     }
 
     dispatch_async(queue, ^{
-      self.core->udpConnect(seq, peerId, ip, port, [=](auto seq, auto msg, auto post) {
-        [self send: seq msg: msg post: post];
+      bridge.core->udpConnect(seq, peerId, ip, port, [=](auto seq, auto msg, auto post) {
+        [bridge send: seq msg: msg post: post];
       });
     });
     return true;
-  }
+  });
 
-  if (cmd.name == "udpDisconnect" || cmd.name == "udp.disconnect") {
+  router->on(COMMAND_UDP_DISCONNECT, [](Bridge* bridge, auto cmd, auto seq, auto buf, auto bufsize) {
     auto strId = cmd.get("id");
 
     if (strId.size() == 0) {
@@ -1387,22 +1328,22 @@
       })MSG");
 
       dispatch_async(queue, ^{
-        [self send: seq msg: msg post: Post{}];
+        [bridge send: seq msg: msg post: Post{}];
       });
       return true;
     }
 
-    auto peerId = std::stoull(strId);
+    auto peerId = cmd.getU64("id").value_or(0);
 
     dispatch_async(queue, ^{
-      self.core->udpDisconnect(seq, peerId, [=](auto seq, auto msg, auto post) {
-        [self send: seq msg: msg post: post];
+      bridge.core->udpDisconnect(seq, peerId, [=](auto seq, auto msg, auto post) {
+        [bridge send: seq msg: msg post: post];
       });
     });
     return true;
-  }
+  });
 
-  if (cmd.name == "udpGetPeerName" || cmd.name == "udp.getPeerName") {
+  router->on(COMMAND_UDP_GET_PEER_NAME, [](Bridge* bridge, auto cmd, auto seq, auto buf, auto bufsize) {
     auto strId = cmd.get("id");
 
     if (strId.size() == 0) {
@@ -1414,22 +1355,22 @@
       })MSG");
 
       dispatch_async(queue, ^{
-        [self send: seq msg: msg post: Post{}];
+        [bridge send: seq msg: msg post: Post{}];
       });
       return true;
     }
 
-    auto peerId = std::stoull(strId);
+    auto peerId = cmd.getU64("id").value_or(0);
 
     dispatch_async(queue, ^{
-      self.core->udpGetPeerName(seq, peerId, [=](auto seq, auto msg, auto post) {
-        [self send: seq msg: msg post: post];
+      bridge.core->udpGetPeerName(seq, peerId, [=](auto seq, auto msg, auto post) {
+        [bridge send: seq msg: msg post: post];
       });
     });
     return true;
-  }
+  });
 
-  if (cmd.name == "udpGetSockName" || cmd.name == "udp.getSockName") {
+  router->on(COMMAND_UDP_GET_SOCK_NAME, [](Bridge* bridge, auto cmd, auto seq, auto buf, auto bufsize) {
     auto strId = cmd.get("id");
 
     if (strId.size() == 0) {
@@ -1441,22 +1382,22 @@
       })MSG");
 
       dispatch_async(queue, ^{
-        [self send: seq msg: msg post: Post{}];
+        [bridge send: seq msg: msg post: Post{}];
       });
       return true;
     }
 
-    auto peerId = std::stoull(strId);
+    auto peerId = cmd.getU64("id").value_or(0);
 
     dispatch_async(queue, ^{
-      self.core->udpGetSockName(seq, peerId, [=](auto seq, auto msg, auto post) {
-        [self send: seq msg: msg post: post];
+      bridge.core->udpGetSockName(seq, peerId, [=](auto seq, auto msg, auto post) {
+        [bridge send: seq msg: msg post: post];
       });
     });
     return true;
-  }
+  });
 
-  if (cmd.name == "udpGetState" || cmd.name == "udp.getState") {
+  router->on(COMMAND_UDP_GET_STATE, [](Bridge* bridge, auto cmd, auto seq, auto buf, auto bufsize) {
     auto strId = cmd.get("id");
 
     if (strId.size() == 0) {
@@ -1468,22 +1409,22 @@
       })MSG");
 
       dispatch_async(queue, ^{
-        [self send: seq msg: msg post: Post{}];
+        [bridge send: seq msg: msg post: Post{}];
       });
       return true;
     }
 
-    auto peerId = std::stoull(strId);
+    auto peerId = cmd.getU64("id").value_or(0);
 
     dispatch_async(queue, ^{
-      self.core->udpGetState(seq, peerId, [=](auto seq, auto msg, auto post) {
-        [self send: seq msg: msg post: post];
+      bridge.core->udpGetState(seq, peerId, [=](auto seq, auto msg, auto post) {
+        [bridge send: seq msg: msg post: post];
       });
     });
     return true;
-  }
+  });
 
-  if (cmd.name == "udpSend" || cmd.name == "udp.send") {
+  router->on(COMMAND_UDP_SEND, [](Bridge* bridge, auto cmd, auto seq, auto buf, auto bufsize) {
     int offset = 0;
     int port = 0;
     uint64_t peerId;
@@ -1495,16 +1436,16 @@
     auto ip = cmd.get("address");
 
     if (strOffset.size() > 0) {
-      try {
-        offset = std::stoi(strOffset);
-      } catch (...) {
+      if (auto parsed = cmd.getInt("offset")) {
+        offset = *parsed;
+      } else {
         err = "invalid offset";
       }
     }
 
-    try {
-      port = std::stoi(strPort);
-    } catch (...) {
+    if (auto parsed = cmd.getInt("port")) {
+      port = *parsed;
+    } else {
       err = "invalid port";
     }
 
@@ -1512,9 +1453,9 @@
       ip = "0.0.0.0";
     }
 
-    try {
-      peerId = std::stoull(cmd.get("id"));
-    } catch (...) {
+    if (auto parsed = cmd.getU64("id")) {
+      peerId = *parsed;
+    } else {
       err = "invalid peerId";
     }
 
@@ -1529,22 +1470,22 @@
           "message": "$S"
         }
       })MSG", err);
-      [self send: seq msg: err post: Post{}];
+      [bridge send: seq msg: err post: Post{}];
       return true;
     }
 
     auto tmp = new char[bufsize]{0};
     memcpy(tmp, buf, bufsize);
     dispatch_async(queue, ^{
-      self.core->udpSend(seq, peerId, tmp, (int)bufsize, port, ip, ephemeral, [=](auto seq, auto msg, auto post) {
-        [self send: seq msg: msg post: post];
+      bridge.core->udpSend(seq, peerId, tmp, (int)bufsize, port, ip, ephemeral, [=](auto seq, auto msg, auto post) {
+        [bridge send: seq msg: msg post: post];
         delete [] tmp;
       });
     });
     return true;
-  }
+  });
 
-  if (cmd.name == "udpBind" || cmd.name == "udp.bind") {
+  router->on(COMMAND_UDP_BIND, [](Bridge* bridge, auto cmd, auto seq, auto buf, auto bufsize) {
     auto ip = cmd.get("address");
     auto reuseAddr = cmd.get("reuseAddr") == "true";
     SSC::String err;
@@ -1555,99 +1496,290 @@
       ip = "0.0.0.0";
     }
 
-    try {
-      peerId = std::stoull(cmd.get("id"));
-    } catch (...) {
+    if (auto parsed = cmd.getU64("id")) {
+      peerId = *parsed;
+    } else {
       auto msg = SSC::format(R"({ "err": { "message": "property 'peerId' required" } })");
-      [self send: seq msg: msg post: Post{}];
+      [bridge send: seq msg: msg post: Post{}];
       return true;
     }
 
-    try {
-      port = std::stoi(cmd.get("port"));
-    } catch (...) {
+    if (auto parsed = cmd.getInt("port")) {
+      port = *parsed;
+    } else {
       auto msg = SSC::format(R"({ "err": { "message": "property 'port' required" } })");
-      [self send: seq msg: msg post: Post{}];
+      [bridge send: seq msg: msg post: Post{}];
       return true;
     }
 
     dispatch_async(queue, ^{
-      self.core->udpBind(seq, peerId, ip, port, reuseAddr, [=](auto seq, auto msg, auto post) {
-        [self send: seq msg: msg post: post];
+      bridge.core->udpBind(seq, peerId, ip, port, reuseAddr, [=](auto seq, auto msg, auto post) {
+        [bridge send: seq msg: msg post: post];
       });
     });
 
     return true;
-  }
+  });
 
-  if (cmd.name == "udpReadStart" || cmd.name == "udp.readStart") {
+  router->on(COMMAND_UDP_READ_START, [](Bridge* bridge, auto cmd, auto seq, auto buf, auto bufsize) {
     uint64_t peerId;
 
-    try {
-      peerId = std::stoull(cmd.get("id"));
-    } catch (...) {
+    if (auto parsed = cmd.getU64("id")) {
+      peerId = *parsed;
+    } else {
       auto msg = SSC::format(R"({ "err": { "message": "property 'peerId' required" } })");
-      [self send: seq msg: msg post: Post{}];
+      [bridge send: seq msg: msg post: Post{}];
       return true;
     }
 
     dispatch_async(queue, ^{
-      self.core->udpReadStart(seq, peerId, [=](auto seq, auto msg, auto post) {
-        [self send: seq msg: msg post: post];
+      bridge.core->udpReadStart(seq, peerId, [=](auto seq, auto msg, auto post) {
+        [bridge send: seq msg: msg post: post];
       });
     });
 
     return true;
-  }
+  });
 
-  if (cmd.name == "udpReadStop" || cmd.name == "udp.readStop") {
+  router->on(COMMAND_UDP_READ_STOP, [](Bridge* bridge, auto cmd, auto seq, auto buf, auto bufsize) {
     uint64_t peerId;
 
-    try {
-      peerId = std::stoull(cmd.get("id"));
-    } catch (...) {
+    if (auto parsed = cmd.getU64("id")) {
+      peerId = *parsed;
+    } else {
       auto msg = SSC::format(R"({ "err": { "message": "property 'peerId' required" } })");
-      [self send: seq msg: msg post: Post{}];
+      [bridge send: seq msg: msg post: Post{}];
       return true;
     }
 
     dispatch_async(queue, ^{
-      self.core->udpReadStop(seq, peerId, [=](auto seq, auto msg, auto post) {
-        [self send: seq msg: msg post: post];
+      bridge.core->udpReadStop(seq, peerId, [=](auto seq, auto msg, auto post) {
+        [bridge send: seq msg: msg post: post];
       });
     });
 
     return true;
-  }
+  });
 
-  if (cmd.name == "dnsLookup" || cmd.name == "dns.lookup") {
+  router->on(COMMAND_DNS_LOOKUP, [](Bridge* bridge, auto cmd, auto seq, auto buf, auto bufsize) {
     auto hostname = cmd.get("hostname");
     SSC::String err = "";
 
-    auto strFamily = cmd.get("family");
-    int family = 0;
-
-    if (strFamily.size() > 0) {
-      try {
-        family = std::stoi(strFamily);
-      } catch (...) {
-      }
-    }
+    auto family = cmd.getInt("family").value_or(0);
 
     // TODO: support these options
-    // auto family = std::stoi(cmd.get("family"));
-    // auto hints = std::stoi(cmd.get("hints"));
-    // auto all = bool(std::stoi(cmd.get("all")));
-    // auto verbatim = bool(std::stoi(cmd.get("verbatim")));
+    // auto family = cmd.getInt("family").value_or(0);
+    // auto hints = cmd.getInt("hints").value_or(0);
+    // auto all = bool(cmd.getInt("all").value_or(0));
+    // auto verbatim = bool(cmd.getInt("verbatim").value_or(0));
 
     dispatch_async(queue, ^{
-      self.core->dnsLookup(seq, hostname, family, [=](auto seq, auto msg, auto post) {
-        [self send: seq msg: msg post: post];
+      bridge.core->dnsLookup(seq, hostname, family, [=](auto seq, auto msg, auto post) {
+        [bridge send: seq msg: msg post: post];
       });
     });
     return true;
+  });
+  router->on(COMMAND_COMMANDS_STATS, [](Bridge* bridge, auto cmd, auto seq, auto buf, auto bufsize) {
+    [bridge send: seq msg: getCommandRouter().getStats() post: Post{}];
+    return true;
+  });
+
+  return router;
+}
+
+static BridgeCommandRouter& getCommandRouter () {
+  // handlers are registered once, on first use, and shared by every bridge
+  static auto router = createCommandRouter();
+  return *router;
+}
+
+@implementation Bridge
+- (id) init {
+  self = [super init];
+  tasks = std::unique_ptr<SSC::Tasks>(new SSC::Tasks());
+  return self;
+}
+
+- (SSC::Task) getTask: (SSC::String) id {
+  std::lock_guard<std::recursive_mutex> guard(tasksMutex);
+  if (tasks->find(id) == tasks->end()) return SSC::Task{};
+  return tasks->at(id);
+}
+
+- (bool) hasTask: (SSC::String) id {
+  std::lock_guard<std::recursive_mutex> guard(tasksMutex);
+  if (id.size() == 0) return false;
+  return tasks->find(id) != tasks->end();
+}
+
+- (void) removeTask: (SSC::String) id {
+  std::lock_guard<std::recursive_mutex> guard(tasksMutex);
+  if (tasks->find(id) == tasks->end()) return;
+  tasks->erase(id);
+}
+
+- (void) putTask: (SSC::String) id task: (SSC::Task) task {
+  std::lock_guard<std::recursive_mutex> guard(tasksMutex);
+  tasks->insert_or_assign(id, task);
+}
+
+- (void) setBluetooth: (SSCBluetoothDelegate*)bd {
+  _bluetooth = bd;
+  [_bluetooth initBluetooth];
+  _bluetooth.bridge = self;
+}
+
+- (void) initNetworkStatusObserver {
+  dispatch_queue_attr_t attrs = dispatch_queue_attr_make_with_qos_class(
+    DISPATCH_QUEUE_SERIAL,
+    QOS_CLASS_UTILITY,
+    DISPATCH_QUEUE_PRIORITY_DEFAULT
+  );
+
+  self.monitorQueue = dispatch_queue_create("co.socketsupply.queue.network-monitor", attrs);
+
+  // self.monitor = nw_path_monitor_create_with_type(nw_interface_type_wifi);
+  self.monitor = nw_path_monitor_create();
+  nw_path_monitor_set_queue(self.monitor, self.monitorQueue);
+  nw_path_monitor_set_update_handler(self.monitor, ^(nw_path_t path) {
+    nw_path_status_t status = nw_path_get_status(path);
+
+    SSC::String name;
+    SSC::String message;
+
+    switch (status) {
+      case nw_path_status_invalid: {
+        name = "offline";
+        message = "Network path is invalid";
+        break;
+      }
+      case nw_path_status_satisfied: {
+        name = "online";
+        message = "Network is usable";
+        break;
+      }
+      case nw_path_status_satisfiable: {
+        name = "online";
+        message = "Network may be usable";
+        break;
+      }
+      case nw_path_status_unsatisfied: {
+        name = "offline";
+        message = "Network is not usable";
+        break;
+      }
+    }
+
+    dispatch_async(dispatch_get_main_queue(), ^{
+      [self emit: name msg: SSC::format(R"JSON({
+        "message": "$S"
+      })JSON", message)];
+    });
+  });
+
+  nw_path_monitor_start(self.monitor);
+}
+
+- (void) setWebview: (SSCBridgedWebView*)wv {
+  _webview = wv;
+}
+
+- (void) setCore: (SSC::Core*)core; {
+  _core = core;
+}
+
+- (void) emit: (SSC::String)name msg: (SSC::String)msg {
+  msg = SSC::getEmitToRenderProcessJavaScript(name, SSC::encodeURIComponent(msg));
+  NSString* script = [NSString stringWithUTF8String: msg.c_str()];
+  [self.webview evaluateJavaScript: script completionHandler: nil];
+}
+
+- (void) send: (SSC::String)seq msg: (SSC::String)msg post: (SSC::Post)post {
+  if (seq != "-1" && [self hasTask: seq]) {
+    auto task = [self getTask: seq];
+    [self removeTask: seq];
+
+    #if !__has_feature(objc_arc)
+    [task retain];
+    #endif
+
+    dispatch_async(dispatch_get_main_queue(), ^{
+      NSMutableDictionary* httpHeaders = [[NSMutableDictionary alloc] init];
+      auto length = post.body ? post.body.size() : msg.size();
+
+      httpHeaders[@"access-control-allow-origin"] = @"*";
+      httpHeaders[@"access-control-allow-methods"] = @"*";
+      httpHeaders[@"content-length"] = [@(length) stringValue];
+      // lets callers tell a result message from a binary body
+      httpHeaders[@"content-type"] = post.body
+        ? @"application/octet-stream"
+        : @"application/json";
+
+      NSHTTPURLResponse *httpResponse = [[NSHTTPURLResponse alloc]
+         initWithURL: task.request.URL
+          statusCode: 200
+         HTTPVersion: @"HTTP/1.1"
+        headerFields: httpHeaders
+      ];
+
+      [task didReceiveResponse: httpResponse];
+
+      if (post.body) {
+        NSData *data = dataWithBuffer(post.body);
+        [task didReceiveData: data];
+        #if !__has_feature(objc_arc)
+        [data release];
+        #endif
+      } else if (msg.size() > 0) {
+        NSString* str = [NSString stringWithUTF8String: msg.c_str()];
+        NSData *data = [str dataUsingEncoding: NSUTF8StringEncoding];
+        [task didReceiveData: data];
+      }
+
+      [task didFinish];
+      #if !__has_feature(objc_arc)
+      [httpHeaders release];
+      [httpResponse release];
+      #endif
+    });
+    return;
+  }
+
+  if (post.body || seq == "-1") {
+    dispatch_async(dispatch_get_main_queue(), ^{
+      auto src = self.core->createPost(seq, msg, post);
+      NSString* script = [NSString stringWithUTF8String: src.c_str()];
+      [self.webview evaluateJavaScript: script completionHandler: nil];
+    });
+    return;
+  }
+
+  if (seq != "-1" && seq.size() > 0) { // this had a sequence, we need to try to resolve it.
+    msg = SSC::getResolveToRenderProcessJavaScript(seq, "0", SSC::encodeURIComponent(msg));
   }
 
-  return false;
+  if (msg.size() > 0) {
+    dispatch_async(dispatch_get_main_queue(), ^{
+      NSString* script = [NSString stringWithUTF8String: msg.c_str()];
+      [self.webview evaluateJavaScript: script completionHandler: nil];
+    });
+  }
+}
+
+-(void)userNotificationCenter:(UNUserNotificationCenter *)center willPresentNotification:(UNNotification *)notification withCompletionHandler:(void (^)(UNNotificationPresentationOptions options))completionHandler {
+  completionHandler(UNNotificationPresentationOptionList | UNNotificationPresentationOptionBanner);
+}
+
+// returns true if routable (regardless of success)
+- (bool) route: (SSC::String)msg buf: (char*)buf bufsize: (size_t)bufsize{
+  using namespace SSC;
+
+  if (msg.find("ipc://") != 0) return false;
+
+  Parse cmd(msg);
+  // NSLog(@"Route<%s> - [%s:%i]", cmd.name.c_str(), buf, (int)bufsize);
+
+  return getCommandRouter().invoke(cmd.name, self, cmd, cmd.get("seq"), buf, bufsize);
 }
 @end
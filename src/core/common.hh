@@ -9,6 +9,7 @@
 #if !defined(_WIN32)
 #include <arpa/inet.h>
 #include <ifaddrs.h>
+#include <sys/mman.h>
 #include <sys/socket.h>
 #include <sys/types.h>
 #include <sys/wait.h>
@@ -85,25 +86,47 @@
 #endif
 #endif
 
-#include <any>
+#include <algorithm>
+#include <atomic>
 #include <array>
+#include <charconv>
 #include <chrono>
+#include <coroutine>
+#include <cstring>
 #include <cstdint>
+#include <deque>
 #include <iostream>
 #include <filesystem>
 #include <fstream>
 #include <functional>
 #include <map>
 #include <mutex>
+#include <optional>
 #include <queue>
 #include <regex>
 #include <semaphore>
+#include <shared_mutex>
 #include <span>
 #include <sstream>
 #include <string>
+#include <string_view>
 #include <thread>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
 #include <vector>
 
+// baseline vector units used by the URI component kernels, define
+// `SSC_URI_SCALAR` to use the portable loop on every target
+#if defined(SSC_URI_SCALAR)
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define SSC_URI_SSE2 1
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#include <arm_neon.h>
+#define SSC_URI_NEON 1
+#endif
+
 #ifndef DEBUG
 #define DEBUG 0
 #endif
@@ -390,40 +413,347 @@ namespace SSC {
     return size;
   }
 
-  template <typename ...Args> String format (const String& s, Args ...args) {
-    auto copy = s;
-    StringStream res;
-    Vector<std::any> vec;
-    using unpack = int[];
-
-    (void) unpack { 0, (vec.push_back(args), 0)... };
-
-    std::regex re("\\$[^$\\s]");
-    std::smatch match;
-    auto first = std::regex_constants::format_first_only;
-    int index = 0;
-
-    while (std::regex_search(copy, match, re) != 0) {
-      if (match.str() == "$S") {
-        auto value = std::any_cast<String>(vec[index++]);
-        copy = std::regex_replace(copy, re, value, first);
-      } else if (match.str() == "$i") {
-        auto value = std::any_cast<int>(vec[index++]);
-        copy = std::regex_replace(copy, re, std::to_string(value), first);
-      } else if (match.str() == "$C") {
-        auto value = std::any_cast<char*>(vec[index++]);
-        copy = std::regex_replace(copy, re, String(value), first);
-      } else if (match.str() == "$c") {
-        auto value = std::any_cast<char>(vec[index++]);
-        copy = std::regex_replace(copy, re, String(1, value), first);
-      } else {
-        copy = std::regex_replace(copy, re, match.str(), first);
+  /**
+   * A `format()` template, parsed at compile time into literal pieces and
+   * typed slots. Pieces point into the template literal itself. Indentation
+   * after a newline is dropped and so are the newlines of JSON templates
+   * (those starting with `{` or `[`), so raw string templates can be
+   * written indented without sending the whitespace.
+   *
+   * Slots are `$S` (string), `$i` (integer), `$C` (C string) and `$c`
+   * (char). Any other `$` is kept as is. A slot that does not match its
+   * argument is a compile error.
+   */
+  template <typename ...Args> class FormatString {
+    public:
+      static constexpr size_t MAX_PIECES = 96;
+      static constexpr size_t SLOTS = sizeof...(Args);
+
+      struct Piece {
+        uint16_t offset = 0;
+        uint16_t size = 0;
+        char slot = 0;
+      };
+
+      const char *source = nullptr;
+      Piece pieces[MAX_PIECES] = {};
+      size_t count = 0;
+      size_t size = 0; // of the literal pieces
+
+      template <size_t N> consteval FormatString (const char (&source)[N]) {
+        static_assert(N <= UINT16_MAX, "format template is too large");
+
+        auto length = N - 1;
+        auto isJSON = false;
+        size_t slots = 0;
+        size_t start = 0;
+
+        for (size_t i = 0; i < length; ++i) {
+          if (source[i] == ' ' || source[i] == '\n' || source[i] == '\t') {
+            continue;
+          }
+
+          isJSON = source[i] == '{' || source[i] == '[';
+          break;
+        }
+
+        this->source = source;
+
+        for (size_t i = 0; i < length; ++i) {
+          auto c = source[i];
+
+          if (c == '$' && i + 1 < length && isSlot(source[i + 1])) {
+            if (slots >= SLOTS || !accepts<Args...>(slots, source[i + 1])) {
+              throw "format template slot does not match its argument";
+            }
+
+            push(start, i - start, 0);
+            push(i, 0, source[i + 1]);
+            start = i + 2;
+            slots++;
+            i++;
+          } else if (c == '\n') {
+            push(start, isJSON ? i - start : i - start + 1, 0);
+
+            while (i + 1 < length && (source[i + 1] == ' ' || source[i + 1] == '\t')) {
+              i++;
+            }
+
+            start = i + 1;
+          }
+        }
+
+        push(start, length - start, 0);
+
+        if (slots != SLOTS) {
+          throw "format template has fewer slots than arguments";
+        }
       }
+
+      // appends literal pieces from `index` up to the next slot and returns
+      // the index of the piece after that slot
+      size_t append (String& output, size_t index) const {
+        for (; index < this->count; ++index) {
+          const auto& piece = this->pieces[index];
+
+          if (piece.slot != 0) {
+            return index + 1;
+          }
+
+          output.append(this->source + piece.offset, piece.size);
+        }
+
+        return index;
+      }
+
+    private:
+      static constexpr bool isSlot (char c) {
+        return c == 'S' || c == 'i' || c == 'C' || c == 'c';
+      }
+
+      template <typename T> static constexpr bool accepts (char slot) {
+        if constexpr (std::is_same_v<T, char>) {
+          return slot == 'c';
+        } else if constexpr (std::is_convertible_v<const T&, const char*>) {
+          return slot == 'C' || slot == 'S';
+        } else if constexpr (std::is_convertible_v<const T&, std::string_view>) {
+          return slot == 'S';
+        } else if constexpr (std::is_integral_v<T>) {
+          return slot == 'i';
+        } else {
+          return false;
+        }
+      }
+
+      template <typename ...Types> static constexpr bool accepts (size_t index, char slot) {
+        size_t i = 0;
+        auto result = false;
+        ((result = i++ == index ? accepts<Types>(slot) : result), ...);
+        return result;
+      }
+
+      constexpr void push (size_t offset, size_t size, char slot) {
+        if (size == 0 && slot == 0) {
+          return;
+        }
+
+        if (this->count >= MAX_PIECES) {
+          throw "format template has too many pieces";
+        }
+
+        this->pieces[this->count++] = { (uint16_t) offset, (uint16_t) size, slot };
+        this->size += size;
+      }
+  };
+
+  template <typename T> inline void appendFormatValue (String& output, const T& value) {
+    if constexpr (std::is_same_v<T, char>) {
+      output.push_back(value);
+    } else if constexpr (std::is_convertible_v<const T&, const char*>) {
+      const char *string = value;
+
+      if (string != nullptr) {
+        output.append(string);
+      }
+    } else if constexpr (std::is_convertible_v<const T&, std::string_view>) {
+      output.append(std::string_view(value));
+    } else {
+      char number[24];
+      auto end = std::to_chars(number, number + sizeof(number), value).ptr;
+      output.append(number, end - number);
     }
+  }
 
-    return copy;
+  template <typename T> inline size_t getFormatValueSize (const T& value) {
+    if constexpr (std::is_same_v<T, String>) {
+      return value.size();
+    } else {
+      return 8;
+    }
   }
 
+  template <typename ...Args> String format (
+    FormatString<std::type_identity_t<Args>...> fmt,
+    const Args& ...args
+  ) {
+    String output;
+    size_t index = 0;
+
+    output.reserve(fmt.size + (getFormatValueSize(args) + ... + 0));
+    ((index = fmt.append(output, index), appendFormatValue(output, args)), ...);
+    fmt.append(output, index);
+
+    return output;
+  }
+
+  /**
+   * Appends `string` to `output` as a quoted JSON string. Plain runs are
+   * scanned a word (8 bytes) at a time and copied in one go, only bytes
+   * that need escaping are handled one by one.
+   */
+  inline void appendJSONString (String& output, std::string_view string) {
+    constexpr uint64_t ONES = 0x0101010101010101ULL;
+    constexpr uint64_t HIGHS = 0x8080808080808080ULL;
+    static const char *hex = "0123456789abcdef";
+
+    auto data = string.data();
+    auto size = string.size();
+    size_t start = 0;
+    size_t i = 0;
+
+    output.reserve(output.size() + size + 2);
+    output.push_back('"');
+
+    while (i < size) {
+      if (i + 8 <= size) {
+        uint64_t word;
+        memcpy(&word, data + i, 8);
+
+        auto quotes = word ^ (ONES * '"');
+        auto slashes = word ^ (ONES * '\\');
+        auto mask = (
+          ((quotes - ONES) & ~quotes) |
+          ((slashes - ONES) & ~slashes) |
+          ((word - ONES * 0x20) & ~word)
+        ) & HIGHS;
+
+        if (mask == 0) {
+          i += 8;
+          continue;
+        }
+      }
+
+      for (auto end = std::min(i + 8, size); i < end; ++i) {
+        auto c = (unsigned char) data[i];
+
+        if (c >= 0x20 && c != '"' && c != '\\') {
+          continue;
+        }
+
+        output.append(data + start, i - start);
+        start = i + 1;
+
+        switch (c) {
+          case '"': output.append("\\\""); break;
+          case '\\': output.append("\\\\"); break;
+          case '\b': output.append("\\b"); break;
+          case '\f': output.append("\\f"); break;
+          case '\n': output.append("\\n"); break;
+          case '\r': output.append("\\r"); break;
+          case '\t': output.append("\\t"); break;
+          default: {
+            char escape[] = { '\\', 'u', '0', '0', hex[c >> 4], hex[c & 0xf] };
+            output.append(escape, sizeof(escape));
+          }
+        }
+      }
+    }
+
+    output.append(data + start, size - start);
+    output.push_back('"');
+  }
+
+  /**
+   * An append-only JSON writer. Separators are written as needed, strings
+   * are escaped and integers are formatted with `to_chars`, all into one
+   * preallocated string.
+   */
+  class JSONWriter {
+    public:
+      String output;
+      bool needsSeparator = false;
+
+      JSONWriter (size_t capacity = 256) {
+        this->output.reserve(capacity);
+      }
+
+      JSONWriter& beginObject () {
+        this->separate();
+        this->output.push_back('{');
+        this->needsSeparator = false;
+        return *this;
+      }
+
+      JSONWriter& endObject () {
+        this->output.push_back('}');
+        this->needsSeparator = true;
+        return *this;
+      }
+
+      JSONWriter& beginArray () {
+        this->separate();
+        this->output.push_back('[');
+        this->needsSeparator = false;
+        return *this;
+      }
+
+      JSONWriter& endArray () {
+        this->output.push_back(']');
+        this->needsSeparator = true;
+        return *this;
+      }
+
+      JSONWriter& key (std::string_view name) {
+        this->separate();
+        appendJSONString(this->output, name);
+        this->output.push_back(':');
+        this->needsSeparator = false;
+        return *this;
+      }
+
+      template <typename T> JSONWriter& value (const T& value) {
+        this->separate();
+
+        if constexpr (std::is_same_v<T, bool>) {
+          this->output.append(value ? "true" : "false");
+        } else if constexpr (std::is_integral_v<T>) {
+          char number[24];
+          auto end = std::to_chars(number, number + sizeof(number), value).ptr;
+          this->output.append(number, end - number);
+        } else if constexpr (std::is_convertible_v<const T&, const char*>) {
+          const char *string = value;
+
+          if (string == nullptr) {
+            this->output.append("null");
+          } else {
+            appendJSONString(this->output, string);
+          }
+        } else {
+          appendJSONString(this->output, std::string_view(value));
+        }
+
+        this->needsSeparator = true;
+        return *this;
+      }
+
+      template <typename T> JSONWriter& value (std::string_view name, const T& value) {
+        return this->key(name).value(value);
+      }
+
+      JSONWriter& null () {
+        return this->raw("null");
+      }
+
+      // `json` must already be valid JSON, such as a nested response
+      JSONWriter& raw (std::string_view json) {
+        this->separate();
+        this->output.append(json);
+        this->needsSeparator = true;
+        return *this;
+      }
+
+      String str () const {
+        return this->output;
+      }
+
+    private:
+      void separate () {
+        if (this->needsSeparator) {
+          this->output.push_back(',');
+        }
+      }
+  };
+
   inline String replace (const String& src, const String& re, const String& val) {
     return std::regex_replace(src, std::regex(re), val);
   }
@@ -580,16 +910,61 @@ namespace SSC {
   // IPC Message parser for the middle end
   // TODO possibly harden data validation.
   //
+  // Keys and values are recorded as spans into `uri`, inline for up to
+  // `MAX_INLINE_ARGS` pairs, and only copied or decoded when accessed.
+  //
   class Parse {
-    Map args;
     public:
-      Parse(const String&);
+      static constexpr size_t MAX_INLINE_ARGS = 16;
+
+    private:
+      struct Span {
+        uint32_t offset = 0;
+        uint32_t length = 0;
+      };
+
+      struct Arg {
+        Span key;
+        Span value;
+      };
+
+      Arg args[MAX_INLINE_ARGS];
+      Vector<Arg> overflow;
+      size_t count = 0;
+      Span nameSpan;
+
+      std::string_view view (const Span& span) const {
+        return std::string_view(this->uri).substr(span.offset, span.length);
+      }
+
+      const Arg* find (std::string_view key) const;
+
+      template <typename T> std::optional<T> getNumber (std::string_view key) const;
+
+    public:
       int index = -1;
       String value = "";
-      String name = "";
+      std::string_view name;
       String uri = "";
-      String get(const String&) const;
-      String get(const String&, const String) const;
+      // values were never URI encoded, such as those from a binary frame
+      bool isDecoded = false;
+
+      Parse(const String&);
+      Parse(std::string_view, int);
+      Parse(const Parse&);
+      Parse& operator= (const Parse&);
+
+      void set(std::string_view, std::string_view);
+
+      bool has(std::string_view) const;
+      String get(std::string_view) const;
+      String get(std::string_view, const String) const;
+      std::string_view getView(std::string_view) const;
+      String getDecoded(std::string_view) const;
+      std::optional<int> getInt(std::string_view) const;
+      std::optional<int64_t> getI64(std::string_view) const;
+      std::optional<uint64_t> getU64(std::string_view) const;
+      std::optional<std::vector<int64_t>> getI64List(std::string_view) const;
       const char * c_str () const {
         return this->uri.c_str();
       }
@@ -604,51 +979,209 @@ namespace SSC {
   // cmd: `ipc://id?p1=v1&p2=v2&...\0`
   //
   inline Parse::Parse (const String& s) {
-    String str = s;
-    uri = str;
+    uri = s;
+
+    std::string_view str(uri);
+    auto start = str.find("ipc://");
 
     // bail if missing protocol prefix
-    if (str.find("ipc://") == -1) return;
+    if (start == std::string_view::npos) return;
+    start += 6;
+
+    auto end = str.find('?', start);
+    if (end == std::string_view::npos) end = str.size();
+
+    auto slash = str.find('/', start);
+    if (slash < end) end = slash;
 
     // bail if malformed
-    if (str.compare("ipc://") == 0) return;
-    if (str.compare("ipc://?") == 0) return;
+    if (end == start) return;
+
+    nameSpan = { (uint32_t) start, (uint32_t) (end - start) };
+    name = view(nameSpan);
+
+    auto query = str.find('?', start);
+    if (query == std::string_view::npos) return;
 
-    String query;
-    String path;
+    for (auto offset = query + 1; offset < str.size();) {
+      auto next = str.find('&', offset);
+      if (next == std::string_view::npos) next = str.size();
 
-    auto raw = split(str, '?');
-    path = raw[0];
-    if (raw.size() > 1) query = raw[1];
+      auto pair = str.substr(offset, next - offset);
+      auto equals = pair.find('=');
 
-    auto parts = split(path, '/');
-    if (parts.size() >= 1) name = parts[1];
+      // pairs without a value are skipped
+      if (equals != std::string_view::npos && equals > 0 && equals + 1 < pair.size()) {
+        Arg arg = {
+          { (uint32_t) offset, (uint32_t) equals },
+          { (uint32_t) (offset + equals + 1), (uint32_t) (pair.size() - equals - 1) }
+        };
 
-    if (raw.size() != 2) return;
-    auto pairs = split(raw[1], '&');
+        if (count < MAX_INLINE_ARGS) {
+          args[count] = arg;
+        } else {
+          overflow.push_back(arg);
+        }
 
-    for (auto& rawPair : pairs) {
-      auto pair = split(rawPair, '=');
-      if (pair.size() <= 1) continue;
+        count++;
 
-      if (pair[0].compare("index") == 0) {
-        try {
-          index = std::stoi(pair[1].size() > 0 ? pair[1] : "0");
-        } catch (...) {
-          std::cout << "Warning: received non-integer index" << std::endl;
+        if (view(arg.key) == "index") {
+          auto value = view(arg.value);
+          auto result = std::from_chars(value.data(), value.data() + value.size(), index);
+          if (result.ec != std::errc()) {
+            std::cout << "Warning: received non-integer index" << std::endl;
+          }
         }
       }
 
-      args[pair[0]] = pair[1];
+      offset = next + 1;
     }
   }
 
-  inline String Parse::get(const String& s) const {
-    return args.count(s) ? args.at(s): "";
+  //
+  // Builds a command from already decoded pairs added with `set()`, the
+  // `uri` only backs the spans and is not meant to be parsed again.
+  //
+  inline Parse::Parse (std::string_view name, int index) {
+    uri.reserve(64);
+    uri.append("ipc://").append(name).append("?");
+
+    nameSpan = { 6, (uint32_t) name.size() };
+    this->name = view(nameSpan);
+    this->index = index;
+    isDecoded = true;
   }
 
-  inline String Parse::get(const String& s, const String fallback) const {
-    return args.count(s) ? args.at(s) : fallback;
+  inline Parse::Parse (const Parse& parse) {
+    *this = parse;
+  }
+
+  inline void Parse::set (std::string_view key, std::string_view value) {
+    // pairs without a value are skipped, as they are when parsed
+    if (key.size() == 0 || value.size() == 0) return;
+
+    if (count > 0) uri.append("&");
+
+    Arg arg;
+    arg.key = { (uint32_t) uri.size(), (uint32_t) key.size() };
+    uri.append(key).append("=");
+    arg.value = { (uint32_t) uri.size(), (uint32_t) value.size() };
+    uri.append(value);
+
+    if (count < MAX_INLINE_ARGS) {
+      args[count] = arg;
+    } else {
+      overflow.push_back(arg);
+    }
+
+    count++;
+
+    // appending may have moved `uri`
+    name = view(nameSpan);
+  }
+
+  // `name` views `uri`, so it is pointed at the copy
+  inline Parse& Parse::operator= (const Parse& parse) {
+    if (this != &parse) {
+      std::copy(std::begin(parse.args), std::end(parse.args), std::begin(args));
+      overflow = parse.overflow;
+      count = parse.count;
+      nameSpan = parse.nameSpan;
+      index = parse.index;
+      value = parse.value;
+      uri = parse.uri;
+      isDecoded = parse.isDecoded;
+      name = parse.name.data() != nullptr ? view(nameSpan) : std::string_view();
+    }
+
+    return *this;
+  }
+
+  // later pairs win, like the map this replaces
+  inline const Parse::Arg* Parse::find (std::string_view key) const {
+    for (auto i = count; i > 0; --i) {
+      auto arg = i <= MAX_INLINE_ARGS ? &args[i - 1] : &overflow[i - 1 - MAX_INLINE_ARGS];
+      if (view(arg->key) == key) {
+        return arg;
+      }
+    }
+
+    return nullptr;
+  }
+
+  template <typename T> inline std::optional<T> Parse::getNumber (std::string_view key) const {
+    auto value = getView(key);
+    T number;
+
+    if (value.size() == 0) {
+      return std::nullopt;
+    }
+
+    auto result = std::from_chars(value.data(), value.data() + value.size(), number);
+    if (result.ec != std::errc()) {
+      return std::nullopt;
+    }
+
+    return number;
+  }
+
+  inline bool Parse::has(std::string_view s) const {
+    return find(s) != nullptr;
+  }
+
+  inline std::string_view Parse::getView(std::string_view s) const {
+    auto arg = find(s);
+    return arg != nullptr ? view(arg->value) : std::string_view();
+  }
+
+  inline String Parse::get(std::string_view s) const {
+    return String(getView(s));
+  }
+
+  inline String Parse::get(std::string_view s, const String fallback) const {
+    auto arg = find(s);
+    return arg != nullptr ? String(view(arg->value)) : fallback;
+  }
+
+  inline String Parse::getDecoded(std::string_view s) const {
+    return isDecoded ? get(s) : decodeURIComponent(get(s));
+  }
+
+  inline std::optional<int> Parse::getInt(std::string_view s) const {
+    return getNumber<int>(s);
+  }
+
+  inline std::optional<int64_t> Parse::getI64(std::string_view s) const {
+    return getNumber<int64_t>(s);
+  }
+
+  inline std::optional<uint64_t> Parse::getU64(std::string_view s) const {
+    return getNumber<uint64_t>(s);
+  }
+
+  // comma separated, such as `sizes=4,16,4`, empty when the key is missing
+  inline std::optional<std::vector<int64_t>> Parse::getI64List(std::string_view s) const {
+    auto value = getDecoded(s);
+    const char *data = value.data();
+    const char *end = data + value.size();
+    std::vector<int64_t> numbers;
+
+    while (data < end) {
+      int64_t number = 0;
+      auto result = std::from_chars(data, end, number);
+      if (result.ec != std::errc()) {
+        return std::nullopt;
+      }
+
+      numbers.push_back(number);
+      data = result.ptr;
+
+      if (data < end && (*data++ != ',' || data == end)) {
+        return std::nullopt;
+      }
+    }
+
+    return numbers;
   }
 
   //
@@ -679,42 +1212,74 @@ namespace SSC {
     /* F */ -1,-1,-1,-1, -1,-1,-1,-1, -1,-1,-1,-1, -1,-1,-1,-1
   };
 
+  // true if none of the 16 bytes at `bytes` is '%' or '+'
+  inline bool isURIComponentLiteralBlock (const unsigned char* bytes) {
+  #if SSC_URI_SSE2
+    auto block = _mm_loadu_si128((const __m128i*) bytes);
+    auto special = _mm_or_si128(
+      _mm_cmpeq_epi8(block, _mm_set1_epi8('%')),
+      _mm_cmpeq_epi8(block, _mm_set1_epi8('+'))
+    );
+
+    return _mm_movemask_epi8(special) == 0;
+  #elif SSC_URI_NEON
+    auto block = vld1q_u8(bytes);
+    auto special = vorrq_u8(
+      vceqq_u8(block, vdupq_n_u8('%')),
+      vceqq_u8(block, vdupq_n_u8('+'))
+    );
+
+    return vmaxvq_u8(special) == 0;
+  #else
+    return false;
+  #endif
+  }
+
   inline String decodeURIComponent(const String& sSrc) {
 
     // Note from RFC1630:  "Sequences which start with a percent sign
     // but are not followed by two hexadecimal characters (0-9, A-F) are reserved
     // for future extension"
 
-    auto s = replace(sSrc, "\\+", " ");
-    const unsigned char* pSrc = (const unsigned char *) s.c_str();
-    const int SRC_LEN = (int) sSrc.length();
-    const unsigned char* const SRC_END = pSrc + SRC_LEN;
-    const unsigned char* const SRC_LAST_DEC = SRC_END - 2;
+    const auto pSrc = (const unsigned char *) sSrc.data();
+    const auto SRC_LEN = sSrc.size();
+    String sResult(SRC_LEN, '\0');
+    auto pEnd = sResult.data();
+    size_t i = 0;
+
+    while (i < SRC_LEN) {
+      // copy runs with nothing to decode 16 bytes at a time, otherwise
+      // decode the block byte by byte (a sequence may run past its end)
+      if (i + 16 <= SRC_LEN && isURIComponentLiteralBlock(pSrc + i)) {
+        memcpy(pEnd, pSrc + i, 16);
+        pEnd += 16;
+        i += 16;
+        continue;
+      }
 
-    char* const pStart = new char[SRC_LEN];
-    char* pEnd = pStart;
+      for (auto end = std::min(i + 16, SRC_LEN); i < end;) {
+        if (pSrc[i] == '+') {
+          *pEnd++ = ' ';
+          i++;
+          continue;
+        }
 
-    while (pSrc < SRC_LAST_DEC) {
-      if (*pSrc == '%') {
-        char dec1, dec2;
-        if (-1 != (dec1 = HEX2DEC[*(pSrc + 1)])
-            && -1 != (dec2 = HEX2DEC[*(pSrc + 2)])) {
+        if (pSrc[i] == '%' && i + 2 < SRC_LEN) {
+          char dec1, dec2;
+          if (-1 != (dec1 = HEX2DEC[pSrc[i + 1]])
+              && -1 != (dec2 = HEX2DEC[pSrc[i + 2]])) {
 
-            *pEnd++ = (dec1 << 4) + dec2;
-            pSrc += 3;
-            continue;
+              *pEnd++ = (dec1 << 4) + dec2;
+              i += 3;
+              continue;
+          }
         }
-      }
-      *pEnd++ = *pSrc++;
-    }
 
-    // the last 2- chars
-    while (pSrc < SRC_END) {
-      *pEnd++ = *pSrc++;
+        *pEnd++ = pSrc[i++];
+      }
     }
 
-    String sResult(pStart, pEnd);
-    delete [] pStart;
+    sResult.resize(pEnd - sResult.data());
     return sResult;
   }
 
@@ -741,27 +1306,63 @@ namespace SSC {
       /* F */ 0,0,0,0, 0,0,0,0, 0,0,0,0, 0,0,0,0
   };
 
+  // true if all 16 bytes at `bytes` are `SAFE` (ASCII letters and digits)
+  inline bool isURIComponentSafeBlock (const unsigned char* bytes) {
+  #if SSC_URI_SSE2
+    // a signed compare after biasing `start` to -128 is an unsigned range check
+    auto inRange = [](__m128i block, char start, char count) {
+      auto biased = _mm_add_epi8(block, _mm_set1_epi8((char) (0x80 - start)));
+      return _mm_cmplt_epi8(biased, _mm_set1_epi8((char) (-128 + count)));
+    };
+
+    auto block = _mm_loadu_si128((const __m128i*) bytes);
+    auto lower = _mm_or_si128(block, _mm_set1_epi8(0x20));
+    auto safe = _mm_or_si128(inRange(block, '0', 10), inRange(lower, 'a', 26));
+
+    return _mm_movemask_epi8(safe) == 0xffff;
+  #elif SSC_URI_NEON
+    auto block = vld1q_u8(bytes);
+    auto lower = vorrq_u8(block, vdupq_n_u8(0x20));
+    auto digit = vcltq_u8(vsubq_u8(block, vdupq_n_u8('0')), vdupq_n_u8(10));
+    auto alpha = vcltq_u8(vsubq_u8(lower, vdupq_n_u8('a')), vdupq_n_u8(26));
+
+    return vminvq_u8(vorrq_u8(digit, alpha)) != 0;
+  #else
+    return false;
+  #endif
+  }
+
   inline String encodeURIComponent (const String& sSrc) {
     const char DEC2HEX[16 + 1] = "0123456789ABCDEF";
-    const unsigned char* pSrc = (const unsigned char*) sSrc.c_str();
-    const int SRC_LEN = (int) sSrc.length();
-    unsigned char* const pStart = new unsigned char[SRC_LEN* 3];
-    unsigned char* pEnd = pStart;
-    const unsigned char* const SRC_END = pSrc + SRC_LEN;
-
-    for (; pSrc < SRC_END; ++pSrc) {
-      if (SAFE[*pSrc]) {
-        *pEnd++ = *pSrc;
-      } else {
-        // escape this char
-        *pEnd++ = '%';
-        *pEnd++ = DEC2HEX[*pSrc >> 4];
-        *pEnd++ = DEC2HEX[*pSrc & 0x0F];
+    const auto pSrc = (const unsigned char*) sSrc.data();
+    const auto SRC_LEN = sSrc.size();
+    String sResult(SRC_LEN * 3, '\0');
+    auto pEnd = sResult.data();
+    size_t i = 0;
+
+    while (i < SRC_LEN) {
+      // copy runs of safe bytes 16 at a time, otherwise encode the block
+      // byte by byte
+      if (i + 16 <= SRC_LEN && isURIComponentSafeBlock(pSrc + i)) {
+        memcpy(pEnd, pSrc + i, 16);
+        pEnd += 16;
+        i += 16;
+        continue;
+      }
+
+      for (auto end = std::min(i + 16, SRC_LEN); i < end; ++i) {
+        if (SAFE[pSrc[i]]) {
+          *pEnd++ = pSrc[i];
+        } else {
+          // escape this char
+          *pEnd++ = '%';
+          *pEnd++ = DEC2HEX[pSrc[i] >> 4];
+          *pEnd++ = DEC2HEX[pSrc[i] & 0x0F];
+        }
       }
     }
 
-    String sResult((char*) pStart, (char*) pEnd);
-    delete [] pStart;
+    sResult.resize(pEnd - sResult.data());
     return sResult;
   }
 }
@@ -25,17 +25,10 @@ namespace SSC {
   void Core::handleEvent (String seq, String event, String data, Callback cb) {
     // init page
     if (event == "domcontentloaded") {
-      std::lock_guard<std::recursive_mutex> guard(descriptorsMutex);
-
-      for (auto const &tuple : descriptors) {
-        auto desc = tuple.second;
-        if (desc != nullptr) {
-          std::lock_guard<std::recursive_mutex> descriptorLock(desc->mutex);
-          desc->stale = true;
-        } else {
-          descriptors.erase(tuple.first);
-        }
-      }
+      descriptors.forEach([](auto id, auto desc) {
+        std::lock_guard<std::recursive_mutex> descriptorLock(desc->mutex);
+        desc->stale = true;
+      });
     }
 
     cb(seq, "{}", Post{});
@@ -43,66 +36,630 @@ namespace SSC {
     runEventLoop();
   }
 
-  Post Core::getPost (uint64_t id) {
-    std::lock_guard<std::recursive_mutex> guard(postsMutex);
-    if (posts->find(id) == posts->end()) return Post{};
-    return posts->at(id);
+  static uint64_t nowInMilliseconds () {
+    return std::chrono::time_point_cast<std::chrono::milliseconds>(
+      std::chrono::system_clock::now()
+    )
+      .time_since_epoch()
+      .count();
   }
 
-  bool Core::hasPost (uint64_t id) {
-    std::lock_guard<std::recursive_mutex> guard(postsMutex);
-    return posts->find(id) != posts->end();
+  static void deleteBufferBytes (char *bytes, size_t size, void *context) {
+    delete [] bytes;
   }
 
-  void Core::expirePosts () {
-    std::lock_guard<std::recursive_mutex> guard(postsMutex);
-    std::vector<uint64_t> ids;
-    auto now = std::chrono::system_clock::now()
-      .time_since_epoch()
-      .count();
+#if !defined(_WIN32)
+  static void unmapBufferBytes (char *bytes, size_t size, void *context) {
+    munmap(bytes, size);
+  }
+#endif
+
+  Buffer::Buffer (const Buffer &buffer) {
+    *this = buffer;
+  }
+
+  Buffer::Buffer (Buffer &&buffer) noexcept {
+    *this = std::move(buffer);
+  }
 
-    for (auto const &tuple : *posts) {
-      auto id = tuple.first;
-      auto post = tuple.second;
+  Buffer::~Buffer () {
+    this->reset();
+  }
 
-      if (post.ttl < now) {
-        ids.push_back(id);
+  Buffer& Buffer::operator= (const Buffer &buffer) {
+    if (this != &buffer) {
+      if (buffer.storage != nullptr) {
+        buffer.storage->references++;
       }
+
+      this->reset();
+      this->storage = buffer.storage;
+      this->bytes = buffer.bytes;
+      this->length = buffer.length;
     }
 
-    for (auto const id : ids) {
-      removePost(id);
+    return *this;
+  }
+
+  Buffer& Buffer::operator= (Buffer &&buffer) noexcept {
+    if (this != &buffer) {
+      this->reset();
+      this->storage = std::exchange(buffer.storage, nullptr);
+      this->bytes = std::exchange(buffer.bytes, nullptr);
+      this->length = std::exchange(buffer.length, 0);
     }
+
+    return *this;
   }
 
-  void Core::putPost (uint64_t id, Post p) {
-    std::lock_guard<std::recursive_mutex> guard(postsMutex);
-    p.ttl = std::chrono::time_point_cast<std::chrono::milliseconds>(
-      std::chrono::system_clock::now() +
-      std::chrono::milliseconds(32 * 1024)
-    )
-      .time_since_epoch()
-      .count();
-    posts->insert_or_assign(id, p);
+  Buffer::operator bool () const {
+    return this->storage != nullptr;
   }
 
-  void Core::removePost (uint64_t id) {
-    std::lock_guard<std::recursive_mutex> guard(postsMutex);
-    if (posts->find(id) == posts->end()) return;
-    auto post = getPost(id);
+  Buffer Buffer::heap (size_t size) {
+    return adopt(new char[size > 0 ? size : 1]{0}, size, deleteBufferBytes);
+  }
+
+  Buffer Buffer::copy (const char *bytes, size_t size) {
+    auto buffer = heap(size);
 
-    if (post.body && post.bodyNeedsFree) {
-      delete [] post.body;
-      post.bodyNeedsFree = false;
-      post.body = nullptr;
+    if (size > 0) {
+      memcpy(buffer.data(), bytes, size);
     }
 
-    posts->erase(id);
+    return buffer;
   }
 
-  String Core::createPost (String seq, String params, Post post) {
-    std::lock_guard<std::recursive_mutex> guard(postsMutex);
+  Buffer Buffer::copy (const String &string) {
+    return copy(string.data(), string.size());
+  }
+
+  Buffer Buffer::adopt (char *bytes, size_t size, Deallocator deallocator, void *context) {
+    Buffer buffer;
+    buffer.storage = new Storage();
+    buffer.storage->bytes = bytes;
+    buffer.storage->size = size;
+    buffer.storage->deallocator = deallocator;
+    buffer.storage->context = context;
+    buffer.bytes = bytes;
+    buffer.length = size;
+    return buffer;
+  }
+
+#if !defined(_WIN32)
+  // `offset` must be a multiple of the page size, returns an empty buffer
+  // if the mapping fails
+  Buffer Buffer::map (int fd, size_t size, off_t offset) {
+    auto bytes = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, offset);
+
+    if (bytes == MAP_FAILED) {
+      return Buffer();
+    }
+
+    return adopt((char *) bytes, size, unmapBufferBytes);
+  }
+#endif
+
+  char* Buffer::data () {
+    return this->bytes;
+  }
+
+  const char* Buffer::data () const {
+    return this->bytes;
+  }
+
+  size_t Buffer::size () const {
+    return this->length;
+  }
+
+  size_t Buffer::capacity () const {
+    return this->storage != nullptr ? this->storage->size : 0;
+  }
+
+  bool Buffer::unique () const {
+    return this->storage != nullptr && this->storage->references == 1;
+  }
+
+  Buffer Buffer::slice (size_t offset, size_t size) const {
+    Buffer buffer = *this;
+    offset = std::min(offset, this->length);
+    buffer.bytes = this->bytes + offset;
+    buffer.length = std::min(size, this->length - offset);
+    return buffer;
+  }
+
+  void Buffer::reset () {
+    unref(std::exchange(this->storage, nullptr));
+    this->bytes = nullptr;
+    this->length = 0;
+  }
+
+  void* Buffer::retain () const {
+    if (this->storage != nullptr) {
+      this->storage->references++;
+    }
+
+    return this->storage;
+  }
+
+  void Buffer::release (void *reference) {
+    unref(static_cast<Storage *>(reference));
+  }
+
+  void Buffer::unref (Storage *storage) {
+    if (storage == nullptr || --storage->references > 0) {
+      return;
+    }
+
+    if (storage->deallocator != nullptr) {
+      storage->deallocator(storage->bytes, storage->size, storage->context);
+    }
+
+    delete storage;
+  }
+
+  BufferPool::BufferPool (size_t blockSize, size_t maxFreeBlocks) {
+    this->state = new State();
+    this->state->blockSize = blockSize;
+    this->state->maxFreeBlocks = maxFreeBlocks;
+  }
+
+  BufferPool::~BufferPool () {
+    {
+      std::lock_guard<std::mutex> guard(this->state->mutex);
+      this->state->isClosed = true;
+
+      for (auto block : this->state->blocks) {
+        delete [] block;
+      }
+
+      this->state->blocks.clear();
+    }
+
+    unref(this->state);
+  }
+
+  Buffer BufferPool::acquire () {
+    char *block = nullptr;
+
+    {
+      std::lock_guard<std::mutex> guard(this->state->mutex);
+      if (this->state->blocks.size() > 0) {
+        block = this->state->blocks.back();
+        this->state->blocks.pop_back();
+      }
+    }
+
+    if (block == nullptr) {
+      block = new char[this->state->blockSize];
+    }
+
+    this->state->references++;
+    return Buffer::adopt(block, this->state->blockSize, recycle, this->state);
+  }
+
+  size_t BufferPool::getBlockSize () const {
+    return this->state->blockSize;
+  }
+
+  void BufferPool::recycle (char *bytes, size_t size, void *context) {
+    auto state = static_cast<State *>(context);
+
+    {
+      std::lock_guard<std::mutex> guard(state->mutex);
+      if (!state->isClosed && state->blocks.size() < state->maxFreeBlocks) {
+        state->blocks.push_back(bytes);
+        bytes = nullptr;
+      }
+    }
+
+    delete [] bytes;
+    unref(state);
+  }
+
+  void BufferPool::unref (State *state) {
+    if (--state->references == 0) {
+      delete state;
+    }
+  }
+
+  Posts::~Posts () {
+    this->clear();
+  }
+
+  uint64_t Posts::hash (uint64_t id) {
+    // ids are random or sequential, mix them so both spread over the table
+    id ^= id >> 33;
+    id *= 0xff51afd7ed558ccdULL;
+    id ^= id >> 33;
+    id *= 0xc4ceb9fe1a85ec53ULL;
+    id ^= id >> 33;
+    return id;
+  }
+
+  Posts::Shard& Posts::shard (uint64_t id) {
+    // the top bits pick the shard, the low bits the slot within it
+    return this->shards[hash(id) >> 60];
+  }
+
+  Posts::Slot* Posts::find (Shard &shard, uint64_t id) {
+    if (shard.slots.size() == 0) {
+      return nullptr;
+    }
+
+    auto mask = shard.slots.size() - 1;
+
+    for (auto i = hash(id) & mask;; i = (i + 1) & mask) {
+      auto &slot = shard.slots[i];
+
+      if (slot.state == POSTS_SLOT_EMPTY) {
+        return nullptr;
+      }
+
+      if (slot.state == POSTS_SLOT_FULL && slot.post.id == id) {
+        return &slot;
+      }
+    }
+  }
+
+  // makes room for one more post, keeping the load (tombstones included)
+  // under 3/4 so probes always reach an empty slot
+  void Posts::reserve (Shard &shard) {
+    auto capacity = shard.slots.size();
+
+    if (capacity > 0 && (shard.count + shard.deleted + 1) * 4 <= capacity * 3) {
+      return;
+    }
+
+    if (capacity == 0) {
+      capacity = MIN_CAPACITY;
+    } else if ((shard.count + 1) * 2 > capacity) {
+      capacity *= 2;
+    } // otherwise rehash in place to drop tombstones
+
+    std::vector<Slot> slots(capacity);
+    auto mask = capacity - 1;
+
+    for (auto &slot : shard.slots) {
+      if (slot.state != POSTS_SLOT_FULL) {
+        continue;
+      }
+
+      auto i = hash(slot.post.id) & mask;
+      while (slots[i].state != POSTS_SLOT_EMPTY) {
+        i = (i + 1) & mask;
+      }
+
+      slots[i].state = POSTS_SLOT_FULL;
+      slots[i].post = std::move(slot.post);
+    }
+
+    shard.slots = std::move(slots);
+    shard.deleted = 0;
+  }
+
+  Post Posts::erase (Shard &shard, Slot *slot) {
+    auto post = std::move(slot->post);
+
+    this->totalBytes -= post.body.capacity();
+    this->totalCount--;
+
+    slot->post = Post{};
+    slot->state = POSTS_SLOT_DELETED;
+    shard.count--;
+    shard.deleted++;
+
+    return post;
+  }
+
+  // drops stale expiries once they outnumber the live posts
+  void Posts::compact (Shard &shard) {
+    shard.expiries.clear();
+
+    for (auto &slot : shard.slots) {
+      if (slot.state == POSTS_SLOT_FULL) {
+        shard.expiries.push_back({ slot.post.ttl, slot.post.id });
+      }
+    }
+
+    std::make_heap(shard.expiries.begin(), shard.expiries.end(), std::greater<Expiry>());
+  }
+
+  void Posts::put (Post post) {
+    auto &shard = this->shard(post.id);
+    std::lock_guard<std::mutex> guard(shard.mutex);
+    // what is held in memory, a small slice can keep a large block alive
+    auto length = post.body.capacity();
+    auto slot = this->find(shard, post.id);
+
+    if (slot != nullptr) {
+      this->totalBytes -= slot->post.body.capacity();
+    } else {
+      this->reserve(shard);
+
+      auto mask = shard.slots.size() - 1;
+      auto i = hash(post.id) & mask;
+      while (shard.slots[i].state == POSTS_SLOT_FULL) {
+        i = (i + 1) & mask;
+      }
+
+      slot = &shard.slots[i];
+
+      if (slot->state == POSTS_SLOT_DELETED) {
+        shard.deleted--;
+      }
+
+      slot->state = POSTS_SLOT_FULL;
+      shard.count++;
+      this->totalCount++;
+    }
+
+    shard.expiries.push_back({ post.ttl, post.id });
+    std::push_heap(shard.expiries.begin(), shard.expiries.end(), std::greater<Expiry>());
+    slot->post = std::move(post);
+
+    auto bytes = (this->totalBytes += length);
+    auto peak = this->peakBytes.load();
+    while (bytes > peak && !this->peakBytes.compare_exchange_weak(peak, bytes)) {}
+
+    if (shard.expiries.size() > shard.count * 2 + MIN_CAPACITY) {
+      this->compact(shard);
+    }
+  }
+
+  bool Posts::has (uint64_t id) {
+    auto &shard = this->shard(id);
+    std::lock_guard<std::mutex> guard(shard.mutex);
+    return this->find(shard, id) != nullptr;
+  }
+
+  bool Posts::get (uint64_t id, Post &post) {
+    auto &shard = this->shard(id);
+    std::lock_guard<std::mutex> guard(shard.mutex);
+    auto slot = this->find(shard, id);
+
+    if (slot == nullptr) {
+      return false;
+    }
+
+    post = slot->post;
+    return true;
+  }
+
+  bool Posts::take (uint64_t id, Post &post) {
+    auto &shard = this->shard(id);
+    std::lock_guard<std::mutex> guard(shard.mutex);
+    auto slot = this->find(shard, id);
+
+    if (slot == nullptr) {
+      return false;
+    }
+
+    post = this->erase(shard, slot);
+    return true;
+  }
+
+  bool Posts::remove (uint64_t id) {
+    auto &shard = this->shard(id);
+    std::lock_guard<std::mutex> guard(shard.mutex);
+    auto slot = this->find(shard, id);
+
+    if (slot == nullptr) {
+      return false;
+    }
+
+    this->erase(shard, slot);
+    return true;
+  }
+
+  void Posts::clear () {
+    for (auto &shard : this->shards) {
+      std::lock_guard<std::mutex> guard(shard.mutex);
+
+      for (auto &slot : shard.slots) {
+        if (slot.state == POSTS_SLOT_FULL) {
+          this->erase(shard, &slot);
+        }
+      }
+
+      shard.slots.clear();
+      shard.expiries.clear();
+      shard.deleted = 0;
+    }
+  }
+
+  size_t Posts::expire (uint64_t now) {
+    size_t expired = 0;
+
+    for (auto &shard : this->shards) {
+      std::lock_guard<std::mutex> guard(shard.mutex);
+      auto &expiries = shard.expiries;
+
+      while (expiries.size() > 0 && expiries.front().first < now) {
+        auto expiry = expiries.front();
+        std::pop_heap(expiries.begin(), expiries.end(), std::greater<Expiry>());
+        expiries.pop_back();
+
+        auto slot = this->find(shard, expiry.second);
+        if (slot != nullptr && slot->post.ttl == expiry.first) {
+          this->erase(shard, slot);
+          expired++;
+        }
+      }
+    }
+
+    this->totalExpired += expired;
+    return expired;
+  }
+
+  size_t Posts::bytes () const {
+    return this->totalBytes.load();
+  }
+
+  Posts::Stats Posts::stats () const {
+    return Stats {
+      .count = this->totalCount.load(),
+      .bytes = this->totalBytes.load(),
+      .peakBytes = this->peakBytes.load(),
+      .expired = this->totalExpired.load()
+    };
+  }
+
+  BufferRegistry::BufferRegistry (size_t maxBytes) {
+    this->maxBytes = maxBytes;
+  }
+
+  std::optional<uint64_t> BufferRegistry::parseSeq (std::string_view seq) {
+    uint64_t value = 0;
+
+    if (seq.size() < 2 || seq[0] != 'R') {
+      return std::nullopt;
+    }
+
+    auto end = seq.data() + seq.size();
+    auto result = std::from_chars(seq.data() + 1, end, value);
+
+    if (result.ec != std::errc() || result.ptr != end) {
+      return std::nullopt;
+    }
+
+    return value;
+  }
+
+  // drops the oldest entry if it expired by `now` (or regardless if
+  // `force`), false once there is nothing left to drop
+  bool BufferRegistry::evict (uint64_t now, bool force) {
+    while (this->expiries.size() > 0) {
+      auto expiry = this->expiries.front();
+
+      if (!force && expiry.expires >= now) {
+        return false;
+      }
+
+      this->expiries.pop_front();
+
+      auto entry = this->entries.find(expiry.key);
+      if (entry != this->entries.end() && entry->second.serial == expiry.serial) {
+        this->totalBytes -= entry->second.buffer.size();
+        this->entries.erase(entry);
+        return true;
+      }
+    }
+
+    return false;
+  }
+
+  // drops expiries of entries already taken or replaced from the front, so
+  // bodies taken in the order they came in leave nothing behind
+  void BufferRegistry::trim () {
+    while (this->expiries.size() > 0) {
+      const auto &expiry = this->expiries.front();
+      auto entry = this->entries.find(expiry.key);
+
+      if (entry != this->entries.end() && entry->second.serial == expiry.serial) {
+        return;
+      }
+
+      this->expiries.pop_front();
+    }
+  }
+
+  bool BufferRegistry::put (int index, uint64_t seq, Buffer buffer) {
+    std::lock_guard<std::mutex> guard(this->mutex);
+    auto now = nowInMilliseconds();
+    auto size = buffer.size();
+
+    if (size > this->maxBytes) {
+      return false;
+    }
+
+    while (this->evict(now, false)) {}
+
+    auto key = Key { index, seq };
+    auto existing = this->entries.find(key);
+
+    if (existing != this->entries.end()) {
+      this->totalBytes -= existing->second.buffer.size();
+      this->entries.erase(existing);
+    }
+
+    while (this->totalBytes + size > this->maxBytes && this->evict(now, true)) {}
+
+    auto serial = ++this->nextSerial;
+    this->entries[key] = Entry { std::move(buffer), serial };
+    this->expiries.push_back(Expiry { now + BUFFER_REGISTRY_TTL, serial, key });
+    this->totalBytes += size;
+    this->trim();
+
+    return true;
+  }
+
+  bool BufferRegistry::take (int index, uint64_t seq, Buffer &buffer) {
+    std::lock_guard<std::mutex> guard(this->mutex);
+    auto entry = this->entries.find(Key { index, seq });
+
+    if (entry == this->entries.end()) {
+      return false;
+    }
+
+    buffer = std::move(entry->second.buffer);
+    this->totalBytes -= buffer.size();
+    this->entries.erase(entry);
+    this->trim();
+
+    return true;
+  }
+
+  size_t BufferRegistry::expire (uint64_t now) {
+    std::lock_guard<std::mutex> guard(this->mutex);
+    size_t expired = 0;
 
+    while (this->evict(now, false)) {
+      expired++;
+    }
+
+    return expired;
+  }
+
+  size_t BufferRegistry::bytes () {
+    std::lock_guard<std::mutex> guard(this->mutex);
+    return this->totalBytes;
+  }
+
+  Post Core::getPost (uint64_t id) {
+    Post post;
+    posts->get(id, post);
+    return post;
+  }
+
+  bool Core::hasPost (uint64_t id) {
+    return posts->has(id);
+  }
+
+  void Core::expirePosts () {
+    posts->expire(nowInMilliseconds());
+    updatePostsBudget();
+  }
+
+  void Core::putPost (uint64_t id, Post p) {
+    p.id = id;
+    p.ttl = nowInMilliseconds() + POSTS_TTL;
+    posts->put(std::move(p));
+    updatePostsBudget();
+  }
+
+  bool Core::takePost (uint64_t id, Post &post) {
+    auto taken = posts->take(id, post);
+    updatePostsBudget();
+    return taken;
+  }
+
+  void Core::removePost (uint64_t id) {
+    posts->remove(id);
+    updatePostsBudget();
+  }
+
+  String Core::createPost (String seq, String params, Post post) {
     if (post.id == 0) {
       post.id = SSC::rand64();
     }
@@ -142,24 +699,54 @@ namespace SSC {
   }
 
   void Core::removeAllPosts () {
-    std::lock_guard<std::recursive_mutex> guard(postsMutex);
-    std::vector<uint64_t> ids;
+    posts->clear();
+    updatePostsBudget();
+  }
 
-    for (auto const &tuple : *posts) {
-      auto id = tuple.first;
-      ids.push_back(id);
-    }
+  // pauses UDP receive while post bodies are over budget, with some
+  // headroom before it resumes so it does not flap
+  void Core::updatePostsBudget () {
+    auto bytes = posts->bytes();
 
-    for (auto const id : ids) {
-      removePost(id);
+    if (bytes > SSC_POSTS_MAX_BYTES) {
+      if (!isPostsOverBudget.exchange(true)) {
+        debug("posts: %zu bytes over budget, pausing receive", bytes);
+        applyPostsBackPressure();
+      }
+    } else if (bytes <= SSC_POSTS_MAX_BYTES / 4 * 3) {
+      if (isPostsOverBudget.exchange(false)) {
+        applyPostsBackPressure();
+      }
     }
   }
 
+  String Core::getPostsStats () {
+    auto stats = posts->stats();
+
+    return SSC::format(R"MSG({
+      "source": "posts.stats",
+      "data": {
+        "count": $S,
+        "bytes": $S,
+        "peakBytes": $S,
+        "maxBytes": $S,
+        "expired": $S,
+        "overBudget": $S
+      }
+    })MSG",
+      std::to_string(stats.count),
+      std::to_string(stats.bytes),
+      std::to_string(stats.peakBytes),
+      std::to_string((size_t) SSC_POSTS_MAX_BYTES),
+      std::to_string(stats.expired),
+      String(isPostsOverBudget ? "true" : "false")
+    );
+  }
+
   String Core::getNetworkInterfaces () const {
     uv_interface_address_t *infos = nullptr;
-    StringStream value;
-    StringStream v4;
-    StringStream v6;
+    JSONWriter v4;
+    JSONWriter v6;
     int count = 0;
 
     int rc = uv_interface_addresses(&infos, &count);
@@ -169,8 +756,8 @@ namespace SSC {
     }
 
     debug("count=%lu", count);
-    v4 << "\"ipv4\":{";
-    v6 << "\"ipv6\":{";
+    v4.beginObject();
+    v6.beginObject();
 
     for (int i = 0; i < count; ++i) {
       uv_interface_address_t info = infos[i];
@@ -186,34 +773,40 @@ namespace SSC {
       );
 
       if (addr->sin_family == AF_INET) {
-        v4 << "\"" << String(info.name) << "\":{";
-        v4 << "\"address\":\"" << SSC::addrToIPv4(addr) << "\",";
-        v4 << "\"mac\":\"" << String(mac, 17) << "\",";
-        v4 << "\"internal\":" << String(info.is_internal == 0 ? "false" : "true") << "";
-        v4 << "},";
+        v4.key(info.name).beginObject()
+          .value("address", SSC::addrToIPv4(addr))
+          .value("mac", std::string_view(mac, 17))
+          .value("internal", info.is_internal != 0)
+          .endObject();
       }
 
       if (addr->sin_family == AF_INET6) {
-        v6 << "\"" << String(info.name) << "\":\{";
-        v6 << "\"address\":\"" << SSC::addrToIPv6((struct sockaddr_in6*) addr) << "\",";
-        v6 << "\"mac\":\"" << String(mac, 17) << "\",";
-        v6 << "\"internal\":" << String(info.is_internal == 0 ? "false" : "true") << "";
-        v6 << "},";
+        v6.key(info.name).beginObject()
+          .value("address", SSC::addrToIPv6((struct sockaddr_in6*) addr))
+          .value("mac", std::string_view(mac, 17))
+          .value("internal", info.is_internal != 0)
+          .endObject();
       }
     }
 
     uv_free_interface_addresses(infos, count);
 
-    v4 << "\"local\":\"0.0.0.0\"}";
-    v6 << "\"local\":\"::1\"}";
+    v4.value("local", "0.0.0.0").endObject();
+    v6.value("local", "::1").endObject();
 
-    value << "{\"data\":{" << v4.str() << "," << v6.str() << "}}";
+    JSONWriter value(v4.output.size() + v6.output.size() + 32);
+    value.beginObject()
+      .key("data").beginObject()
+        .key("ipv4").raw(v4.output)
+        .key("ipv6").raw(v6.output)
+      .endObject()
+    .endObject();
 
     return value.str();
   }
 
   void Core::dnsLookup (String seq, String hostname, int family, Callback cb) {
-    dispatchEventLoop([=, this]() {
+    dispatchEventLoop(EVENT_LOOP_PRIORITY_NORMAL, "dns.lookup", [=, this]() {
       auto ctx = new PeerRequestContext(seq, cb);
       auto loop = getEventLoop();
 
@@ -318,7 +911,7 @@ namespace SSC {
       buffer = 1;
     }
 
-    dispatchEventLoop([=, this]() {
+    dispatchEventLoop(EVENT_LOOP_PRIORITY_REALTIME, "bufferSize", peerId, [=, this]() {
       auto peer = getPeer(peerId);
 
       if (peer == nullptr) {
@@ -368,7 +961,7 @@ namespace SSC {
   }
 
   void Core::close (String seq, uint64_t peerId, Callback cb) {
-    dispatchEventLoop([=, this]() {
+    dispatchEventLoop(EVENT_LOOP_PRIORITY_REALTIME, "close", peerId, [=, this]() {
       if (!hasPeer(peerId)) {
         auto msg = SSC::format(R"MSG({
           "source": "close",
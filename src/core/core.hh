@@ -19,27 +19,972 @@
 #include "win.hh"
 #endif
 
+// When enabled, the event loop thread blocks in `uv_run(UV_RUN_DEFAULT)`,
+// kept alive by `eventLoopAsync`, and is only woken by `uv_async_send()`.
+// Define as `0` to fall back to sleeping `EVENT_LOOP_POLL_TIMEOUT` between runs.
+#ifndef SSC_EVENT_LOOP_BLOCKING
+#define SSC_EVENT_LOOP_BLOCKING 1
+#endif
+
+// On Linux the event loop is driven by a `GSource` attached to the GTK main
+// context by default. Define as `1` to run it on a dedicated `eventLoopThread`
+// (like every other platform) so a busy UI thread can't stall I/O callbacks.
+#ifndef SSC_LINUX_EVENT_LOOP_THREAD
+#define SSC_LINUX_EVENT_LOOP_THREAD 0
+#endif
+
+// Number of event loops `Core` runs. Loop `0` is the primary loop above and
+// every other loop runs on its own thread. Peers and descriptors are pinned
+// to a loop by a hash of their id, so sockets and files spread across cores.
+// Define as `0` to run one loop per hardware thread.
+#ifndef SSC_EVENT_LOOP_COUNT
+#define SSC_EVENT_LOOP_COUNT 1
+#endif
+
+// Dispatched callbacks running on an event loop for at least this long are
+// counted as stalls, reported by `loop.stats` and logged in debug builds.
+#ifndef SSC_EVENT_LOOP_STALL_THRESHOLD
+#define SSC_EVENT_LOOP_STALL_THRESHOLD 50 // in milliseconds
+#endif
+
+// Total bytes of post bodies held before UDP receive is paused, it resumes
+// once the webview has drained them below 3/4 of this budget.
+#ifndef SSC_POSTS_MAX_BYTES
+#define SSC_POSTS_MAX_BYTES (64 * 1024 * 1024)
+#endif
+
+// Total bytes of request bodies held for commands that have not arrived
+// yet, the oldest are dropped to make room past this.
+#ifndef SSC_BUFFER_REGISTRY_MAX_BYTES
+#define SSC_BUFFER_REGISTRY_MAX_BYTES (64 * 1024 * 1024)
+#endif
+
+#if defined(__linux__) && !defined(__ANDROID__) && !SSC_LINUX_EVENT_LOOP_THREAD
+#define SSC_EVENT_LOOP_GSOURCE 1
+#else
+#define SSC_EVENT_LOOP_GSOURCE 0
+#endif
+
 namespace SSC {
   constexpr int EVENT_LOOP_POLL_TIMEOUT = 32; // in milliseconds
+  constexpr int EVENT_LOOP_DISPATCH_BATCH_SIZE = 64; // callbacks per wakeup
+  constexpr int EVENT_LOOP_STATS_DUMP_INTERVAL = 10000; // in milliseconds
+  constexpr uint64_t POSTS_TTL = 32 * 1024; // in milliseconds
+  constexpr uint64_t BUFFER_REGISTRY_TTL = 32 * 1024; // in milliseconds
+  constexpr size_t UDP_RECV_BUFFER_SIZE = 64 * 1024;
+  constexpr size_t UDP_RECV_BUFFER_POOL_SIZE = 64; // free blocks kept
+  constexpr size_t FS_READ_STREAM_CHUNK_SIZE = 256 * 1024;
+  constexpr size_t FS_READ_STREAM_BUFFER_POOL_SIZE = 16; // free blocks kept
+  constexpr size_t FS_REQUEST_CONTEXT_POOL_SIZE = 64; // free contexts kept, per loop
+  constexpr size_t FS_READDIR_REQUEST_CONTEXT_POOL_SIZE = 8; // free contexts kept, per loop
+  constexpr size_t FS_READDIR_MAX_ENTRIES = 256; // DirectoryHandle.MAX_BUFFER_SIZE
+  constexpr size_t FS_IOV_MAX = 64; // buffers per `uv_fs_read()`/`uv_fs_write()`
 
   // forward
   class Core;
   struct Peer;
   struct Descriptor;
 
+  /**
+   * An immutable, reference counted run of bytes. Copies and slices share
+   * the same storage, which is handed back to its deallocator once the last
+   * of them is gone. Bytes may only be written through `data()` before the
+   * buffer is shared.
+   */
+  class Buffer {
+    public:
+      // called with the storage, its size and the context given to `adopt()`
+      using Deallocator = void (*)(char *bytes, size_t size, void *context);
+
+      Buffer () = default;
+      Buffer (const Buffer &buffer);
+      Buffer (Buffer &&buffer) noexcept;
+      ~Buffer ();
+
+      Buffer& operator= (const Buffer &buffer);
+      Buffer& operator= (Buffer &&buffer) noexcept;
+      explicit operator bool () const;
+
+      static Buffer heap (size_t size);
+      static Buffer copy (const char *bytes, size_t size);
+      static Buffer copy (const String &string);
+      static Buffer adopt (char *bytes, size_t size, Deallocator deallocator, void *context = nullptr);
+#if !defined(_WIN32)
+      static Buffer map (int fd, size_t size, off_t offset);
+#endif
+
+      char* data ();
+      const char* data () const;
+      size_t size () const;
+      size_t capacity () const;
+      bool unique () const;
+      Buffer slice (size_t offset, size_t size) const;
+      void reset ();
+
+      // an owned reference for C APIs that take a context and a destroy
+      // function (such as `GDestroyNotify`), dropped with `release()`
+      void* retain () const;
+      static void release (void *reference);
+
+    private:
+      struct Storage {
+        std::atomic<size_t> references = 1;
+        char *bytes = nullptr;
+        size_t size = 0;
+        Deallocator deallocator = nullptr;
+        void *context = nullptr;
+      };
+
+      Storage *storage = nullptr;
+      char *bytes = nullptr;
+      size_t length = 0;
+
+      static void unref (Storage *storage);
+  };
+
+  /**
+   * Fixed size blocks handed out as `Buffer`s, which go back on the free
+   * list when released. Blocks released after the pool is gone are freed.
+   */
+  class BufferPool {
+    public:
+      BufferPool (size_t blockSize, size_t maxFreeBlocks);
+      BufferPool (const BufferPool &pool) = delete;
+      ~BufferPool ();
+
+      Buffer acquire ();
+      size_t getBlockSize () const;
+
+    private:
+      // shared with outstanding blocks, freed with the last of them
+      struct State {
+        std::mutex mutex;
+        std::vector<char *> blocks;
+        std::atomic<size_t> references = 1;
+        size_t blockSize = 0;
+        size_t maxFreeBlocks = 0;
+        bool isClosed = false;
+      };
+
+      State *state = nullptr;
+
+      static void recycle (char *bytes, size_t size, void *context);
+      static void unref (State *state);
+  };
+
   struct Post {
     uint64_t id = 0;
     uint64_t ttl = 0;
-    char* body = nullptr;
-    int length = 0;
+    Buffer body;
     String headers = "";
-    bool bodyNeedsFree = false;
   };
 
-  using Posts = std::map<ID, Post>;
+  /**
+   * Posts waiting to be fetched by the webview, sharded by id. Each shard is
+   * an open addressing table over one contiguous slab of entries with an
+   * expiry min-heap beside it, so `expire()` never walks live posts.
+   */
+  class Posts {
+    public:
+      static constexpr size_t SHARDS = 16;
+      static constexpr size_t MIN_CAPACITY = 16; // per shard, a power of 2
+
+      struct Stats {
+        size_t count = 0;
+        size_t bytes = 0;
+        size_t peakBytes = 0;
+        uint64_t expired = 0;
+      };
+
+      ~Posts ();
+
+      void put (Post post);
+      bool has (uint64_t id);
+      bool get (uint64_t id, Post &post);
+      bool take (uint64_t id, Post &post);
+      bool remove (uint64_t id);
+      void clear ();
+      size_t expire (uint64_t now);
+      size_t bytes () const;
+      Stats stats () const;
+
+    private:
+      typedef enum {
+        POSTS_SLOT_EMPTY = 0,
+        POSTS_SLOT_FULL = 1,
+        POSTS_SLOT_DELETED = 2
+      } posts_slot_state_t;
+
+      struct Slot {
+        posts_slot_state_t state = POSTS_SLOT_EMPTY;
+        Post post;
+      };
+
+      // (expires, id), stale once the post is gone or replaced
+      using Expiry = std::pair<uint64_t, uint64_t>;
+
+      struct Shard {
+        std::mutex mutex;
+        std::vector<Slot> slots;
+        std::vector<Expiry> expiries;
+        size_t count = 0;
+        size_t deleted = 0;
+      };
+
+      Shard shards[SHARDS];
+      std::atomic<size_t> totalCount = 0;
+      std::atomic<size_t> totalBytes = 0;
+      std::atomic<size_t> peakBytes = 0;
+      std::atomic<uint64_t> totalExpired = 0;
+
+      static uint64_t hash (uint64_t id);
+      Shard& shard (uint64_t id);
+      Slot* find (Shard &shard, uint64_t id);
+      void reserve (Shard &shard);
+      Post erase (Shard &shard, Slot *slot);
+      void compact (Shard &shard);
+  };
+
+  /**
+   * Request bodies sent ahead of the command that uses them, keyed by window
+   * index and sequence number. Bodies are moved in and out, never copied.
+   * Entries nobody takes expire after `BUFFER_REGISTRY_TTL`, and the oldest
+   * are evicted to stay under `maxBytes`. Safe to use from any thread.
+   */
+  class BufferRegistry {
+    public:
+      BufferRegistry (size_t maxBytes = SSC_BUFFER_REGISTRY_MAX_BYTES);
+
+      bool put (int index, uint64_t seq, Buffer buffer);
+      bool take (int index, uint64_t seq, Buffer &buffer);
+      size_t expire (uint64_t now);
+      size_t bytes ();
+
+      // the number in a `R<n>` sequence
+      static std::optional<uint64_t> parseSeq (std::string_view seq);
+
+    private:
+      using Key = std::pair<int, uint64_t>;
+
+      struct Entry {
+        Buffer buffer;
+        uint64_t serial = 0;
+      };
+
+      // (expires, serial, key) in insertion order, which is also expiry
+      // order, stale once the entry is gone or replaced
+      struct Expiry {
+        uint64_t expires;
+        uint64_t serial;
+        Key key;
+      };
+
+      std::mutex mutex;
+      std::map<Key, Entry> entries;
+      std::deque<Expiry> expiries;
+      size_t maxBytes = 0;
+      size_t totalBytes = 0;
+      uint64_t nextSerial = 0;
+
+      bool evict (uint64_t now, bool force);
+      void trim ();
+  };
+
+  /**
+   * Pointers keyed by caller chosen ids (such as peer and descriptor ids
+   * from the runtime). Values live in one dense array, so walking them
+   * touches contiguous memory, and an id reaches its slot with a single
+   * hash lookup. A slot's generation changes each time it is freed, so a
+   * `Handle` held across calls never resolves to a later value reusing the
+   * slot. Reads share a lock, writes take it exclusively.
+   */
+  template <typename T> class SlotMap {
+    public:
+      // generation (high 32 bits) and slot (low 32 bits), never 0
+      using Handle = uint64_t;
+
+      T* get (uint64_t id) const {
+        std::shared_lock<std::shared_mutex> lock(this->mutex);
+        auto slot = this->index.find(id);
+
+        if (slot == this->index.end()) {
+          return nullptr;
+        }
+
+        return this->entries[this->slots[slot->second].entry].value;
+      }
+
+      bool has (uint64_t id) const {
+        std::shared_lock<std::shared_mutex> lock(this->mutex);
+        return this->index.find(id) != this->index.end();
+      }
+
+      T* resolve (Handle handle) const {
+        std::shared_lock<std::shared_mutex> lock(this->mutex);
+        auto index = (uint32_t) (handle & 0xffffffff);
+        auto generation = (uint32_t) (handle >> 32);
+
+        if (index >= this->slots.size()) {
+          return nullptr;
+        }
+
+        const auto &slot = this->slots[index];
+
+        if (!slot.isUsed || slot.generation != generation) {
+          return nullptr;
+        }
+
+        return this->entries[slot.entry].value;
+      }
+
+      Handle set (uint64_t id, T *value) {
+        std::unique_lock<std::shared_mutex> lock(this->mutex);
+        auto existing = this->index.find(id);
+
+        if (existing != this->index.end()) {
+          auto &slot = this->slots[existing->second];
+          this->entries[slot.entry].value = value;
+          return this->getHandle(existing->second);
+        }
+
+        uint32_t index = 0;
+
+        if (this->freeSlots.size() > 0) {
+          index = this->freeSlots.back();
+          this->freeSlots.pop_back();
+        } else {
+          index = (uint32_t) this->slots.size();
+          this->slots.push_back(Slot {});
+        }
+
+        auto &slot = this->slots[index];
+        slot.entry = (uint32_t) this->entries.size();
+        slot.isUsed = true;
+
+        this->entries.push_back(Entry { id, value, index });
+        this->index[id] = index;
+
+        return this->getHandle(index);
+      }
+
+      T* remove (uint64_t id) {
+        std::unique_lock<std::shared_mutex> lock(this->mutex);
+        auto existing = this->index.find(id);
+
+        if (existing == this->index.end()) {
+          return nullptr;
+        }
+
+        auto index = existing->second;
+        auto &slot = this->slots[index];
+        auto value = this->entries[slot.entry].value;
+
+        // the last entry fills the gap, which keeps `entries` dense
+        this->entries[slot.entry] = this->entries.back();
+        this->slots[this->entries[slot.entry].slot].entry = slot.entry;
+        this->entries.pop_back();
+
+        slot.generation++;
+        slot.isUsed = false;
+        this->freeSlots.push_back(index);
+        this->index.erase(existing);
+
+        return value;
+      }
+
+      // handles of everything held now, for walks that add or remove
+      std::vector<Handle> handles () const {
+        std::shared_lock<std::shared_mutex> lock(this->mutex);
+        std::vector<Handle> handles;
+
+        handles.reserve(this->entries.size());
+
+        for (const auto &entry : this->entries) {
+          handles.push_back(this->getHandle(entry.slot));
+        }
+
+        return handles;
+      }
+
+      // calls `fn(id, value)` under the read lock, so `fn` must not add or
+      // remove values (use `handles()` for that)
+      template <typename F> void forEach (const F &fn) const {
+        std::shared_lock<std::shared_mutex> lock(this->mutex);
+
+        for (const auto &entry : this->entries) {
+          fn(entry.id, entry.value);
+        }
+      }
+
+      size_t size () const {
+        std::shared_lock<std::shared_mutex> lock(this->mutex);
+        return this->entries.size();
+      }
+
+    private:
+      struct Slot {
+        uint32_t generation = 1;
+        uint32_t entry = 0; // in `entries`
+        bool isUsed = false;
+      };
+
+      struct Entry {
+        uint64_t id;
+        T *value;
+        uint32_t slot; // in `slots`
+      };
+
+      mutable std::shared_mutex mutex;
+      std::vector<Slot> slots;
+      std::vector<uint32_t> freeSlots;
+      std::vector<Entry> entries;
+      std::unordered_map<uint64_t, uint32_t> index;
+
+      Handle getHandle (uint32_t index) const {
+        return ((uint64_t) this->slots[index].generation << 32) | index;
+      }
+  };
+
+  /**
+   * A freelist of request contexts owned by one event loop. `acquire()` and
+   * `release()` must only be called on that loop, so neither locks. Released
+   * contexts are `reset()` and kept (up to `maxFreeContexts`) along with
+   * whatever storage they grew. The counters may be read from any thread.
+   */
+  template <typename T> class RequestContextPool {
+    std::vector<T *> contexts;
+    size_t maxFreeContexts = 0;
+
+    public:
+      std::atomic<uint64_t> allocations = 0;
+      std::atomic<uint64_t> acquisitions = 0;
+
+      RequestContextPool (size_t maxFreeContexts)
+        : maxFreeContexts(maxFreeContexts) {}
+
+      RequestContextPool (const RequestContextPool &pool) = delete;
+
+      ~RequestContextPool () {
+        for (auto context : this->contexts) {
+          delete context;
+        }
+      }
+
+      T * acquire () {
+        T *context = nullptr;
+
+        if (this->contexts.empty()) {
+          context = new T();
+          this->allocations++;
+        } else {
+          context = this->contexts.back();
+          this->contexts.pop_back();
+        }
+
+        this->acquisitions++;
+        context->pool = this;
+        context->req.data = (void *) context;
+        return context;
+      }
+
+      void release (T *context) {
+        context->reset();
+
+        if (this->contexts.size() < this->maxFreeContexts) {
+          this->contexts.push_back(context);
+        } else {
+          delete context;
+        }
+      }
+  };
+
   using Callback = std::function<void(String, String, Post)>;
   using EventLoopDispatchCallback = std::function<void()>;
 
+  /**
+   * A lock-free, unbounded, multi-producer/single-consumer queue.
+   * Any thread may `push()`, but only one thread (the event loop)
+   * may `pop()` at a time.
+   * @see https://www.1024cores.net/home/lock-free-algorithms/queues/non-intrusive-mpsc-node-based-queue
+   */
+  template <typename T> class MPSCQueue {
+    struct Node {
+      std::atomic<Node*> next = nullptr;
+      T value;
+    };
+
+    // producers swap themselves in at `head`, consumer reads from `tail`
+    std::atomic<Node*> head;
+    Node* tail;
+    std::atomic<size_t> count = 0;
+
+    public:
+      MPSCQueue () {
+        auto stub = new Node();
+        this->head = stub;
+        this->tail = stub;
+      }
+
+      ~MPSCQueue () {
+        T value;
+        while (this->pop(value)) {}
+        delete this->tail;
+      }
+
+      MPSCQueue (const MPSCQueue&) = delete;
+      MPSCQueue& operator = (const MPSCQueue&) = delete;
+
+      void push (T value) {
+        auto node = new Node();
+        node->value = std::move(value);
+        this->count.fetch_add(1, std::memory_order_relaxed);
+        auto prev = this->head.exchange(node, std::memory_order_acq_rel);
+        prev->next.store(node, std::memory_order_release);
+      }
+
+      bool pop (T& value) {
+        auto tail = this->tail;
+        auto next = tail->next.load(std::memory_order_acquire);
+
+        // empty, or a producer is between `exchange()` and `store()`
+        if (next == nullptr) {
+          return false;
+        }
+
+        value = std::move(next->value);
+        next->value = T{};
+        this->tail = next;
+        this->count.fetch_sub(1, std::memory_order_relaxed);
+        delete tail;
+        return true;
+      }
+
+      bool empty () const {
+        return this->tail->next.load(std::memory_order_acquire) == nullptr;
+      }
+
+      size_t size () const {
+        return this->count.load(std::memory_order_relaxed);
+      }
+  };
+
+  /**
+   * Every command routed by the platform bridges. Legacy names are aliases
+   * in `COMMAND_NAMES` and resolve to the same command.
+   */
+  typedef enum {
+    COMMAND_UNKNOWN = 0,
+    COMMAND_BATCH,
+    COMMAND_BLUETOOTH_PUBLISH,
+    COMMAND_BLUETOOTH_START,
+    COMMAND_BLUETOOTH_SUBSCRIBE,
+    COMMAND_BUFFER_QUEUE,
+    COMMAND_BUFFER_SIZE,
+    COMMAND_COMMANDS_STATS,
+    COMMAND_DNS_LOOKUP,
+    COMMAND_EVENT,
+    COMMAND_FS_ACCESS,
+    COMMAND_FS_CHMOD,
+    COMMAND_FS_CLOSE,
+    COMMAND_FS_CLOSE_OPEN_DESCRIPTOR,
+    COMMAND_FS_CLOSE_OPEN_DESCRIPTORS,
+    COMMAND_FS_CLOSEDIR,
+    COMMAND_FS_CONSTANTS,
+    COMMAND_FS_COPY_FILE,
+    COMMAND_FS_FSTAT,
+    COMMAND_FS_GET_OPEN_DESCRIPTORS,
+    COMMAND_FS_MKDIR,
+    COMMAND_FS_OPEN,
+    COMMAND_FS_OPENDIR,
+    COMMAND_FS_READ,
+    COMMAND_FS_READ_STREAM,
+    COMMAND_FS_READDIR,
+    COMMAND_FS_READV,
+    COMMAND_FS_RENAME,
+    COMMAND_FS_RETAIN_OPEN_DESCRIPTOR,
+    COMMAND_FS_RMDIR,
+    COMMAND_FS_STAT,
+    COMMAND_FS_UNLINK,
+    COMMAND_FS_WRITE,
+    COMMAND_FS_WRITEV,
+    COMMAND_IPC_NEGOTIATE,
+    COMMAND_IPC_STATS,
+    COMMAND_LOG,
+    COMMAND_LOOP_STATS,
+    COMMAND_NOTIFY,
+    COMMAND_OPEN_EXTERNAL,
+    COMMAND_OS_ARCH,
+    COMMAND_OS_NETWORK_INTERFACES,
+    COMMAND_OS_PLATFORM,
+    COMMAND_OS_TYPE,
+    COMMAND_POST,
+    COMMAND_POSTS_STATS,
+    COMMAND_PROCESS_CWD,
+    COMMAND_TIMER_CLEAR,
+    COMMAND_TIMER_SET,
+    COMMAND_UDP_BIND,
+    COMMAND_UDP_CLOSE,
+    COMMAND_UDP_CONNECT,
+    COMMAND_UDP_DISCONNECT,
+    COMMAND_UDP_GET_PEER_NAME,
+    COMMAND_UDP_GET_SOCK_NAME,
+    COMMAND_UDP_GET_STATE,
+    COMMAND_UDP_READ_START,
+    COMMAND_UDP_READ_STOP,
+    COMMAND_UDP_SEND,
+    COMMAND_WINDOW_EVAL,
+    COMMAND_COUNT
+  } command_t;
+
+  struct CommandName {
+    std::string_view name;
+    command_t command;
+  };
+
+  // the first name of a command is the one it is reported as
+  constexpr CommandName COMMAND_NAMES[] = {
+    { "batch", COMMAND_BATCH },
+    { "bluetooth.publish", COMMAND_BLUETOOTH_PUBLISH },
+    { "bluetooth-publish", COMMAND_BLUETOOTH_PUBLISH },
+    { "bluetooth.start", COMMAND_BLUETOOTH_START },
+    { "bluetooth-start", COMMAND_BLUETOOTH_START },
+    { "bluetooth.subscribe", COMMAND_BLUETOOTH_SUBSCRIBE },
+    { "bluetooth-subscribe", COMMAND_BLUETOOTH_SUBSCRIBE },
+    { "buffer.queue", COMMAND_BUFFER_QUEUE },
+    { "bufferSize", COMMAND_BUFFER_SIZE },
+    { "commands.stats", COMMAND_COMMANDS_STATS },
+    { "dns.lookup", COMMAND_DNS_LOOKUP },
+    { "dnsLookup", COMMAND_DNS_LOOKUP },
+    { "event", COMMAND_EVENT },
+    { "fs.access", COMMAND_FS_ACCESS },
+    { "fsAccess", COMMAND_FS_ACCESS },
+    { "fs.chmod", COMMAND_FS_CHMOD },
+    { "fsChmod", COMMAND_FS_CHMOD },
+    { "fs.close", COMMAND_FS_CLOSE },
+    { "fsClose", COMMAND_FS_CLOSE },
+    { "fs.closeOpenDescriptor", COMMAND_FS_CLOSE_OPEN_DESCRIPTOR },
+    { "fsCloseOpenDescriptor", COMMAND_FS_CLOSE_OPEN_DESCRIPTOR },
+    { "fs.closeOpenDescriptors", COMMAND_FS_CLOSE_OPEN_DESCRIPTORS },
+    { "fsCloseOpenDescriptors", COMMAND_FS_CLOSE_OPEN_DESCRIPTORS },
+    { "fs.closedir", COMMAND_FS_CLOSEDIR },
+    { "fsClosedir", COMMAND_FS_CLOSEDIR },
+    { "fs.constants", COMMAND_FS_CONSTANTS },
+    { "getFSConstants", COMMAND_FS_CONSTANTS },
+    { "fs.copyFile", COMMAND_FS_COPY_FILE },
+    { "fsCopyFile", COMMAND_FS_COPY_FILE },
+    { "fs.fstat", COMMAND_FS_FSTAT },
+    { "fsFStat", COMMAND_FS_FSTAT },
+    { "fs.getOpenDescriptors", COMMAND_FS_GET_OPEN_DESCRIPTORS },
+    { "fsGetOpenDescriptors", COMMAND_FS_GET_OPEN_DESCRIPTORS },
+    { "fs.mkdir", COMMAND_FS_MKDIR },
+    { "fsMkdir", COMMAND_FS_MKDIR },
+    { "fs.open", COMMAND_FS_OPEN },
+    { "fsOpen", COMMAND_FS_OPEN },
+    { "fs.opendir", COMMAND_FS_OPENDIR },
+    { "fsOpendir", COMMAND_FS_OPENDIR },
+    { "fs.read", COMMAND_FS_READ },
+    { "fsRead", COMMAND_FS_READ },
+    { "fs.readStream", COMMAND_FS_READ_STREAM },
+    { "fsReadStream", COMMAND_FS_READ_STREAM },
+    { "fs.readdir", COMMAND_FS_READDIR },
+    { "fsReaddir", COMMAND_FS_READDIR },
+    { "fs.readv", COMMAND_FS_READV },
+    { "fsReadv", COMMAND_FS_READV },
+    { "fs.rename", COMMAND_FS_RENAME },
+    { "fsRename", COMMAND_FS_RENAME },
+    { "fs.retainOpenDescriptor", COMMAND_FS_RETAIN_OPEN_DESCRIPTOR },
+    { "fsRetainOpenDescriptor", COMMAND_FS_RETAIN_OPEN_DESCRIPTOR },
+    { "fs.rmdir", COMMAND_FS_RMDIR },
+    { "fsRmdir", COMMAND_FS_RMDIR },
+    { "fs.stat", COMMAND_FS_STAT },
+    { "fsStat", COMMAND_FS_STAT },
+    { "fs.unlink", COMMAND_FS_UNLINK },
+    { "fsUnlink", COMMAND_FS_UNLINK },
+    { "fs.write", COMMAND_FS_WRITE },
+    { "fsWrite", COMMAND_FS_WRITE },
+    { "fs.writev", COMMAND_FS_WRITEV },
+    { "fsWritev", COMMAND_FS_WRITEV },
+    { "ipc.negotiate", COMMAND_IPC_NEGOTIATE },
+    { "ipc.stats", COMMAND_IPC_STATS },
+    { "log", COMMAND_LOG },
+    { "loop.stats", COMMAND_LOOP_STATS },
+    { "notify", COMMAND_NOTIFY },
+    { "open.external", COMMAND_OPEN_EXTERNAL },
+    { "external", COMMAND_OPEN_EXTERNAL },
+    { "os.arch", COMMAND_OS_ARCH },
+    { "getPlatformArch", COMMAND_OS_ARCH },
+    { "os.networkInterfaces", COMMAND_OS_NETWORK_INTERFACES },
+    { "getNetworkInterfaces", COMMAND_OS_NETWORK_INTERFACES },
+    { "os.platform", COMMAND_OS_PLATFORM },
+    { "getPlatformOS", COMMAND_OS_PLATFORM },
+    { "os.type", COMMAND_OS_TYPE },
+    { "getPlatformType", COMMAND_OS_TYPE },
+    { "post", COMMAND_POST },
+    { "data", COMMAND_POST },
+    { "posts.stats", COMMAND_POSTS_STATS },
+    { "process.cwd", COMMAND_PROCESS_CWD },
+    { "cwd", COMMAND_PROCESS_CWD },
+    { "timer.clear", COMMAND_TIMER_CLEAR },
+    { "timer.set", COMMAND_TIMER_SET },
+    { "udp.bind", COMMAND_UDP_BIND },
+    { "udpBind", COMMAND_UDP_BIND },
+    { "udp.close", COMMAND_UDP_CLOSE },
+    { "udpClose", COMMAND_UDP_CLOSE },
+    { "close", COMMAND_UDP_CLOSE },
+    { "udp.connect", COMMAND_UDP_CONNECT },
+    { "udpConnect", COMMAND_UDP_CONNECT },
+    { "udp.disconnect", COMMAND_UDP_DISCONNECT },
+    { "udpDisconnect", COMMAND_UDP_DISCONNECT },
+    { "udp.getPeerName", COMMAND_UDP_GET_PEER_NAME },
+    { "udpGetPeerName", COMMAND_UDP_GET_PEER_NAME },
+    { "udp.getSockName", COMMAND_UDP_GET_SOCK_NAME },
+    { "udpGetSockName", COMMAND_UDP_GET_SOCK_NAME },
+    { "udp.getState", COMMAND_UDP_GET_STATE },
+    { "udpGetState", COMMAND_UDP_GET_STATE },
+    { "udp.readStart", COMMAND_UDP_READ_START },
+    { "udpReadStart", COMMAND_UDP_READ_START },
+    { "udp.readStop", COMMAND_UDP_READ_STOP },
+    { "udpReadStop", COMMAND_UDP_READ_STOP },
+    { "udp.send", COMMAND_UDP_SEND },
+    { "udpSend", COMMAND_UDP_SEND },
+    { "window.eval", COMMAND_WINDOW_EVAL }
+  };
+
+  /**
+   * A perfect hash of `COMMAND_NAMES`, built at compile time. Names hash to
+   * one of `BUCKETS` buckets, and each bucket has a displacement, found
+   * while building, that moves all of its names into free slots. A lookup
+   * is a hash, two table reads and one string compare.
+   */
+  class CommandTable {
+    public:
+      static constexpr size_t SLOTS = 256;
+      static constexpr size_t BUCKETS = 64;
+      static constexpr uint8_t EMPTY = 0xff;
+      static constexpr size_t NAMES = sizeof(COMMAND_NAMES) / sizeof(CommandName);
+
+      static_assert(NAMES < EMPTY, "COMMAND_NAMES does not fit in CommandTable");
+
+      // FNV-1a
+      static constexpr uint64_t hash (std::string_view name) {
+        uint64_t h = 0xcbf29ce484222325ull;
+
+        for (auto c : name) {
+          h ^= (uint8_t) c;
+          h *= 0x100000001b3ull;
+        }
+
+        return h;
+      }
+
+      static constexpr size_t slot (uint64_t h, uint8_t displacement) {
+        // `h >> 32 | 1` is odd, so every displacement gives a distinct slot
+        return (h + displacement * ((h >> 32) | 1)) & (SLOTS - 1);
+      }
+
+      constexpr CommandTable () {
+        for (auto& slot : this->slots) {
+          slot = EMPTY;
+        }
+
+        size_t sizes[BUCKETS] = {};
+        size_t largest = 0;
+
+        for (const auto& entry : COMMAND_NAMES) {
+          auto size = ++sizes[hash(entry.name) & (BUCKETS - 1)];
+          largest = size > largest ? size : largest;
+        }
+
+        // the most crowded buckets are the hardest to place, so go first
+        for (auto size = largest; size > 0; --size) {
+          for (size_t bucket = 0; bucket < BUCKETS; ++bucket) {
+            if (sizes[bucket] == size && !this->place(bucket)) {
+              throw "CommandTable: no displacement found, grow SLOTS";
+            }
+          }
+        }
+      }
+
+      constexpr command_t lookup (std::string_view name) const {
+        auto h = hash(name);
+        auto index = this->slots[slot(h, this->displacements[h & (BUCKETS - 1)])];
+
+        if (index == EMPTY || COMMAND_NAMES[index].name != name) {
+          return COMMAND_UNKNOWN;
+        }
+
+        return COMMAND_NAMES[index].command;
+      }
+
+      static constexpr std::string_view getName (command_t command) {
+        for (const auto& entry : COMMAND_NAMES) {
+          if (entry.command == command) {
+            return entry.name;
+          }
+        }
+
+        return "unknown";
+      }
+
+    private:
+      uint8_t displacements[BUCKETS] = {};
+      uint8_t slots[SLOTS] = {};
+
+      constexpr bool place (size_t bucket) {
+        for (size_t displacement = 0; displacement < SLOTS; ++displacement) {
+          bool ok = true;
+
+          for (size_t i = 0; i < NAMES && ok; ++i) {
+            auto h = hash(COMMAND_NAMES[i].name);
+
+            if ((h & (BUCKETS - 1)) != bucket) {
+              continue;
+            }
+
+            auto& slot = this->slots[CommandTable::slot(h, displacement)];
+
+            if (slot == EMPTY) {
+              slot = (uint8_t) i;
+            } else {
+              ok = false;
+            }
+          }
+
+          if (ok) {
+            this->displacements[bucket] = (uint8_t) displacement;
+            return true;
+          }
+
+          // undo a partial placement and try the next displacement
+          for (size_t i = 0; i < NAMES; ++i) {
+            auto h = hash(COMMAND_NAMES[i].name);
+            auto& slot = this->slots[CommandTable::slot(h, displacement)];
+
+            if ((h & (BUCKETS - 1)) == bucket && slot == i) {
+              slot = EMPTY;
+            }
+          }
+        }
+
+        return false;
+      }
+  };
+
+  constexpr CommandTable commandTable;
+
+  /**
+   * Maps command names to the handlers a bridge registers for them, once,
+   * and counts how often each command is invoked. `Args` are whatever the
+   * bridge passes through to its handlers.
+   */
+  template <typename... Args> class CommandRouter {
+    public:
+      using Handler = std::function<bool(Args...)>;
+
+    private:
+      Handler handlers[COMMAND_COUNT];
+      std::atomic<uint64_t> invocations[COMMAND_COUNT] = {};
+
+    public:
+      void on (command_t command, Handler handler) {
+        this->handlers[command] = handler;
+      }
+
+      bool invoke (std::string_view name, Args... args) {
+        auto command = commandTable.lookup(name);
+        this->invocations[command].fetch_add(1, std::memory_order_relaxed);
+
+        if (command == COMMAND_UNKNOWN || this->handlers[command] == nullptr) {
+          return false;
+        }
+
+        return this->handlers[command](std::move(args)...);
+      }
+
+      uint64_t getInvocations (command_t command) const {
+        return this->invocations[command].load(std::memory_order_relaxed);
+      }
+
+      String getStats () const {
+        StringStream data;
+        bool first = true;
+
+        for (int i = 0; i < COMMAND_COUNT; ++i) {
+          auto command = (command_t) i;
+          auto count = this->getInvocations(command);
+
+          if (count == 0) {
+            continue;
+          }
+
+          data << (first ? "" : ",") << "\"" << CommandTable::getName(command) << "\":" << count;
+          first = false;
+        }
+
+        return SSC::format(R"MSG({
+          "source": "commands.stats",
+          "data": { $S }
+        })MSG", data.str());
+      }
+  };
+
+  constexpr uint8_t IPC_FRAME_VERSION = 1;
+  constexpr size_t IPC_REQUEST_FRAME_HEADER_SIZE = 16;
+  constexpr size_t IPC_RESPONSE_FRAME_HEADER_SIZE = 20;
+
+  typedef enum {
+    IPC_FRAME_REQUEST = 1,
+    IPC_FRAME_RESPONSE = 2
+  } ipc_frame_t;
+
+  typedef enum {
+    IPC_FIELD_STRING = 1, // u32 length + UTF-8, not URI encoded
+    IPC_FIELD_INT = 2, // i64
+    IPC_FIELD_BYTES = 3 // u32 length + bytes, at most one per frame
+  } ipc_field_t;
+
+  /**
+   * A request sent as a binary frame instead of an `ipc://` URI, once
+   * `ipc.negotiate` settled on `IPC_FRAME_VERSION`. Everything is little
+   * endian.
+   *
+   *   version(1) type(1) command(2) seq(4) index(4) fields(2) reserved(2)
+   *   field: type(1) key length(1) key value
+   *
+   * `cmd` holds the fields like a parsed URI would, with `seq` as `R<seq>`,
+   * and `body` views the bytes field in the frame it was decoded from.
+   */
+  struct IPCRequestFrame {
+    Parse cmd;
+    const char *body = nullptr;
+    size_t bodySize = 0;
+  };
+
+  std::optional<IPCRequestFrame> decodeIPCRequestFrame (const char *bytes, size_t size);
+
+  // version(1) type(1) reserved(2) seq(4) message(4) headers(4) body(4)
+  // followed by the JSON message and the post headers. The post body goes
+  // after that as is, it is not copied into the returned frame.
+  Buffer encodeIPCResponseFrame (const String& seq, const String& msg, const Post& post);
+
+  // the `ipc.negotiate` result, with the command ids frames are sent with
+  // and how request bodies reach native code: "body" (the request body
+  // itself), "typed-array" (posted as a typed array) or "string"
+  String getIPCNegotiateResult (uint8_t version, const char *transport);
+
+  /**
+   * The chunk `fs.readStream` reads ahead of the last one pulled. Only
+   * touched on the descriptor's event loop.
+   */
+  struct DescriptorReadStream {
+    int64_t offset = -1;
+    Buffer chunk;
+    int err = 0;
+    size_t bytes = 0;
+    bool isReady = false;
+    std::function<void(int)> onready = nullptr; // with an error if cancelled
+  };
+
   struct Descriptor {
     Core *core;
     uv_file fd = 0;
@@ -49,8 +994,10 @@ namespace SSC {
     uint64_t id;
     std::atomic<bool> retained = false;
     std::atomic<bool> stale = false;
+    std::atomic<bool> closing = false; // a close was issued, it is removed once done
     std::recursive_mutex mutex;
     void *data;
+    DescriptorReadStream readStream;
 
     Descriptor (Core *core, uint64_t id);
 
@@ -60,52 +1007,125 @@ namespace SSC {
     bool isStale ();
   };
 
-  struct DescriptorRequestContext {
-    uint64_t id;
+  /**
+   * State shared by the callback based `fs*` request contexts. Contexts come
+   * from the `FSRequestContextPools` of the loop the request runs on and go
+   * back to it when they `end()`.
+   */
+  template <typename T> struct FSRequestContextBase {
     String seq = "";
     Descriptor *desc = nullptr;
-    uv_fs_t req;
-    uv_buf_t iov[16];
-    // 256 which corresponds to DirectoryHandle.MAX_BUFFER_SIZE
-    uv_dirent_t dirents[256];
-    int offset = 0;
-    int result = 0;
-    Callback cb;
+    uv_fs_t req = {};
+    Callback cb = nullptr;
+    RequestContextPool<T> *pool = nullptr;
 
-    DescriptorRequestContext () {}
-    DescriptorRequestContext (Descriptor *desc)
-      : DescriptorRequestContext(desc, "", nullptr) {}
-    DescriptorRequestContext (String seq, Callback cb)
-      : DescriptorRequestContext(nullptr, seq, cb) {}
-    DescriptorRequestContext (Descriptor *desc, String seq, Callback cb) {
-      this->id = SSC::rand64();
-      this->cb = cb;
-      this->seq = seq;
-      this->desc = desc;
-      this->req.data = (void *) this;
+    void reset () {
+      uv_fs_req_cleanup(&this->req);
+      this->seq.clear();
+      this->desc = nullptr;
+      this->cb = nullptr;
     }
 
-    ~DescriptorRequestContext () {
-      uv_fs_req_cleanup(&this->req);
+    void end (String seq, String msg, Post post) {
+      auto cb = std::move(this->cb);
+      this->pool->release(static_cast<T *>(this));
+
+      if (cb != nullptr) {
+        cb(seq, msg, post);
+      }
     }
 
-    void setBuffer (int index, int len, char *base);
-    void freeBuffer (int index);
-    char* getBuffer (int index);
-    size_t getBufferSize (int index);
-    void end (String seq, String msg, Post post);
-    void end (String seq, String msg);
-    void end (String msg, Post post);
-    void end (String msg);
+    void end (String msg, Post post) {
+      this->end(this->seq, msg, post);
+    }
+
+    void end (String msg) {
+      this->end(this->seq, msg, Post{});
+    }
+  };
+
+  // path operations (`fs.stat`, `fs.access`, ...) and `fs.opendir`/`fs.closedir`
+  struct FSRequestContext : FSRequestContextBase<FSRequestContext> {};
+
+  // `fs.readdir`, `dirents` grows to the largest `nentries` asked for
+  struct FSReaddirRequestContext : FSRequestContextBase<FSReaddirRequestContext> {
+    std::vector<uv_dirent_t> dirents;
+  };
+
+  // a range of a file read by `fs.readv`
+  struct FSSegment {
+    int64_t offset = 0;
+    size_t size = 0;
+  };
+
+  // the `fs.readv` segments listed by its `offsets` and `sizes` params, none
+  // unless both are present, the same length and never negative
+  std::optional<std::vector<FSSegment>> getFSSegments (
+    const std::optional<std::vector<int64_t>>& offsets,
+    const std::optional<std::vector<int64_t>>& sizes
+  );
+
+  // the `fs.writev` `sizes` param, none if any of them is negative
+  std::optional<std::vector<size_t>> getFSWriteSizes (
+    const std::optional<std::vector<int64_t>>& sizes
+  );
+
+  /**
+   * The fs request context freelists of one event loop.
+   */
+  struct FSRequestContextPools {
+    RequestContextPool<FSRequestContext> requests {
+      FS_REQUEST_CONTEXT_POOL_SIZE
+    };
+
+    RequestContextPool<FSReaddirRequestContext> readdirs {
+      FS_READDIR_REQUEST_CONTEXT_POOL_SIZE
+    };
+
+    String json () const;
   };
 
-  struct Timer {
-    uv_timer_t handle;
-    bool repeated = false;
-    bool started = false;
-    uint64_t timeout = 0;
-    uint64_t interval = 0;
-    uv_timer_cb invoke;
+  using TimerCallback = std::function<void()>;
+
+  /**
+   * A hierarchical timer wheel with 1ms ticks: `LEVELS` wheels of `SLOTS`
+   * slots each, where a slot at level `n` spans `SLOTS^n` ticks. Timers
+   * cascade down a level as their slot comes up, so setting, clearing
+   * and firing are O(1) and hundreds of thousands of timers are cheap.
+   * Cleared timers are dropped lazily when their slot is visited.
+   * Not thread safe, it is only touched on the primary event loop.
+   */
+  class TimerWheel {
+    public:
+      static constexpr int LEVELS = 4;
+      static constexpr int SLOT_BITS = 6;
+      static constexpr int SLOTS = 1 << SLOT_BITS;
+      static constexpr uint64_t SLOT_MASK = SLOTS - 1;
+      static constexpr uint64_t IDLE = UINT64_MAX;
+
+      struct Entry {
+        uint64_t expires = 0;
+        uint64_t interval = 0;
+        TimerCallback callback = nullptr;
+      };
+
+      // `(id, expires)` pairs, stale when they no longer match `entries`
+      using Slot = std::vector<std::pair<uint64_t, uint64_t>>;
+
+      uint64_t now = 0; // current tick, in milliseconds
+      std::unordered_map<uint64_t, Entry> entries;
+      Slot slots[LEVELS][SLOTS];
+
+      void set (uint64_t id, uint64_t timeout, uint64_t interval, TimerCallback callback);
+      bool clear (uint64_t id);
+      bool has (uint64_t id) const;
+      void advance (uint64_t now);
+      uint64_t timeout () const;
+      size_t size () const;
+
+    private:
+      void schedule (uint64_t id, uint64_t expires);
+      void cascade (int level, uint64_t index);
   };
 
   typedef enum {
@@ -129,6 +1149,7 @@ namespace SSC {
     PEER_STATE_UDP_CONNECTED = 1 << 11,
     PEER_STATE_UDP_RECV_STARTED = 1 << 12,
     PEER_STATE_UDP_PAUSED = 1 << 13,
+    PEER_STATE_UDP_RECV_THROTTLED = 1 << 14,
     // tcp states (20)
     PEER_STATE_TCP_BOUND = 1 << 20,
     PEER_STATE_TCP_CONNECTED = 1 << 21,
@@ -212,6 +1233,9 @@ namespace SSC {
 
     // callbacks
     Callback recv;
+
+    // block the next datagram is read into, reused while nothing else holds it
+    Buffer recvBuffer;
     std::vector<std::function<void()>> onclose;
 
     // instance state
@@ -266,6 +1290,8 @@ namespace SSC {
     int recvstart ();
     int recvstart (Callback onrecv);
     int recvstop ();
+    int throttle ();
+    int unthrottle ();
     int resume ();
     int pause ();
     void close ();
@@ -290,27 +1316,306 @@ namespace SSC {
     uv_ip4_name(name_in, address, 17);
   }
 
+  /**
+   * The typed result of an awaitable `Core` operation. `err` is a libuv
+   * status code and is negative on failure.
+   */
+  template <typename T> struct AsyncResult {
+    int err = 0;
+    T value = {};
+
+    bool ok () const {
+      return this->err >= 0;
+    }
+  };
+
+  /**
+   * A lazily started C++20 coroutine producing a `T`. A `Task` is either
+   * `co_await`ed from another coroutine, which resumes when it completes,
+   * or started detached with `start(callback)`, in which case the
+   * coroutine frame frees itself after calling `callback`.
+   */
+  template <typename T> class Task {
+    public:
+      struct promise_type;
+      using Handle = std::coroutine_handle<promise_type>;
+
+      struct FinalAwaiter {
+        bool await_ready () noexcept {
+          return false;
+        }
+
+        std::coroutine_handle<> await_suspend (Handle handle) noexcept {
+          auto& promise = handle.promise();
+
+          if (promise.continuation) {
+            return promise.continuation;
+          }
+
+          if (promise.detached) {
+            auto callback = std::move(promise.callback);
+            auto value = std::move(promise.value);
+            handle.destroy();
+
+            if (callback != nullptr) {
+              callback(std::move(value));
+            }
+          }
+
+          return std::noop_coroutine();
+        }
+
+        void await_resume () noexcept {}
+      };
+
+      struct promise_type {
+        T value = {};
+        bool detached = false;
+        std::coroutine_handle<> continuation = nullptr;
+        std::function<void(T)> callback = nullptr;
+
+        Task get_return_object () {
+          return Task(Handle::from_promise(*this));
+        }
+
+        std::suspend_always initial_suspend () noexcept { return {}; }
+        FinalAwaiter final_suspend () noexcept { return {}; }
+        void return_value (T value) { this->value = std::move(value); }
+        void unhandled_exception () { std::terminate(); }
+      };
+
+      Task (Handle handle) : handle(handle) {}
+      Task (Task&& task) : handle(std::exchange(task.handle, nullptr)) {}
+      Task (const Task&) = delete;
+      Task& operator = (const Task&) = delete;
+
+      ~Task () {
+        if (this->handle) {
+          this->handle.destroy();
+        }
+      }
+
+      bool await_ready () {
+        return false;
+      }
+
+      std::coroutine_handle<> await_suspend (std::coroutine_handle<> continuation) {
+        this->handle.promise().continuation = continuation;
+        return this->handle;
+      }
+
+      T await_resume () {
+        return std::move(this->handle.promise().value);
+      }
+
+      void start (std::function<void(T)> callback) {
+        auto handle = std::exchange(this->handle, nullptr);
+        handle.promise().detached = true;
+        handle.promise().callback = std::move(callback);
+        handle.resume();
+      }
+
+    private:
+      Handle handle = nullptr;
+  };
+
+  /**
+   * A lock-free histogram of durations in microseconds, bucketed by powers
+   * of two. Any thread may `record()` or read it at any time.
+   */
+  struct EventLoopHistogram {
+    static constexpr int BUCKETS = 32;
+    std::atomic<uint64_t> buckets[BUCKETS];
+    std::atomic<uint64_t> count = 0;
+    std::atomic<uint64_t> total = 0;
+    std::atomic<uint64_t> max = 0;
+
+    void record (uint64_t value);
+    uint64_t percentile (double p) const;
+    String json () const;
+  };
+
+  /**
+   * Counters and timings for a single event loop, updated by the loop
+   * thread (and producers, for `maxQueueDepth`) and read by `loop.stats`.
+   */
+  struct EventLoopStats {
+    EventLoopHistogram wait; // enqueue to start
+    EventLoopHistogram run; // start to end
+    std::atomic<uint64_t> iterations = 0;
+    std::atomic<uint64_t> dispatched = 0;
+    std::atomic<uint64_t> maxQueueDepth = 0;
+    std::atomic<uint64_t> stalls = 0;
+    std::atomic<const char *> lastStallName = nullptr;
+    std::atomic<uint64_t> lastStallDuration = 0;
+    std::atomic<const char *> runningName = nullptr;
+    std::atomic<uint64_t> runningSince = 0; // `0` while idle
+
+    void recordQueueDepth (uint64_t depth);
+    String json (
+      size_t index,
+      size_t queueDepth,
+      const FSRequestContextPools &fsRequestContexts
+    ) const;
+  };
+
+  typedef enum {
+    EVENT_LOOP_PRIORITY_REALTIME = 0, // latency sensitive, ie. UDP, control ops
+    EVENT_LOOP_PRIORITY_NORMAL = 1,
+    EVENT_LOOP_PRIORITY_BULK = 2 // large data transfers, ie. fs reads/writes
+  } event_loop_priority_t;
+
+  constexpr int EVENT_LOOP_PRIORITIES = 3;
+
+  // callbacks drained per lane, per round, when every lane has work
+  constexpr int EVENT_LOOP_PRIORITY_WEIGHTS[EVENT_LOOP_PRIORITIES] = { 8, 4, 1 };
+
+  struct EventLoopDispatch {
+    EventLoopDispatchCallback callback = nullptr;
+    const char *name = nullptr; // static string, for stall reports
+    uint64_t queuedAt = 0; // in microseconds
+    event_loop_priority_t priority = EVENT_LOOP_PRIORITY_NORMAL;
+  };
+
+  /**
+   * One `MPSCQueue` lane per `event_loop_priority_t`. Producers push to the
+   * lane of the dispatch priority and the loop drains lanes with weighted
+   * round robin so bulk work can't delay realtime work, but never starves.
+   */
+  class EventLoopDispatchQueue {
+    MPSCQueue<EventLoopDispatch> lanes[EVENT_LOOP_PRIORITIES];
+
+    public:
+      void push (EventLoopDispatch dispatch) {
+        auto priority = dispatch.priority;
+        this->lanes[priority].push(std::move(dispatch));
+      }
+
+      bool pop (event_loop_priority_t priority, EventLoopDispatch& dispatch) {
+        return this->lanes[priority].pop(dispatch);
+      }
+
+      bool empty () const {
+        for (const auto& lane : this->lanes) {
+          if (!lane.empty()) return false;
+        }
+
+        return true;
+      }
+
+      size_t size () const {
+        size_t size = 0;
+        for (const auto& lane : this->lanes) {
+          size += lane.size();
+        }
+
+        return size;
+      }
+  };
+
+  struct FSRequestResult {
+    int64_t result = 0;
+    uv_stat_t stat = {};
+  };
+
+  /**
+   * Awaits a single `uv_fs_*` request, started by `start` on the event
+   * loop that owns `id`, and resumes on that loop when it completes.
+   */
+  struct FSRequestAwaiter {
+    using Start = std::function<int(uv_loop_t *, uv_fs_t *, uv_fs_cb)>;
+
+    Core *core = nullptr;
+    uint64_t id = 0;
+    event_loop_priority_t priority = EVENT_LOOP_PRIORITY_NORMAL;
+    const char *name = nullptr;
+    Start start = nullptr;
+    uv_fs_t req;
+    FSRequestResult result;
+    std::coroutine_handle<> handle = nullptr;
+
+    FSRequestAwaiter (
+      Core *core,
+      uint64_t id,
+      event_loop_priority_t priority,
+      const char *name,
+      Start start
+    ) : core(core), id(id), priority(priority), name(name), start(start) {}
+
+    bool await_ready () { return false; }
+    void await_suspend (std::coroutine_handle<> handle);
+    FSRequestResult await_resume () { return this->result; }
+    void resolve (int64_t result);
+  };
+
+  /**
+   * Awaits a `uv_udp_send()` on the event loop that owns `peerId`,
+   * creating the peer there first. `bytes` must outlive the await.
+   */
+  struct UDPSendAwaiter {
+    Core *core = nullptr;
+    uint64_t peerId = 0;
+    char *bytes = nullptr;
+    size_t size = 0;
+    int port = 0;
+    String address = "";
+    bool ephemeral = false;
+    Peer *peer = nullptr;
+    uv_udp_send_t req;
+    int status = 0;
+    std::coroutine_handle<> handle = nullptr;
+
+    bool await_ready () { return false; }
+    void await_suspend (std::coroutine_handle<> handle);
+    int await_resume () { return this->status; }
+    void resolve (int status);
+  };
+
+  /**
+   * A secondary event loop owned by `Core`, driven by its own thread.
+   * Loop `0` is always `Core::eventLoop` and is not a shard.
+   */
+  struct EventLoopShard {
+    Core *core = nullptr;
+    size_t index = 0;
+    uv_loop_t loop;
+    uv_async_t async;
+    uv_prepare_t prepare;
+    EventLoopDispatchQueue dispatchQueue;
+    EventLoopStats stats;
+    FSRequestContextPools fsRequestContexts;
+    std::atomic<bool> isRunning = false;
+    std::thread *thread = nullptr;
+  };
+
   class Core {
     public:
       std::unique_ptr<Posts> posts;
-      std::map<uint64_t, Descriptor*> descriptors;
-      std::map<uint64_t, Peer*> peers;
+      std::atomic<bool> isPostsOverBudget = false;
+      SlotMap<Descriptor> descriptors;
+      SlotMap<Peer> peers;
 
-      std::recursive_mutex descriptorsMutex;
       std::recursive_mutex loopMutex;
-      std::recursive_mutex peersMutex;
-      std::recursive_mutex postsMutex;
       std::recursive_mutex timersMutex;
 
       std::atomic<bool> didLoopInit = false;
       std::atomic<bool> didTimersInit = false;
       std::atomic<bool> didTimersStart = false;
 
+      TimerWheel timerWheel;
+      uv_timer_t timerWheelHandle;
+
       std::atomic<bool> isLoopRunning = false;
 
       uv_loop_t eventLoop;
       uv_async_t eventLoopAsync;
-      std::queue<EventLoopDispatchCallback> eventLoopDispatchQueue;
+      uv_prepare_t eventLoopPrepare;
+      EventLoopDispatchQueue eventLoopDispatchQueue;
+      EventLoopStats eventLoopStats;
+      FSRequestContextPools fsRequestContexts;
+
+      size_t eventLoopCount = 1;
+      std::vector<EventLoopShard *> eventLoopShards;
 
 #if defined(__APPLE__)
       dispatch_queue_attr_t eventLoopQueueAttrs = dispatch_queue_attr_make_with_qos_class(
@@ -327,6 +1632,62 @@ namespace SSC {
       std::thread *eventLoopThread = nullptr;
 #endif
 
+      /**
+       * Typed, awaitable file system operations. The JSON `fs*` methods
+       * are adapters over these.
+       */
+      class FS {
+        Core *core = nullptr;
+
+        public:
+          FS (Core *core) : core(core) {}
+
+          Task<AsyncResult<Descriptor *>> open (uint64_t id, String path, int flags, int mode);
+          Task<AsyncResult<size_t>> read (uint64_t id, char *bytes, size_t size, int64_t offset);
+          Task<AsyncResult<size_t>> write (uint64_t id, const char *bytes, size_t size, int64_t offset);
+          Task<AsyncResult<size_t>> readv (uint64_t id, std::vector<uv_buf_t> buffers, int64_t offset);
+          Task<AsyncResult<size_t>> writev (uint64_t id, std::vector<uv_buf_t> buffers, int64_t offset);
+          Task<AsyncResult<std::vector<size_t>>> readSegments (
+            uint64_t id,
+            char *bytes,
+            std::vector<FSSegment> segments
+          );
+          Task<AsyncResult<uv_stat_t>> fstat (uint64_t id);
+          Task<AsyncResult<uv_file>> close (uint64_t id);
+      };
+
+      /**
+       * Typed, awaitable UDP operations.
+       */
+      class UDP {
+        Core *core = nullptr;
+
+        public:
+          UDP (Core *core) : core(core) {}
+
+          Task<AsyncResult<int>> send (
+            uint64_t peerId,
+            char *bytes,
+            size_t size,
+            int port,
+            String address,
+            bool ephemeral
+          );
+      };
+
+      FS fs = FS(this);
+      UDP udp = UDP(this);
+
+      BufferPool udpRecvBufferPool {
+        UDP_RECV_BUFFER_SIZE,
+        UDP_RECV_BUFFER_POOL_SIZE
+      };
+
+      BufferPool fsReadStreamBufferPool {
+        FS_READ_STREAM_CHUNK_SIZE,
+        FS_READ_STREAM_BUFFER_POOL_SIZE
+      };
+
       Core ();
       ~Core ();
 
@@ -347,13 +1708,25 @@ namespace SSC {
       void fsOpen (String seq, uint64_t id, String path, int flags, int mode, Callback cb);
       void fsOpendir (String seq, uint64_t id, String path, Callback cb);
       void fsRead (String seq, uint64_t id, int len, int offset, Callback cb);
+      void fsReadStream (String seq, uint64_t id, int64_t offset, Callback cb);
+      void fsReadStreamChunk (uint64_t id, int64_t offset);
       void fsReaddir (String seq, uint64_t id, size_t entries, Callback cb);
+      void fsReadv (String seq, uint64_t id, std::vector<FSSegment> segments, Callback cb);
       void fsRetainOpenDescriptor (String seq, uint64_t id, Callback cb);
       void fsRename (String seq, String pathA, String pathB, Callback cb);
       void fsRmdir (String seq, String path, Callback cb);
       void fsStat (String seq, String path, Callback cb);
       void fsUnlink (String seq, String path, Callback cb);
       void fsWrite (String seq, uint64_t id, String data, int64_t offset, Callback cb);
+      void fsWrite (String seq, uint64_t id, Buffer data, int64_t offset, Callback cb);
+      void fsWritev (
+        String seq,
+        uint64_t id,
+        Buffer data,
+        std::vector<size_t> sizes,
+        int64_t offset,
+        Callback cb
+      );
 
       Descriptor * getDescriptor (uint64_t id);
       void removeDescriptor (uint64_t id);
@@ -370,9 +1743,11 @@ namespace SSC {
       void udpReadStop (String seq, uint64_t peerId, Callback cb);
       void udpClose (String seq, uint64_t peerId, Callback cb);
       void udpSend (String seq, uint64_t peerId, char* buf, int len, int port, String address, bool ephemeral, Callback cb);
+      void udpSend (String seq, uint64_t peerId, Buffer data, int port, String address, bool ephemeral, Callback cb);
 
       void resumeAllPeers ();
       void pauseAllPeers ();
+      void applyPostsBackPressure ();
       bool hasPeer (uint64_t id);
       void removePeer (uint64_t id);
       void removePeer (uint64_t id, bool autoClose);
@@ -393,21 +1768,47 @@ namespace SSC {
       void removeAllPosts ();
       void expirePosts ();
       void putPost (uint64_t id, Post p);
+      bool takePost (uint64_t id, Post &post);
       String createPost (String seq, String params, Post post);
+      String getPostsStats ();
+      void updatePostsBudget ();
 
       // timers
       void initTimers ();
       void startTimers ();
       void stopTimers ();
+      void scheduleTimers ();
+      void setTimer (uint64_t id, uint64_t timeout, uint64_t interval, TimerCallback callback);
+      void clearTimer (uint64_t id);
+      void timerSet (String seq, uint64_t id, uint64_t timeout, uint64_t interval, Callback cb);
+      void timerClear (String seq, uint64_t id, Callback cb);
 
       // loop
       uv_loop_t* getEventLoop ();
+      uv_loop_t* getEventLoop (uint64_t id);
+      FSRequestContextPools& getFSRequestContextPools ();
+      FSRequestContextPools& getFSRequestContextPools (uint64_t id);
+      String getEventLoopStats ();
+      size_t getEventLoopIndex (uint64_t id);
       int getEventLoopTimeout ();
       bool isLoopAlive ();
       void initEventLoop ();
       void runEventLoop ();
       void stopEventLoop ();
       void dispatchEventLoop (EventLoopDispatchCallback dispatch);
+      void dispatchEventLoop (uint64_t id, EventLoopDispatchCallback dispatch);
+      void dispatchEventLoop (
+        event_loop_priority_t priority,
+        const char *name,
+        EventLoopDispatchCallback dispatch
+      );
+      void dispatchEventLoop (
+        event_loop_priority_t priority,
+        const char *name,
+        uint64_t id,
+        EventLoopDispatchCallback dispatch
+      );
+      void dispatchEachEventLoop (std::function<void(size_t)> dispatch);
       void signalDispatchEventLoop ();
       void sleepEventLoop (int64_t ms);
       void sleepEventLoop ();
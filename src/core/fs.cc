@@ -1,48 +1,47 @@
 #include "core.hh"
 
 namespace SSC {
-  void DescriptorRequestContext::setBuffer (int index, int len, char *base) {
-    this->iov[index].base = base;
-    this->iov[index].len = len;
-  }
-
-  void DescriptorRequestContext::freeBuffer (int index) {
-    if (this->iov[index].base != nullptr) {
-      delete [] (char *) this->iov[index].base;
-      this->iov[index].base = nullptr;
+  std::optional<std::vector<FSSegment>> getFSSegments (
+    const std::optional<std::vector<int64_t>>& offsets,
+    const std::optional<std::vector<int64_t>>& sizes
+  ) {
+    if (!offsets || !sizes || offsets->empty() || offsets->size() != sizes->size()) {
+      return std::nullopt;
     }
 
-    this->iov[index].len = 0;
-  }
+    std::vector<FSSegment> segments;
+    segments.reserve(offsets->size());
 
-  char* DescriptorRequestContext::getBuffer (int index) {
-    return this->iov[index].base;
-  }
+    for (size_t i = 0; i < offsets->size(); ++i) {
+      if ((*offsets)[i] < 0 || (*sizes)[i] < 0) {
+        return std::nullopt;
+      }
 
-  size_t DescriptorRequestContext::getBufferSize (int index) {
-    return this->iov[index].len;
-  }
+      segments.push_back(FSSegment { (*offsets)[i], (size_t) (*sizes)[i] });
+    }
 
-  void DescriptorRequestContext::end (String seq, String msg, Post post) {
-    auto cb = this->cb;
+    return segments;
+  }
 
-    if (cb != nullptr) {
-      cb(seq, msg, post);
+  std::optional<std::vector<size_t>> getFSWriteSizes (
+    const std::optional<std::vector<int64_t>>& sizes
+  ) {
+    if (!sizes) {
+      return std::nullopt;
     }
 
-    delete this;
-  }
+    std::vector<size_t> values;
+    values.reserve(sizes->size());
 
-  void DescriptorRequestContext::end (String seq, String msg) {
-    this->end(seq, msg, Post{});
-  }
+    for (auto size : *sizes) {
+      if (size < 0) {
+        return std::nullopt;
+      }
 
-  void DescriptorRequestContext::end (String msg, Post post) {
-    this->end(this->seq, msg, post);
-  }
+      values.push_back((size_t) size);
+    }
 
-  void DescriptorRequestContext::end (String msg) {
-    this->end(this->seq, msg, Post{});
+    return values;
   }
 
   Descriptor::Descriptor (Core *core, uint64_t id) {
@@ -71,28 +70,289 @@ namespace SSC {
   }
 
   Descriptor * Core::getDescriptor (uint64_t id) {
-    std::lock_guard<std::recursive_mutex> guard(descriptorsMutex);
-    if (descriptors.find(id) != descriptors.end()) {
-      return descriptors.at(id);
-    }
-    return nullptr;
+    return descriptors.get(id);
   }
 
   void Core::removeDescriptor (uint64_t id) {
-    std::lock_guard<std::recursive_mutex> guard(descriptorsMutex);
-    if (descriptors.find(id) != descriptors.end()) {
-      descriptors.erase(id);
-    }
+    descriptors.remove(id);
   }
 
   bool Core::hasDescriptor (uint64_t id) {
-    std::lock_guard<std::recursive_mutex> guard(descriptorsMutex);
-    return descriptors.find(id) != descriptors.end();
+    return descriptors.has(id);
+  }
+
+  void FSRequestAwaiter::await_suspend (std::coroutine_handle<> handle) {
+    this->handle = handle;
+    this->req.data = (void *) this;
+
+    core->dispatchEventLoop(priority, name, id, [this]() {
+      auto loop = core->getEventLoop(id);
+      auto err = start(loop, &req, [](uv_fs_t *req) {
+        auto awaiter = reinterpret_cast<FSRequestAwaiter *>(req->data);
+        awaiter->resolve(req->result);
+      });
+
+      if (err < 0) {
+        resolve(err);
+      }
+    });
+  }
+
+  void FSRequestAwaiter::resolve (int64_t result) {
+    this->result.result = result;
+    this->result.stat = this->req.statbuf;
+    uv_fs_req_cleanup(&this->req);
+    this->handle.resume();
+  }
+
+  Task<AsyncResult<Descriptor *>> Core::FS::open (uint64_t id, String path, int flags, int mode) {
+    auto request = FSRequestAwaiter(core, id, EVENT_LOOP_PRIORITY_NORMAL, "fs.open",
+      [path, flags, mode](auto loop, auto req, auto cb) {
+        return uv_fs_open(loop, req, path.c_str(), flags, mode, cb);
+      }
+    );
+
+    auto result = co_await request;
+
+    if (result.result < 0) {
+      co_return AsyncResult<Descriptor *> { (int) result.result, nullptr };
+    }
+
+    auto desc = new Descriptor(core, id);
+    desc->fd = (uv_file) result.result;
+
+    core->descriptors.set(id, desc);
+    co_return AsyncResult<Descriptor *> { 0, desc };
+  }
+
+  Task<AsyncResult<size_t>> Core::FS::read (uint64_t id, char *bytes, size_t size, int64_t offset) {
+    auto desc = core->getDescriptor(id);
+    if (desc == nullptr) {
+      co_return AsyncResult<size_t> { UV_EBADF, 0 };
+    }
+
+    auto fd = desc->fd;
+    auto request = FSRequestAwaiter(core, id, EVENT_LOOP_PRIORITY_BULK, "fs.read",
+      [fd, bytes, size, offset](auto loop, auto req, auto cb) {
+        auto iov = uv_buf_init(bytes, (unsigned int) size);
+        return uv_fs_read(loop, req, fd, &iov, 1, offset, cb);
+      }
+    );
+
+    auto result = co_await request;
+
+    if (result.result < 0) {
+      co_return AsyncResult<size_t> { (int) result.result, 0 };
+    }
+
+    co_return AsyncResult<size_t> { 0, (size_t) result.result };
+  }
+
+  Task<AsyncResult<size_t>> Core::FS::write (uint64_t id, const char *bytes, size_t size, int64_t offset) {
+    auto desc = core->getDescriptor(id);
+    if (desc == nullptr) {
+      co_return AsyncResult<size_t> { UV_EBADF, 0 };
+    }
+
+    auto fd = desc->fd;
+    auto request = FSRequestAwaiter(core, id, EVENT_LOOP_PRIORITY_BULK, "fs.write",
+      [fd, bytes, size, offset](auto loop, auto req, auto cb) {
+        auto iov = uv_buf_init((char *) bytes, (unsigned int) size);
+        return uv_fs_write(loop, req, fd, &iov, 1, offset, cb);
+      }
+    );
+
+    auto result = co_await request;
+
+    if (result.result < 0) {
+      co_return AsyncResult<size_t> { (int) result.result, 0 };
+    }
+
+    co_return AsyncResult<size_t> { 0, (size_t) result.result };
+  }
+
+  // one vectored `uv_fs_read()` per `FS_IOV_MAX` buffers, filled in order
+  // from `offset`, stops early at the end of the file
+  Task<AsyncResult<size_t>> Core::FS::readv (uint64_t id, std::vector<uv_buf_t> buffers, int64_t offset) {
+    auto desc = core->getDescriptor(id);
+    if (desc == nullptr) {
+      co_return AsyncResult<size_t> { UV_EBADF, 0 };
+    }
+
+    auto fd = desc->fd;
+    size_t total = 0;
+
+    for (size_t i = 0; i < buffers.size(); i += FS_IOV_MAX) {
+      auto bufs = buffers.data() + i;
+      auto nbufs = (unsigned int) std::min(buffers.size() - i, FS_IOV_MAX);
+      auto position = offset < 0 ? offset : offset + (int64_t) total;
+      size_t expected = 0;
+
+      for (unsigned int j = 0; j < nbufs; ++j) {
+        expected += bufs[j].len;
+      }
+
+      auto request = FSRequestAwaiter(core, id, EVENT_LOOP_PRIORITY_BULK, "fs.readv",
+        [fd, bufs, nbufs, position](auto loop, auto req, auto cb) {
+          return uv_fs_read(loop, req, fd, bufs, nbufs, position, cb);
+        }
+      );
+
+      auto result = co_await request;
+
+      if (result.result < 0) {
+        co_return AsyncResult<size_t> { (int) result.result, total };
+      }
+
+      total += (size_t) result.result;
+
+      if ((size_t) result.result < expected) {
+        break;
+      }
+    }
+
+    co_return AsyncResult<size_t> { 0, total };
+  }
+
+  // one vectored `uv_fs_write()` per `FS_IOV_MAX` buffers, written back to
+  // back from `offset` (or the current position when it is negative)
+  Task<AsyncResult<size_t>> Core::FS::writev (uint64_t id, std::vector<uv_buf_t> buffers, int64_t offset) {
+    auto desc = core->getDescriptor(id);
+    if (desc == nullptr) {
+      co_return AsyncResult<size_t> { UV_EBADF, 0 };
+    }
+
+    auto fd = desc->fd;
+    size_t total = 0;
+
+    for (size_t i = 0; i < buffers.size(); i += FS_IOV_MAX) {
+      auto bufs = buffers.data() + i;
+      auto nbufs = (unsigned int) std::min(buffers.size() - i, FS_IOV_MAX);
+      auto position = offset < 0 ? offset : offset + (int64_t) total;
+      size_t expected = 0;
+
+      for (unsigned int j = 0; j < nbufs; ++j) {
+        expected += bufs[j].len;
+      }
+
+      auto request = FSRequestAwaiter(core, id, EVENT_LOOP_PRIORITY_BULK, "fs.writev",
+        [fd, bufs, nbufs, position](auto loop, auto req, auto cb) {
+          return uv_fs_write(loop, req, fd, bufs, nbufs, position, cb);
+        }
+      );
+
+      auto result = co_await request;
+
+      if (result.result < 0) {
+        co_return AsyncResult<size_t> { (int) result.result, total };
+      }
+
+      total += (size_t) result.result;
+
+      if ((size_t) result.result < expected) {
+        break;
+      }
+    }
+
+    co_return AsyncResult<size_t> { 0, total };
+  }
+
+  // Reads each segment into `bytes`, back to back in the order given, and
+  // resolves with the bytes read for each. Runs of adjacent segments are
+  // read together with `readv()`.
+  Task<AsyncResult<std::vector<size_t>>> Core::FS::readSegments (
+    uint64_t id,
+    char *bytes,
+    std::vector<FSSegment> segments
+  ) {
+    std::vector<size_t> sizes(segments.size(), 0);
+    size_t i = 0;
+
+    while (i < segments.size()) {
+      auto start = i;
+      auto offset = segments[i].offset;
+      std::vector<uv_buf_t> buffers;
+
+      do {
+        buffers.push_back(uv_buf_init(bytes, (unsigned int) segments[i].size));
+        bytes += segments[i].size;
+        i++;
+      } while (
+        i < segments.size() &&
+        segments[i].offset == segments[i - 1].offset + (int64_t) segments[i - 1].size
+      );
+
+      auto result = co_await readv(id, std::move(buffers), offset);
+
+      if (!result.ok()) {
+        co_return AsyncResult<std::vector<size_t>> { result.err, sizes };
+      }
+
+      // a short read fills the segments of the run in order
+      auto remaining = result.value;
+      for (auto j = start; j < i; ++j) {
+        sizes[j] = std::min(remaining, segments[j].size);
+        remaining -= sizes[j];
+      }
+    }
+
+    co_return AsyncResult<std::vector<size_t>> { 0, sizes };
+  }
+
+  Task<AsyncResult<uv_stat_t>> Core::FS::fstat (uint64_t id) {
+    auto desc = core->getDescriptor(id);
+    if (desc == nullptr) {
+      co_return AsyncResult<uv_stat_t> { UV_EBADF };
+    }
+
+    auto fd = desc->fd;
+    auto request = FSRequestAwaiter(core, id, EVENT_LOOP_PRIORITY_NORMAL, "fs.fstat",
+      [fd](auto loop, auto req, auto cb) {
+        return uv_fs_fstat(loop, req, fd, cb);
+      }
+    );
+
+    auto result = co_await request;
+
+    if (result.result < 0) {
+      co_return AsyncResult<uv_stat_t> { (int) result.result };
+    }
+
+    co_return AsyncResult<uv_stat_t> { 0, result.stat };
+  }
+
+  Task<AsyncResult<uv_file>> Core::FS::close (uint64_t id) {
+    auto desc = core->getDescriptor(id);
+    if (desc == nullptr) {
+      co_return AsyncResult<uv_file> { UV_EBADF, 0 };
+    }
+
+    auto fd = desc->fd;
+    auto request = FSRequestAwaiter(core, id, EVENT_LOOP_PRIORITY_NORMAL, "fs.close",
+      [fd](auto loop, auto req, auto cb) {
+        return uv_fs_close(loop, req, fd, cb);
+      }
+    );
+
+    auto result = co_await request;
+
+    if (result.result < 0) {
+      co_return AsyncResult<uv_file> { (int) result.result, fd };
+    }
+
+    core->removeDescriptor(id);
+
+    // answer a `fs.readStream` pull still waiting on this descriptor
+    if (auto onready = std::exchange(desc->readStream.onready, nullptr)) {
+      onready(UV_EBADF);
+    }
+
+    delete desc;
+    co_return AsyncResult<uv_file> { 0, fd };
   }
 
   void Core::fsRetainOpenDescriptor (String seq, uint64_t id, Callback cb) {
     auto desc = getDescriptor(id);
-    auto ctx = new DescriptorRequestContext(seq, cb);
     SSC::String msg;
 
     if (desc == nullptr) {
@@ -108,7 +368,7 @@ namespace SSC {
     } else {
       std::lock_guard<std::recursive_mutex> descriptorLock(desc->mutex);
       desc->retained = true;
-      auto msg = SSC::format(R"MSG({
+      msg = SSC::format(R"MSG({
         "source": "fs.retainOpenDescriptor",
         "data": {
           "id": "$S"
@@ -116,16 +376,18 @@ namespace SSC {
       })MSG", std::to_string(desc->id));
     }
 
-    ctx->end(msg);
+    cb(seq, msg, Post{});
   }
 
   void Core::fsAccess (String seq, String path, int mode, Callback cb) {
-    dispatchEventLoop([=, this]() {
+    dispatchEventLoop(EVENT_LOOP_PRIORITY_NORMAL, "fs.access", [=, this]() mutable {
       auto filename = path.c_str();
-      auto ctx = new DescriptorRequestContext(seq, cb);
+      auto ctx = getFSRequestContextPools().requests.acquire();
+      ctx->seq = seq;
+      ctx->cb = std::move(cb);
 
       auto err = uv_fs_access(&this->eventLoop, &ctx->req, filename, mode, [](uv_fs_t* req) {
-        auto ctx = (DescriptorRequestContext *) req->data;
+        auto ctx = (FSRequestContext *) req->data;
         SSC::String msg;
 
         if (req->result < 0) {
@@ -165,12 +427,14 @@ namespace SSC {
   }
 
   void Core::fsChmod (String seq, String path, int mode, Callback cb) {
-    dispatchEventLoop([=, this]() {
+    dispatchEventLoop(EVENT_LOOP_PRIORITY_NORMAL, "fs.chmod", [=, this]() mutable {
       auto filename = path.c_str();
-      auto ctx = new DescriptorRequestContext(seq, cb);
+      auto ctx = getFSRequestContextPools().requests.acquire();
+      ctx->seq = seq;
+      ctx->cb = std::move(cb);
 
       auto err = uv_fs_chmod(&this->eventLoop, &ctx->req, filename, mode, [](uv_fs_t* req) {
-        auto ctx = (DescriptorRequestContext *) req->data;
+        auto ctx = (FSRequestContext *) req->data;
         SSC::String msg;
 
         if (req->result < 0) {
@@ -210,51 +474,8 @@ namespace SSC {
   }
 
   void Core::fsOpen (String seq, uint64_t id, String path, int flags, int mode, Callback cb) {
-    dispatchEventLoop([=, this]() {
-      auto filename = path.c_str();
-      auto desc = new Descriptor(this, id);
-      auto ctx = new DescriptorRequestContext(desc, seq, cb);
-
-      auto err = uv_fs_open(&this->eventLoop, &ctx->req, filename, flags, mode, [](uv_fs_t* req) {
-        auto ctx = (DescriptorRequestContext *) req->data;
-        auto desc = ctx->desc;
-        SSC::String msg;
-
-        if (req->result < 0) {
-          msg = SSC::format(R"MSG({
-            "source": "fs.open",
-            "err": {
-              "id": "$S",
-              "code": $S,
-              "message": "$S"
-            }
-          })MSG",
-          std::to_string(desc->id),
-          std::to_string(req->result),
-          String(uv_strerror(req->result)));
-
-          delete desc;
-        } else {
-          msg = SSC::format(R"MSG({
-            "source": "fs.open",
-            "data": {
-              "id": "$S",
-              "fd": $S
-            }
-          })MSG",
-          std::to_string(desc->id),
-          std::to_string(req->result));
-
-          desc->fd = (int) req->result;
-          // insert into `descriptors` map
-          std::lock_guard<std::recursive_mutex> guard(desc->core->descriptorsMutex);
-          desc->core->descriptors.insert_or_assign(desc->id, desc);
-        }
-
-        ctx->end(msg);
-      });
-
-      if (err < 0) {
+    fs.open(id, path, flags, mode).start([=](auto result) {
+      if (!result.ok()) {
         auto msg = SSC::format(R"MSG({
           "source": "fs.open",
           "err": {
@@ -264,22 +485,37 @@ namespace SSC {
           }
         })MSG",
         std::to_string(id),
-        std::to_string(err),
-        String(uv_strerror(err)));
+        std::to_string(result.err),
+        String(uv_strerror(result.err)));
 
-        delete desc;
-        ctx->end(msg);
+        cb(seq, msg, Post{});
+        return;
       }
+
+      auto msg = SSC::format(R"MSG({
+        "source": "fs.open",
+        "data": {
+          "id": "$S",
+          "fd": $S
+        }
+      })MSG",
+      std::to_string(id),
+      std::to_string(result.value->fd));
+
+      cb(seq, msg, Post{});
     });
   }
 
   void Core::fsOpendir(String seq, uint64_t id, String path, Callback cb) {
-    dispatchEventLoop([=, this]() {
+    dispatchEventLoop(EVENT_LOOP_PRIORITY_NORMAL, "fs.opendir", id, [=, this]() mutable {
       auto filename = path.c_str();
       auto desc =  new Descriptor(this, id);
-      auto ctx = new DescriptorRequestContext(desc, seq, cb);
-      auto err = uv_fs_opendir(&this->eventLoop, &ctx->req, filename, [](uv_fs_t *req) {
-        auto ctx = (DescriptorRequestContext *) req->data;
+      auto ctx = getFSRequestContextPools(id).requests.acquire();
+      ctx->seq = seq;
+      ctx->desc = desc;
+      ctx->cb = std::move(cb);
+      auto err = uv_fs_opendir(getEventLoop(id), &ctx->req, filename, [](uv_fs_t *req) {
+        auto ctx = (FSRequestContext *) req->data;
         auto desc = ctx->desc;
         SSC::String msg;
 
@@ -308,8 +544,7 @@ namespace SSC {
 
           desc->dir = (uv_dir_t *) req->ptr;
           // insert into `descriptors` map
-          std::lock_guard<std::recursive_mutex> guard(desc->core->descriptorsMutex);
-          desc->core->descriptors.insert_or_assign(desc->id, desc);
+          desc->core->descriptors.set(desc->id, desc);
         }
 
         ctx->end(msg);
@@ -336,7 +571,6 @@ namespace SSC {
 
   void Core::fsReaddir (String seq, uint64_t id, size_t nentries, Callback cb) {
     auto desc = getDescriptor(id);
-    auto ctx = new DescriptorRequestContext(desc, seq, cb);
 
     if (desc == nullptr) {
       auto msg = SSC::format(R"MSG({
@@ -349,7 +583,7 @@ namespace SSC {
         }
       })MSG", std::to_string(id));
 
-      ctx->end(msg);
+      cb(seq, msg, Post{});
       return;
     }
 
@@ -363,17 +597,23 @@ namespace SSC {
         }
       })MSG", std::to_string(id));
 
-      ctx->end(msg);
+      cb(seq, msg, Post{});
       return;
     }
 
-    dispatchEventLoop([=, this]() {
+    dispatchEventLoop(EVENT_LOOP_PRIORITY_BULK, "fs.readdir", id, [=, this]() mutable {
+      auto ctx = getFSRequestContextPools(id).readdirs.acquire();
+      ctx->seq = seq;
+      ctx->desc = desc;
+      ctx->cb = std::move(cb);
+      ctx->dirents.resize(std::clamp(nentries, (size_t) 1, FS_READDIR_MAX_ENTRIES));
+
       std::lock_guard<std::recursive_mutex> descriptorLock(desc->mutex);
-      desc->dir->dirents = ctx->dirents;
-      desc->dir->nentries = nentries;
+      desc->dir->dirents = ctx->dirents.data();
+      desc->dir->nentries = ctx->dirents.size();
 
-      auto err = uv_fs_readdir(&this->eventLoop, &ctx->req, desc->dir, [](uv_fs_t *req) {
-        auto ctx = (DescriptorRequestContext *) req->data;
+      auto err = uv_fs_readdir(getEventLoop(id), &ctx->req, desc->dir, [](uv_fs_t *req) {
+        auto ctx = (FSReaddirRequestContext *) req->data;
         auto desc = ctx->desc;
         SSC::String msg;
 
@@ -390,21 +630,17 @@ namespace SSC {
           std::to_string(req->result),
           String(uv_strerror(req->result)));
         } else {
-          SSC::StringStream entries;
-          entries << "[";
+          JSONWriter entries(64 + req->result * 48);
+          entries.beginArray();
 
           for (int i = 0; i < req->result; ++i) {
-            entries << "{";
-            entries << "\"type\":" << std::to_string(desc->dir->dirents[i].type) << ",";
-            entries << "\"name\":" << "\"" << desc->dir->dirents[i].name << "\"";
-            entries << "}";
-
-            if (i + 1 < req->result) {
-              entries << ", ";
-            }
+            entries.beginObject()
+              .value("type", (int) desc->dir->dirents[i].type)
+              .value("name", desc->dir->dirents[i].name)
+              .endObject();
           }
 
-          entries << "]";
+          entries.endArray();
 
           msg = SSC::format(R"MSG({
             "source": "fs.readdir",
@@ -414,7 +650,7 @@ namespace SSC {
             }
           })MSG",
           std::to_string(desc->id),
-          entries.str());
+          entries.output);
         }
 
         ctx->end(msg);
@@ -440,7 +676,6 @@ namespace SSC {
 
   void Core::fsClose (String seq, uint64_t id, Callback cb) {
     auto desc = getDescriptor(id);
-    auto ctx = new DescriptorRequestContext(desc, seq, cb);
 
     if (desc == nullptr) {
       auto msg = SSC::format(R"MSG({
@@ -453,47 +688,13 @@ namespace SSC {
         }
       })MSG", std::to_string(id));
 
-      ctx->end(msg);
+      cb(seq, msg, Post{});
       return;
     }
 
-    dispatchEventLoop([ctx, desc, this]() {
-      auto err = uv_fs_close(&this->eventLoop, &ctx->req, desc->fd, [](uv_fs_t* req) {
-        auto ctx = (DescriptorRequestContext *) req->data;
-        auto desc = ctx->desc;
-        SSC::String msg;
-
-        if (req->result < 0) {
-          msg = SSC::format(R"MSG({
-            "source": "fs.close",
-            "err": {
-              "id": "$S",
-              "code": $S,
-              "message": "$S"
-            }
-          })MSG",
-          std::to_string(desc->id),
-          std::to_string(req->result),
-          String(uv_strerror(req->result)));
-        } else {
-          msg = SSC::format(R"MSG({
-            "source": "fs.close",
-            "data": {
-              "id": "$S",
-              "fd": $S
-            }
-          })MSG",
-          std::to_string(desc->id),
-          std::to_string(desc->fd));
-
-          desc->core->removeDescriptor(desc->id);
-          delete desc;
-        }
-
-        ctx->end(msg);
-      });
-
-      if (err < 0) {
+    desc->closing = true;
+    fs.close(id).start([=](auto result) {
+      if (!result.ok()) {
         auto msg = SSC::format(R"MSG({
           "source": "fs.close",
           "err": {
@@ -502,18 +703,31 @@ namespace SSC {
             "message": "$S"
           }
         })MSG",
-        std::to_string(desc->id),
-        std::to_string(err),
-        String(uv_strerror(err)));
+        std::to_string(id),
+        std::to_string(result.err),
+        String(uv_strerror(result.err)));
 
-        ctx->end(msg);
+        cb(seq, msg, Post{});
+        return;
       }
+
+      auto msg = SSC::format(R"MSG({
+        "source": "fs.close",
+        "data": {
+          "id": "$S",
+          "fd": $S
+        }
+      })MSG",
+      std::to_string(id),
+      std::to_string(result.value));
+
+      cb(seq, msg, Post{});
     });
   }
 
   void Core::fsClosedir (String seq, uint64_t id, Callback cb) {
     auto desc = getDescriptor(id);
-    auto ctx = new DescriptorRequestContext(desc, seq, cb);
+
     if (desc == nullptr) {
       auto msg = SSC::format(R"MSG({
         "source": "fs.closedir",
@@ -525,13 +739,19 @@ namespace SSC {
         }
       })MSG", std::to_string(id));
 
-      ctx->end(msg);
+      cb(seq, msg, Post{});
       return;
     }
 
-    dispatchEventLoop([=, this]() {
-      auto err = uv_fs_closedir(&this->eventLoop, &ctx->req, desc->dir, [](uv_fs_t* req) {
-        auto ctx = (DescriptorRequestContext *) req->data;
+    desc->closing = true;
+    dispatchEventLoop(EVENT_LOOP_PRIORITY_NORMAL, "fs.closedir", id, [=, this]() mutable {
+      auto ctx = getFSRequestContextPools(id).requests.acquire();
+      ctx->seq = seq;
+      ctx->desc = desc;
+      ctx->cb = std::move(cb);
+
+      auto err = uv_fs_closedir(getEventLoop(id), &ctx->req, desc->dir, [](uv_fs_t* req) {
+        auto ctx = (FSRequestContext *) req->data;
         auto desc = ctx->desc;
         SSC::String msg;
 
@@ -610,57 +830,44 @@ namespace SSC {
   }
 
   void Core::fsCloseOpenDescriptors (String seq, bool preserveRetained, Callback cb) {
-    std::lock_guard<std::recursive_mutex> guard(descriptorsMutex);
-
-    std::vector<uint64_t> ids;
+    std::vector<std::pair<uint64_t, bool>> closing; // (id, isDirectory)
     SSC::String msg = "";
-    int pending = descriptors.size();
-    int queued = 0;
-
-    for (auto const &tuple : descriptors) {
-      ids.push_back(tuple.first);
-    }
-
-    for (auto const id : ids) {
-      auto desc = descriptors[id];
-      pending--;
-
-      if (desc == nullptr) {
-        descriptors.erase(id);
-        continue;
-      }
 
+    descriptors.forEach([&](auto id, auto desc) {
       if (preserveRetained && desc->isRetained()) {
-        continue;
+        return;
       }
 
-      if (desc->isDirectory()) {
-        queued++;
-        this->fsClosedir(seq, id, [pending, cb](auto seq, auto msg, auto post) {
-          if (pending == 0) {
-            cb(seq, msg, post);
-          }
-        });
-      } else if (desc->isFile()) {
-        queued++;
-        this->fsClose(seq, id, [pending, cb](auto seq, auto msg, auto post) {
-          if (pending == 0) {
-            cb(seq, msg, post);
-          }
-        });
+      if (desc->isDirectory() || desc->isFile()) {
+        closing.push_back({ id, desc->isDirectory() });
       }
-    }
+    });
 
-    if (queued == 0) {
+    if (closing.size() == 0) {
       cb(seq, msg, Post{});
+      return;
+    }
+
+    // descriptors may live on different loops, so `cb` is called
+    // once by whichever close completes last
+    auto pending = std::make_shared<std::atomic<size_t>>(closing.size());
+    auto done = [pending, cb](auto seq, auto msg, auto post) {
+      if (pending->fetch_sub(1) == 1) {
+        cb(seq, msg, post);
+      }
+    };
+
+    for (auto const &[id, isDirectory] : closing) {
+      if (isDirectory) {
+        this->fsClosedir(seq, id, done);
+      } else {
+        this->fsClose(seq, id, done);
+      }
     }
   }
 
   void Core::fsRead (String seq, uint64_t id, int len, int offset, Callback cb) {
-    auto desc = getDescriptor(id);
-    auto ctx = new DescriptorRequestContext(desc, seq, cb);
-
-    if (desc == nullptr) {
+    if (getDescriptor(id) == nullptr) {
       auto msg = SSC::format(R"MSG({
         "source": "fs.read",
         "err": {
@@ -671,67 +878,273 @@ namespace SSC {
         }
       })MSG", std::to_string(id));
 
-      ctx->end(msg);
+      cb(seq, msg, Post{});
+      return;
+    }
+
+    if (len < 0) {
+      auto msg = SSC::format(R"MSG({
+        "source": "fs.read",
+        "err": {
+          "id": "$S",
+          "code": $S,
+          "message": "'size' must not be negative"
+        }
+      })MSG", std::to_string(id), std::to_string(UV_EINVAL));
+
+      cb(seq, msg, Post{});
       return;
     }
 
-    dispatchEventLoop([=, this]() {
-      auto buf = new char[len]{0};
-      ctx->setBuffer(0, len, buf);
+    auto buffer = Buffer::heap(len);
+    fs.read(id, buffer.data(), buffer.size(), offset).start([=](auto result) {
+      if (!result.ok()) {
+        auto msg = SSC::format(R"MSG({
+          "source": "fs.read",
+          "err": {
+            "id": "$S",
+            "code": $S,
+            "message": "$S"
+          }
+        })MSG",
+        std::to_string(id),
+        std::to_string(result.err),
+        String(uv_strerror(result.err)));
 
-      auto err = uv_fs_read(&this->eventLoop, &ctx->req, desc->fd, ctx->iov, 1, offset, [](uv_fs_t* req) {
-        auto ctx = static_cast<DescriptorRequestContext*>(req->data);
-        auto desc = ctx->desc;
-        SSC::String msg = "{}";
-        Post post = {0};
+        cb(seq, msg, Post{});
+        return;
+      }
 
-        if (req->result < 0) {
-          msg = SSC::format(R"MSG({
-            "source": "fs.read",
+      Post post;
+      post.id = SSC::rand64();
+      post.body = buffer.slice(0, result.value);
+
+      cb(seq, "{}", post);
+    });
+  }
+
+  // must be called on the descriptor's event loop
+  void Core::fsReadStreamChunk (uint64_t id, int64_t offset) {
+    auto desc = getDescriptor(id);
+    if (desc == nullptr) {
+      return;
+    }
+
+    auto &stream = desc->readStream;
+    auto chunk = fsReadStreamBufferPool.acquire();
+
+    stream.offset = offset;
+    stream.chunk = chunk;
+    stream.isReady = false;
+
+    // the completion holds `chunk`, the stream may let go of it (closed, or
+    // replaced by a pull at another offset) while the read is writing to it
+    fs.read(id, chunk.data(), chunk.size(), offset).start([=, this, chunk = chunk](auto result) {
+      auto desc = getDescriptor(id);
+
+      // closed, or a pull at another offset replaced this chunk
+      if (desc == nullptr || desc->readStream.offset != offset) {
+        return;
+      }
+
+      auto &stream = desc->readStream;
+      stream.err = result.err;
+      stream.bytes = result.ok() ? result.value : 0;
+      stream.isReady = true;
+
+      if (auto onready = std::exchange(stream.onready, nullptr)) {
+        onready(0);
+      }
+    });
+  }
+
+  // Replies with the chunk at `offset`, read ahead of time if it follows
+  // the last one pulled, then reads the next chunk ahead. At most the
+  // chunk being delivered and the one read ahead are held per descriptor.
+  void Core::fsReadStream (String seq, uint64_t id, int64_t offset, Callback cb) {
+    dispatchEventLoop(EVENT_LOOP_PRIORITY_BULK, "fs.readStream", id, [=, this]() {
+      auto desc = getDescriptor(id);
+
+      if (desc == nullptr) {
+        auto msg = SSC::format(R"MSG({
+          "source": "fs.readStream",
+          "err": {
+            "id": "$S",
+            "code": "ENOTOPEN",
+            "type": "NotFoundError",
+            "message": "No file descriptor found with that id"
+          }
+        })MSG", std::to_string(id));
+
+        cb(seq, msg, Post{});
+        return;
+      }
+
+      // a pull still waiting for its chunk is cancelled by the next one
+      if (auto onready = std::exchange(desc->readStream.onready, nullptr)) {
+        onready(UV_ECANCELED);
+      }
+
+      if (desc->readStream.offset != offset) {
+        fsReadStreamChunk(id, offset);
+      }
+
+      // `err` is set when the pull is cancelled or the descriptor closed
+      // before its chunk was read
+      auto deliver = [=, this](int err) {
+        auto desc = getDescriptor(id);
+        size_t bytes = 0;
+        Buffer chunk;
+
+        if (err == 0 && desc == nullptr) {
+          err = UV_EBADF;
+        }
+
+        if (err == 0) {
+          auto &stream = desc->readStream;
+          err = stream.err;
+          bytes = stream.bytes;
+          chunk = std::exchange(stream.chunk, Buffer());
+          stream.offset = -1;
+        }
+
+        if (err < 0) {
+          auto msg = SSC::format(R"MSG({
+            "source": "fs.readStream",
             "err": {
               "id": "$S",
               "code": $S,
               "message": "$S"
             }
           })MSG",
-          std::to_string(desc->id),
-          std::to_string(req->result),
-          String(uv_strerror(req->result)));
+          std::to_string(id),
+          std::to_string(err),
+          String(uv_strerror(err)));
+
+          cb(seq, msg, Post{});
+          return;
+        }
 
-          auto buf = ctx->getBuffer(0);
-          if (buf != nullptr) {
-            delete [] buf;
+        if (bytes > 0) {
+          fsReadStreamChunk(id, offset + bytes);
+        }
+
+        Post post;
+        post.id = SSC::rand64();
+        post.body = chunk.slice(0, bytes);
+
+        auto msg = SSC::format(R"MSG({
+          "source": "fs.readStream",
+          "data": {
+            "id": "$S",
+            "offset": $S,
+            "bytes": $S,
+            "done": $S
           }
-        } else {
-          post.id = SSC::rand64();
-          post.body = ctx->getBuffer(0);
-          post.length = (int) req->result;
-          post.bodyNeedsFree = true;
+        })MSG",
+        std::to_string(id),
+        std::to_string(offset),
+        std::to_string(bytes),
+        String(bytes == 0 ? "true" : "false"));
+
+        cb(seq, msg, post);
+      };
+
+      if (desc->readStream.isReady) {
+        deliver(0);
+      } else {
+        desc->readStream.onready = deliver;
+      }
+    });
+  }
+
+  // Replies with every segment in one post, packed back to back in the
+  // order given, and the bytes read for each in `sizes`.
+  void Core::fsReadv (String seq, uint64_t id, std::vector<FSSegment> segments, Callback cb) {
+    if (getDescriptor(id) == nullptr) {
+      auto msg = SSC::format(R"MSG({
+        "source": "fs.readv",
+        "err": {
+          "id": "$S",
+          "code": "ENOTOPEN",
+          "type": "NotFoundError",
+          "message": "No file descriptor found with that id"
         }
+      })MSG", std::to_string(id));
 
-        ctx->end(msg, post);
-      });
+      cb(seq, msg, Post{});
+      return;
+    }
 
-      if (err < 0) {
+    size_t size = 0;
+    for (const auto& segment : segments) {
+      size += segment.size;
+    }
+
+    auto buffer = Buffer::heap(size);
+    fs.readSegments(id, buffer.data(), segments).start([=](auto result) mutable {
+      if (!result.ok()) {
         auto msg = SSC::format(R"MSG({
-          "source": "fs.read",
+          "source": "fs.readv",
           "err": {
             "id": "$S",
+            "code": $S,
             "message": "$S"
           }
-        })MSG", std::to_string(id), String(uv_strerror(err)));
+        })MSG",
+        std::to_string(id),
+        std::to_string(result.err),
+        String(uv_strerror(result.err)));
 
-        delete [] buf;
-        ctx->end(msg);
+        cb(seq, msg, Post{});
+        return;
+      }
+
+      // segments cut short by the end of the file leave gaps to close
+      auto bytes = buffer.data();
+      size_t offset = 0;
+      size_t length = 0;
+      JSONWriter sizes(16 + segments.size() * 8);
+      sizes.beginArray();
+
+      for (size_t i = 0; i < segments.size(); ++i) {
+        if (length != offset) {
+          memmove(bytes + length, bytes + offset, result.value[i]);
+        }
+
+        length += result.value[i];
+        offset += segments[i].size;
+        sizes.value(result.value[i]);
       }
+
+      sizes.endArray();
+
+      Post post;
+      post.id = SSC::rand64();
+      post.body = buffer.slice(0, length);
+
+      auto msg = SSC::format(R"MSG({
+        "source": "fs.readv",
+        "data": {
+          "id": "$S",
+          "bytes": $S,
+          "sizes": $S
+        }
+      })MSG",
+      std::to_string(id),
+      std::to_string(length),
+      sizes.str());
+
+      cb(seq, msg, post);
     });
   }
 
   void Core::fsWrite (String seq, uint64_t id, String data, int64_t offset, Callback cb) {
-    auto desc = getDescriptor(id);
-    auto ctx = new DescriptorRequestContext(desc, seq, cb);
+    this->fsWrite(seq, id, Buffer::copy(data), offset, cb);
+  }
 
-    if (desc == nullptr) {
+  void Core::fsWrite (String seq, uint64_t id, Buffer data, int64_t offset, Callback cb) {
+    if (getDescriptor(id) == nullptr) {
       auto msg = SSC::format(R"MSG({
         "source": "fs.write",
         "err": {
@@ -742,57 +1155,104 @@ namespace SSC {
         }
       })MSG", std::to_string(id));
 
-      ctx->end(msg);
+      cb(seq, msg, Post{});
       return;
     }
 
-    auto size = data.size();
-    auto bytes = new char[size > 0 ? size : 1]{0};
-    memcpy(bytes, data.data(), size);
+    auto buffer = std::move(data);
 
-    ctx->setBuffer(0, size, bytes);
-    dispatchEventLoop([=, this]() {
-      auto err = uv_fs_write(&this->eventLoop, &ctx->req, desc->fd, ctx->iov, 1, offset, [](uv_fs_t* req) {
-        auto ctx = static_cast<DescriptorRequestContext*>(req->data);
-        auto desc = ctx->desc;
-        SSC::String msg;
+    // the callback holds `buffer` until the write completes
+    fs.write(id, buffer.data(), buffer.size(), offset).start([=, buffer = buffer](auto result) {
+      if (!result.ok()) {
+        auto msg = SSC::format(R"MSG({
+          "source": "fs.write",
+          "err": {
+            "id": "$S",
+            "code": $S,
+            "message": "$S"
+          }
+        })MSG",
+        std::to_string(id),
+        std::to_string(result.err),
+        String(uv_strerror(result.err)));
 
-        if (req->result < 0) {
-          msg = SSC::format(R"MSG({
-            "source": "fs.write",
-            "err": {
-              "id": "$S",
-              "code": $S,
-              "message": "$S"
-            }
-          })MSG",
-          std::to_string(desc->id),
-          std::to_string(req->result),
-          String(uv_strerror(req->result)));
-        } else {
-          msg = SSC::format(R"MSG({
-            "source": "fs.write",
-            "data": {
-              "id": "$S",
-              "result": "$S"
-            }
-          })MSG",
-          std::to_string(desc->id),
-          std::to_string(req->result));
+        cb(seq, msg, Post{});
+        return;
+      }
+
+      auto msg = SSC::format(R"MSG({
+        "source": "fs.write",
+        "data": {
+          "id": "$S",
+          "result": "$S"
         }
+      })MSG",
+      std::to_string(id),
+      std::to_string(result.value));
 
-        auto bytes = ctx->getBuffer(0);
-        if (bytes != nullptr) {
-          delete [] bytes;
+      cb(seq, msg, Post{});
+    });
+  }
+
+  // `data` holds every buffer back to back, `sizes` says where they split
+  void Core::fsWritev (
+    String seq,
+    uint64_t id,
+    Buffer data,
+    std::vector<size_t> sizes,
+    int64_t offset,
+    Callback cb
+  ) {
+    if (getDescriptor(id) == nullptr) {
+      auto msg = SSC::format(R"MSG({
+        "source": "fs.writev",
+        "err": {
+          "id": "$S",
+          "code": "ENOTOPEN",
+          "type": "NotFoundError",
+          "message": "No file descriptor found with that id"
         }
+      })MSG", std::to_string(id));
 
-        ctx->end(msg);
+      cb(seq, msg, Post{});
+      return;
+    }
 
-      });
+    std::vector<uv_buf_t> buffers;
+    size_t size = 0;
 
-      if (err < 0) {
+    buffers.reserve(sizes.size());
+    for (auto bytes : sizes) {
+      if (bytes > data.size() - size) {
+        break;
+      }
+
+      buffers.push_back(uv_buf_init(data.data() + size, (unsigned int) bytes));
+      size += bytes;
+    }
+
+    if (buffers.size() != sizes.size() || size != data.size()) {
+      auto msg = SSC::format(R"MSG({
+        "source": "fs.writev",
+        "err": {
+          "id": "$S",
+          "code": $S,
+          "message": "'sizes' must add up to the $S bytes sent"
+        }
+      })MSG",
+      std::to_string(id),
+      std::to_string(UV_EINVAL),
+      std::to_string(data.size()));
+
+      cb(seq, msg, Post{});
+      return;
+    }
+
+    // the callback holds `data` until the writes complete
+    fs.writev(id, std::move(buffers), offset).start([=, data = data](auto result) {
+      if (!result.ok()) {
         auto msg = SSC::format(R"MSG({
-          "source": "fs.write",
+          "source": "fs.writev",
           "err": {
             "id": "$S",
             "code": $S,
@@ -800,22 +1260,36 @@ namespace SSC {
           }
         })MSG",
         std::to_string(id),
-        std::to_string(err),
-        String(uv_strerror(err)));
+        std::to_string(result.err),
+        String(uv_strerror(result.err)));
 
-        delete [] bytes;
-        ctx->end(msg);
+        cb(seq, msg, Post{});
+        return;
       }
+
+      auto msg = SSC::format(R"MSG({
+        "source": "fs.writev",
+        "data": {
+          "id": "$S",
+          "result": "$S"
+        }
+      })MSG",
+      std::to_string(id),
+      std::to_string(result.value));
+
+      cb(seq, msg, Post{});
     });
   }
 
   void Core::fsStat (String seq, String path, Callback cb) {
-    dispatchEventLoop([=, this]() {
+    dispatchEventLoop(EVENT_LOOP_PRIORITY_NORMAL, "fs.stat", [=, this]() mutable {
       auto filename = path.c_str();
-      auto ctx = new DescriptorRequestContext(seq, cb);
+      auto ctx = getFSRequestContextPools().requests.acquire();
+      ctx->seq = seq;
+      ctx->cb = std::move(cb);
 
       auto err = uv_fs_stat(&this->eventLoop, &ctx->req, filename, [](uv_fs_t *req) {
-        auto ctx = (DescriptorRequestContext *) req->data;
+        auto ctx = (FSRequestContext *) req->data;
         SSC::String msg;
 
         if (req->result < 0) {
@@ -894,13 +1368,10 @@ namespace SSC {
   }
 
   void Core::fsFStat (String seq, uint64_t id, Callback cb) {
-    auto desc = getDescriptor(id);
-    auto ctx = new DescriptorRequestContext(desc, seq, cb);
-
-    if (desc == nullptr) {
+    if (getDescriptor(id) == nullptr) {
       auto msg = SSC::format(R"MSG({
+        "source": "fs.fstat",
         "err": {
-        "source": "fs.read",
           "id": "$S",
           "code": "ENOTOPEN",
           "type": "NotFoundError",
@@ -908,79 +1379,12 @@ namespace SSC {
         }
       })MSG", std::to_string(id));
 
-      ctx->end(msg);
+      cb(seq, msg, Post{});
       return;
     }
 
-    dispatchEventLoop([=, this]() {
-      auto err = uv_fs_fstat(&this->eventLoop, &ctx->req, desc->fd, [](uv_fs_t *req) {
-        auto ctx = (DescriptorRequestContext *) req->data;
-        auto desc = ctx->desc;
-        SSC::String msg;
-
-        if (req->result < 0) {
-          msg = SSC::format(R"MSG({
-            "source": "fs.fstat",
-            "err": {
-              "id": "$S",
-              "code": $S,
-              "message": "$S"
-            }
-          })MSG",
-          std::to_string(desc->id),
-          std::to_string(req->result),
-          String(uv_strerror(req->result)));
-        } else {
-          auto stats = uv_fs_get_statbuf(req);
-          msg = SSC::trim(SSC::format(R"MSG({
-            "source": "fs.fstat",
-            "data": {
-              "id": "$S",
-              "st_dev": "$S",
-              "st_mode": "$S",
-              "st_nlink": "$S",
-              "st_uid": "$S",
-              "st_gid": "$S",
-              "st_rdev": "$S",
-              "st_ino": "$S",
-              "st_size": "$S",
-              "st_blksize": "$S",
-              "st_blocks": "$S",
-              "st_flags": "$S",
-              "st_gen": "$S",
-              "st_atim": { "tv_sec": "$S", "tv_nsec": "$S" },
-              "st_mtim": { "tv_sec": "$S", "tv_nsec": "$S" },
-              "st_ctim": { "tv_sec": "$S", "tv_nsec": "$S" },
-              "st_birthtim": { "tv_sec": "$S", "tv_nsec": "$S" }
-            }
-          })MSG",
-          std::to_string(desc->id),
-          std::to_string(stats->st_dev),
-          std::to_string(stats->st_mode),
-          std::to_string(stats->st_nlink),
-          std::to_string(stats->st_uid),
-          std::to_string(stats->st_gid),
-          std::to_string(stats->st_rdev),
-          std::to_string(stats->st_ino),
-          std::to_string(stats->st_size),
-          std::to_string(stats->st_blksize),
-          std::to_string(stats->st_blocks),
-          std::to_string(stats->st_flags),
-          std::to_string(stats->st_gen),
-          std::to_string(stats->st_atim.tv_sec),
-          std::to_string(stats->st_atim.tv_nsec),
-          std::to_string(stats->st_mtim.tv_sec),
-          std::to_string(stats->st_mtim.tv_nsec),
-          std::to_string(stats->st_ctim.tv_sec),
-          std::to_string(stats->st_ctim.tv_nsec),
-          std::to_string(stats->st_birthtim.tv_sec),
-          std::to_string(stats->st_birthtim.tv_nsec)));
-        }
-
-        ctx->end(msg);
-      });
-
-      if (err < 0) {
+    fs.fstat(id).start([=](auto result) {
+      if (!result.ok()) {
         auto msg = SSC::format(R"MSG({
           "source": "fs.fstat",
           "err": {
@@ -990,56 +1394,95 @@ namespace SSC {
           }
         })MSG",
         std::to_string(id),
-        std::to_string(err),
-        String(uv_strerror(err)));
+        std::to_string(result.err),
+        String(uv_strerror(result.err)));
 
-        ctx->end(msg);
+        cb(seq, msg, Post{});
+        return;
       }
+
+      auto stats = &result.value;
+      auto msg = SSC::trim(SSC::format(R"MSG({
+        "source": "fs.fstat",
+        "data": {
+          "id": "$S",
+          "st_dev": "$S",
+          "st_mode": "$S",
+          "st_nlink": "$S",
+          "st_uid": "$S",
+          "st_gid": "$S",
+          "st_rdev": "$S",
+          "st_ino": "$S",
+          "st_size": "$S",
+          "st_blksize": "$S",
+          "st_blocks": "$S",
+          "st_flags": "$S",
+          "st_gen": "$S",
+          "st_atim": { "tv_sec": "$S", "tv_nsec": "$S" },
+          "st_mtim": { "tv_sec": "$S", "tv_nsec": "$S" },
+          "st_ctim": { "tv_sec": "$S", "tv_nsec": "$S" },
+          "st_birthtim": { "tv_sec": "$S", "tv_nsec": "$S" }
+        }
+      })MSG",
+      std::to_string(id),
+      std::to_string(stats->st_dev),
+      std::to_string(stats->st_mode),
+      std::to_string(stats->st_nlink),
+      std::to_string(stats->st_uid),
+      std::to_string(stats->st_gid),
+      std::to_string(stats->st_rdev),
+      std::to_string(stats->st_ino),
+      std::to_string(stats->st_size),
+      std::to_string(stats->st_blksize),
+      std::to_string(stats->st_blocks),
+      std::to_string(stats->st_flags),
+      std::to_string(stats->st_gen),
+      std::to_string(stats->st_atim.tv_sec),
+      std::to_string(stats->st_atim.tv_nsec),
+      std::to_string(stats->st_mtim.tv_sec),
+      std::to_string(stats->st_mtim.tv_nsec),
+      std::to_string(stats->st_ctim.tv_sec),
+      std::to_string(stats->st_ctim.tv_nsec),
+      std::to_string(stats->st_birthtim.tv_sec),
+      std::to_string(stats->st_birthtim.tv_nsec)));
+
+      cb(seq, msg, Post{});
     });
   }
 
   void Core::fsGetOpenDescriptors (String seq, Callback cb) {
-    std::lock_guard<std::recursive_mutex> guard(descriptorsMutex);
-    int pending = descriptors.size();
-    SSC::String msg = "{\n"
-      "  \"source\": \"fs.getOpenDescriptors\",\n"
-      "  \"data\": [";
-
-    for (auto const &tuple : descriptors) {
-      auto desc = tuple.second;
-      if (!desc) {
-        continue;
-      }
+    JSONWriter msg(64 + descriptors.size() * 64);
 
+    msg.beginObject()
+      .value("source", "fs.getOpenDescriptors")
+      .key("data").beginArray();
+
+    descriptors.forEach([&msg](auto id, auto desc) {
       if (desc->isStale() && !desc->isRetained()) {
-        continue;
+        return;
       }
 
-      msg += SSC::format(R"MSG({
-        "id": "$S",
-        "fd": "$S",
-        "type": "$S"
-      })MSG",
-      std::to_string(desc->id),
-      std::to_string(desc->isDirectory() ? desc->id : desc->fd),
-      desc->dir ? "directory" : "file");
+      msg.beginObject()
+        .value("id", std::to_string(desc->id))
+        .value("fd", std::to_string(desc->isDirectory() ? desc->id : desc->fd))
+        .value("type", desc->dir ? "directory" : "file")
+        .endObject();
+    });
 
-      if (--pending > 0) {
-        msg += ",\n";
-      }
-    }
-    msg += "]\n}";
+    msg.endArray().endObject();
 
-    cb(seq, msg, Post{});
+    cb(seq, msg.str(), Post{});
   }
 
   void Core::fsUnlink (String seq, String path, Callback cb) {
-    dispatchEventLoop([=, this]() {
+    dispatchEventLoop(EVENT_LOOP_PRIORITY_NORMAL, "fs.unlink", [=, this]() mutable {
       auto filename = path.c_str();
-      auto ctx = new DescriptorRequestContext(seq, cb);
+      auto ctx = getFSRequestContextPools().requests.acquire();
+      ctx->seq = seq;
+      ctx->cb = std::move(cb);
 
       auto err = uv_fs_unlink(&this->eventLoop, &ctx->req, filename, [](uv_fs_t *req) {
-        auto ctx = (DescriptorRequestContext *) req->data;
+        auto ctx = (FSRequestContext *) req->data;
         SSC::String msg;
 
         if (req->result < 0) {
@@ -1081,13 +1524,15 @@ namespace SSC {
   }
 
   void Core::fsRename (String seq, String pathA, String pathB, Callback cb) {
-    dispatchEventLoop([=, this]() {
-      auto ctx = new DescriptorRequestContext(seq, cb);
+    dispatchEventLoop(EVENT_LOOP_PRIORITY_NORMAL, "fs.rename", [=, this]() mutable {
+      auto ctx = getFSRequestContextPools().requests.acquire();
+      ctx->seq = seq;
+      ctx->cb = std::move(cb);
       auto src = pathA.c_str();
       auto dst = pathB.c_str();
 
       auto err = uv_fs_rename(&this->eventLoop, &ctx->req, src, dst, [](uv_fs_t *req) {
-        auto ctx = (DescriptorRequestContext *) req->data;
+        auto ctx = (FSRequestContext *) req->data;
         SSC::String msg;
 
         if (req->result < 0) {
@@ -1129,13 +1574,15 @@ namespace SSC {
   }
 
   void Core::fsCopyFile (String seq, String pathA, String pathB, int flags, Callback cb) {
-    dispatchEventLoop([=, this]() {
-      auto ctx = new DescriptorRequestContext(seq, cb);
+    dispatchEventLoop(EVENT_LOOP_PRIORITY_BULK, "fs.copyFile", [=, this]() mutable {
+      auto ctx = getFSRequestContextPools().requests.acquire();
+      ctx->seq = seq;
+      ctx->cb = std::move(cb);
       auto src = pathA.c_str();
       auto dst = pathB.c_str();
 
       auto err = uv_fs_copyfile(&this->eventLoop, &ctx->req, src, dst, flags, [](uv_fs_t *req) {
-        auto ctx = (DescriptorRequestContext *) req->data;
+        auto ctx = (FSRequestContext *) req->data;
         SSC::String msg;
 
         if (req->result < 0) {
@@ -1177,12 +1624,14 @@ namespace SSC {
   }
 
   void Core::fsRmdir (String seq, String path, Callback cb) {
-    dispatchEventLoop([=, this]() {
+    dispatchEventLoop(EVENT_LOOP_PRIORITY_NORMAL, "fs.rmdir", [=, this]() mutable {
       auto filename = path.c_str();
-      auto ctx = new DescriptorRequestContext(seq, cb);
+      auto ctx = getFSRequestContextPools().requests.acquire();
+      ctx->seq = seq;
+      ctx->cb = std::move(cb);
 
       auto err = uv_fs_rmdir(&this->eventLoop, &ctx->req, filename, [](uv_fs_t *req) {
-        auto ctx = (DescriptorRequestContext *) req->data;
+        auto ctx = (FSRequestContext *) req->data;
         SSC::String msg;
 
         if (req->result < 0) {
@@ -1224,12 +1673,14 @@ namespace SSC {
   }
 
   void Core::fsMkdir (String seq, String path, int mode, Callback cb) {
-    dispatchEventLoop([=, this]() {
+    dispatchEventLoop(EVENT_LOOP_PRIORITY_NORMAL, "fs.mkdir", [=, this]() mutable {
       auto filename = path.c_str();
-      auto ctx = new DescriptorRequestContext(seq, cb);
+      auto ctx = getFSRequestContextPools().requests.acquire();
+      ctx->seq = seq;
+      ctx->cb = std::move(cb);
 
       auto err = uv_fs_mkdir(&this->eventLoop, &ctx->req, filename, mode, [](uv_fs_t *req) {
-        auto ctx = (DescriptorRequestContext *) req->data;
+        auto ctx = (FSRequestContext *) req->data;
         SSC::String msg;
 
         if (req->result < 0) {
@@ -1272,25 +1723,18 @@ namespace SSC {
 
   String Core::getFSConstants () {
     auto constants = Core::getFSConstantsMap();
-    auto count = constants.size();
-    SSC::StringStream stream;
+    JSONWriter stream(64 + constants.size() * 32);
 
-    stream << "{\"source\": \"fs.constants\",";
-    stream << "\"data\": {";
+    stream.beginObject()
+      .value("source", "fs.constants")
+      .key("data").beginObject();
 
     for (auto const &tuple : constants) {
-      auto key = tuple.first;
-      auto value = tuple.second;
-
-      stream << "\"" << key << "\":" << value;
-
-      if (--count > 0) {
-        stream << ",";
-      }
+      // values are already formatted numbers
+      stream.key(tuple.first).raw(tuple.second);
     }
 
-    stream << "}";
-    stream << "}";
+    stream.endObject().endObject();
 
     return stream.str();
   }
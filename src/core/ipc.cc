@@ -0,0 +1,173 @@
+#include "core.hh"
+
+namespace SSC {
+  static uint16_t readUInt16 (const char *bytes) {
+    auto b = (const uint8_t *) bytes;
+    return (uint16_t) (b[0] | (b[1] << 8));
+  }
+
+  static uint32_t readUInt32 (const char *bytes) {
+    auto b = (const uint8_t *) bytes;
+    return (uint32_t) b[0] | ((uint32_t) b[1] << 8) | ((uint32_t) b[2] << 16) | ((uint32_t) b[3] << 24);
+  }
+
+  static int64_t readInt64 (const char *bytes) {
+    uint64_t value = 0;
+
+    for (int i = 7; i >= 0; --i) {
+      value = (value << 8) | (uint8_t) bytes[i];
+    }
+
+    return (int64_t) value;
+  }
+
+  static void writeUInt32 (char *bytes, uint32_t value) {
+    for (int i = 0; i < 4; ++i) {
+      bytes[i] = (char) ((value >> (8 * i)) & 0xff);
+    }
+  }
+
+  std::optional<IPCRequestFrame> decodeIPCRequestFrame (const char *bytes, size_t size) {
+    if (bytes == nullptr || size < IPC_REQUEST_FRAME_HEADER_SIZE) {
+      return std::nullopt;
+    }
+
+    if ((uint8_t) bytes[0] != IPC_FRAME_VERSION || (uint8_t) bytes[1] != IPC_FRAME_REQUEST) {
+      return std::nullopt;
+    }
+
+    auto command = readUInt16(bytes + 2);
+
+    if (command == COMMAND_UNKNOWN || command >= COMMAND_COUNT) {
+      return std::nullopt;
+    }
+
+    auto seq = readUInt32(bytes + 4);
+    auto index = (int32_t) readUInt32(bytes + 8);
+    auto fields = readUInt16(bytes + 12);
+
+    IPCRequestFrame frame = {
+      Parse(CommandTable::getName((command_t) command), index)
+    };
+
+    char number[24];
+    auto end = std::to_chars(number, number + sizeof(number), index).ptr;
+    frame.cmd.set("index", std::string_view(number, end - number));
+
+    if (seq > 0) {
+      number[0] = 'R';
+      end = std::to_chars(number + 1, number + sizeof(number), seq).ptr;
+      frame.cmd.set("seq", std::string_view(number, end - number));
+    }
+
+    size_t offset = IPC_REQUEST_FRAME_HEADER_SIZE;
+
+    for (uint16_t i = 0; i < fields; ++i) {
+      if (offset + 2 > size) {
+        return std::nullopt;
+      }
+
+      auto type = (uint8_t) bytes[offset];
+      auto keySize = (uint8_t) bytes[offset + 1];
+      offset += 2;
+
+      if (offset + keySize > size) {
+        return std::nullopt;
+      }
+
+      auto key = std::string_view(bytes + offset, keySize);
+      offset += keySize;
+
+      if (type == IPC_FIELD_INT) {
+        if (offset + 8 > size) {
+          return std::nullopt;
+        }
+
+        end = std::to_chars(number, number + sizeof(number), readInt64(bytes + offset)).ptr;
+        frame.cmd.set(key, std::string_view(number, end - number));
+        offset += 8;
+        continue;
+      }
+
+      if (type != IPC_FIELD_STRING && type != IPC_FIELD_BYTES) {
+        return std::nullopt;
+      }
+
+      if (offset + 4 > size) {
+        return std::nullopt;
+      }
+
+      auto length = readUInt32(bytes + offset);
+      offset += 4;
+
+      if (length > size - offset) {
+        return std::nullopt;
+      }
+
+      if (type == IPC_FIELD_STRING) {
+        frame.cmd.set(key, std::string_view(bytes + offset, length));
+      } else if (frame.body == nullptr) {
+        frame.body = bytes + offset;
+        frame.bodySize = length;
+      } else {
+        return std::nullopt;
+      }
+
+      offset += length;
+    }
+
+    return frame;
+  }
+
+  Buffer encodeIPCResponseFrame (const String& seq, const String& msg, const Post& post) {
+    uint32_t number = 0;
+
+    // sequences are `R<n>`, anything else (such as `-1`) is sent as 0
+    if (seq.size() > 1 && seq[0] == 'R') {
+      std::from_chars(seq.data() + 1, seq.data() + seq.size(), number);
+    }
+
+    auto headers = trim(post.headers);
+    auto size = IPC_RESPONSE_FRAME_HEADER_SIZE + msg.size() + headers.size();
+    auto frame = Buffer::heap(size);
+    auto bytes = frame.data();
+
+    bytes[0] = (char) IPC_FRAME_VERSION;
+    bytes[1] = (char) IPC_FRAME_RESPONSE;
+    bytes[2] = 0;
+    bytes[3] = 0;
+
+    writeUInt32(bytes + 4, number);
+    writeUInt32(bytes + 8, (uint32_t) msg.size());
+    writeUInt32(bytes + 12, (uint32_t) headers.size());
+    writeUInt32(bytes + 16, (uint32_t) post.body.size());
+
+    auto offset = IPC_RESPONSE_FRAME_HEADER_SIZE;
+    memcpy(bytes + offset, msg.data(), msg.size());
+    offset += msg.size();
+    memcpy(bytes + offset, headers.data(), headers.size());
+
+    return frame;
+  }
+
+  String getIPCNegotiateResult (uint8_t version, const char *transport) {
+    JSONWriter commands(CommandTable::NAMES * 24);
+    commands.beginObject();
+
+    for (size_t i = 0; i < CommandTable::NAMES; ++i) {
+      const auto& entry = COMMAND_NAMES[i];
+      commands.value(entry.name, (int) entry.command);
+    }
+
+    commands.endObject();
+
+    return SSC::format(R"MSG({
+      "source": "ipc.negotiate",
+      "data": {
+        "version": $i,
+        "transport": "$C",
+        "commands": $S
+      }
+    })MSG", (int) version, transport, commands.output);
+  }
+}
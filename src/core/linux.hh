@@ -5,4 +5,11 @@
 #include <webkit2/webkit2.h>
 #include <gtk/gtk.h>
 
+// binary IPC frames are POSTed, and scheme handlers can only read request
+// bodies since WebKitGTK 2.40, older versions negotiate the URI format
+#define SSC_IPC_FRAMES WEBKIT_CHECK_VERSION(2, 40, 0)
+
+// script messages carry typed arrays as is since WebKitGTK 2.38
+#define SSC_IPC_TYPED_ARRAYS WEBKIT_CHECK_VERSION(2, 38, 0)
+
 #endif
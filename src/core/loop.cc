@@ -1,7 +1,7 @@
 #include "core.hh"
 
 namespace SSC {
-#if defined(__linux__) && !defined(__ANDROID__)
+#if SSC_EVENT_LOOP_GSOURCE
   struct UVSource {
     GSource base; // should ALWAYS be first member
     gpointer tag;
@@ -30,6 +30,204 @@ namespace SSC {
   };
 #endif
 
+  static inline uint64_t now () {
+    return uv_hrtime() / 1000; // in microseconds
+  }
+
+  static inline void updateMax (std::atomic<uint64_t>& max, uint64_t value) {
+    auto current = max.load(std::memory_order_relaxed);
+    while (value > current && !max.compare_exchange_weak(current, value)) {}
+  }
+
+  void EventLoopHistogram::record (uint64_t value) {
+    int bucket = 0;
+    while (bucket < BUCKETS - 1 && (1ull << bucket) <= value) {
+      bucket++;
+    }
+
+    buckets[bucket].fetch_add(1, std::memory_order_relaxed);
+    count.fetch_add(1, std::memory_order_relaxed);
+    total.fetch_add(value, std::memory_order_relaxed);
+    updateMax(max, value);
+  }
+
+  uint64_t EventLoopHistogram::percentile (double p) const {
+    uint64_t target = count.load(std::memory_order_relaxed) * p;
+    uint64_t seen = 0;
+
+    for (int i = 0; i < BUCKETS; ++i) {
+      seen += buckets[i].load(std::memory_order_relaxed);
+      // report the upper bound of the bucket the percentile falls in,
+      // never more than the largest value recorded
+      if (seen > target) {
+        return std::min<uint64_t>(
+          i == 0 ? 0 : (1ull << i) - 1,
+          max.load(std::memory_order_relaxed)
+        );
+      }
+    }
+
+    return max.load(std::memory_order_relaxed);
+  }
+
+  String EventLoopHistogram::json () const {
+    JSONWriter value(128);
+    auto count = this->count.load(std::memory_order_relaxed);
+    auto total = this->total.load(std::memory_order_relaxed);
+
+    value.beginObject()
+      .value("count", count)
+      .value("mean", count > 0 ? total / count : 0)
+      .value("p50", percentile(0.5))
+      .value("p90", percentile(0.9))
+      .value("p99", percentile(0.99))
+      .value("max", max.load(std::memory_order_relaxed))
+      .endObject();
+
+    return value.str();
+  }
+
+  void EventLoopStats::recordQueueDepth (uint64_t depth) {
+    updateMax(maxQueueDepth, depth);
+  }
+
+  String FSRequestContextPools::json () const {
+    JSONWriter value(128);
+
+    value.beginObject()
+      .key("requests").beginObject()
+        .value("allocations", requests.allocations.load())
+        .value("acquisitions", requests.acquisitions.load())
+        .endObject()
+      .key("readdirs").beginObject()
+        .value("allocations", readdirs.allocations.load())
+        .value("acquisitions", readdirs.acquisitions.load())
+        .endObject()
+      .endObject();
+
+    return value.str();
+  }
+
+  String EventLoopStats::json (
+    size_t index,
+    size_t queueDepth,
+    const FSRequestContextPools &fsRequestContexts
+  ) const {
+    JSONWriter value(512);
+    auto lastStallName = this->lastStallName.load();
+    auto runningName = this->runningName.load();
+    auto runningSince = this->runningSince.load();
+
+    value.beginObject()
+      .value("index", index)
+      .value("iterations", iterations.load())
+      .value("dispatched", dispatched.load())
+      .value("queueDepth", queueDepth)
+      .value("maxQueueDepth", maxQueueDepth.load())
+      .value("stalls", stalls.load());
+
+    if (lastStallName != nullptr) {
+      value.key("lastStall").beginObject()
+        .value("name", lastStallName)
+        .value("duration", lastStallDuration.load())
+        .endObject();
+    } else {
+      value.key("lastStall").null();
+    }
+
+    // a callback that is still running past the threshold is a live stall
+    if (runningSince > 0) {
+      value.key("running").beginObject()
+        .value("name", runningName ? runningName : "anonymous")
+        .value("elapsed", now() - runningSince)
+        .endObject();
+    } else {
+      value.key("running").null();
+    }
+
+    value
+      .key("wait").raw(wait.json())
+      .key("run").raw(run.json())
+      .key("fsRequestContexts").raw(fsRequestContexts.json())
+      .endObject();
+
+    return value.str();
+  }
+
+  static void runEventLoopDispatch (EventLoopDispatch& dispatch, EventLoopStats& stats) {
+    static constexpr uint64_t threshold = SSC_EVENT_LOOP_STALL_THRESHOLD * 1000;
+    auto start = now();
+
+    stats.wait.record(start - dispatch.queuedAt);
+    stats.runningName = dispatch.name;
+    stats.runningSince = start;
+
+    dispatch.callback();
+
+    auto duration = now() - start;
+    stats.runningSince = 0;
+    stats.run.record(duration);
+    stats.dispatched++;
+
+    if (duration >= threshold) {
+      auto name = dispatch.name ? dispatch.name : "anonymous";
+      stats.stalls++;
+      stats.lastStallName = name;
+      stats.lastStallDuration = duration;
+      debug("Event loop stalled for %llu us in '%s'", (unsigned long long) duration, name);
+    }
+  }
+
+  static void drainEventLoopDispatchQueue (
+    uv_async_t *handle,
+    EventLoopDispatchQueue& queue,
+    EventLoopStats& stats
+  ) {
+    EventLoopDispatch dispatch;
+    int drained = 0;
+    bool idle = false;
+
+    // callbacks run without holding `loopMutex` so producers never block
+    // on the loop; drain in batches so a dispatch flood can't starve I/O.
+    // each round takes up to `EVENT_LOOP_PRIORITY_WEIGHTS[lane]` callbacks
+    // from every lane, highest priority first
+    while (drained < EVENT_LOOP_DISPATCH_BATCH_SIZE && !idle) {
+      idle = true;
+
+      for (int lane = 0; lane < EVENT_LOOP_PRIORITIES; ++lane) {
+        auto priority = (event_loop_priority_t) lane;
+
+        for (int i = 0; i < EVENT_LOOP_PRIORITY_WEIGHTS[lane]; ++i) {
+          if (drained >= EVENT_LOOP_DISPATCH_BATCH_SIZE) break;
+          if (!queue.pop(priority, dispatch)) break;
+
+          drained++;
+          idle = false;
+
+          if (dispatch.callback != nullptr) {
+            runEventLoopDispatch(dispatch, stats);
+          }
+
+          dispatch = EventLoopDispatch{};
+        }
+      }
+    }
+
+    // more work is pending, wake up again on the next loop iteration
+    if (!queue.empty()) {
+      uv_async_send(handle);
+    }
+  }
+
+  static void pollEventLoopShard (EventLoopShard *shard) {
+    // shards always block, `async` keeps them alive until `uv_stop()`
+    while (shard->isRunning && uv_loop_alive(&shard->loop)) {
+      uv_run(&shard->loop, UV_RUN_DEFAULT);
+    }
+
+    shard->isRunning = false;
+  }
+
   void Core::initEventLoop () {
     if (didLoopInit) {
       return;
@@ -41,16 +239,45 @@ namespace SSC {
     eventLoopAsync.data = (void *) this;
     uv_async_init(&eventLoop, &eventLoopAsync, [](uv_async_t *handle) {
       auto core = reinterpret_cast<SSC::Core  *>(handle->data);
-      while (true) {
-        std::lock_guard<std::recursive_mutex> lock(core->loopMutex);
-        if (core->eventLoopDispatchQueue.size() == 0) break;
-        auto dispatch = core->eventLoopDispatchQueue.front();
-        if (dispatch != nullptr) dispatch();
-        core->eventLoopDispatchQueue.pop();
-      }
+      drainEventLoopDispatchQueue(handle, core->eventLoopDispatchQueue, core->eventLoopStats);
+    });
+
+    // counts loop iterations, unreferenced so it never keeps the loop alive
+    eventLoopPrepare.data = (void *) this;
+    uv_prepare_init(&eventLoop, &eventLoopPrepare);
+    uv_prepare_start(&eventLoopPrepare, [](uv_prepare_t *handle) {
+      auto core = reinterpret_cast<SSC::Core  *>(handle->data);
+      core->eventLoopStats.iterations++;
     });
+    uv_unref((uv_handle_t *) &eventLoopPrepare);
 
-#if defined(__linux__) && !defined(__ANDROID__)
+    eventLoopCount = SSC_EVENT_LOOP_COUNT > 0
+      ? SSC_EVENT_LOOP_COUNT
+      : std::max(1u, std::thread::hardware_concurrency());
+
+    for (size_t i = 1; i < eventLoopCount; ++i) {
+      auto shard = new EventLoopShard();
+      shard->core = this;
+      shard->index = i;
+      shard->async.data = (void *) shard;
+      uv_loop_init(&shard->loop);
+      uv_async_init(&shard->loop, &shard->async, [](uv_async_t *handle) {
+        auto shard = reinterpret_cast<EventLoopShard *>(handle->data);
+        drainEventLoopDispatchQueue(handle, shard->dispatchQueue, shard->stats);
+      });
+
+      shard->prepare.data = (void *) shard;
+      uv_prepare_init(&shard->loop, &shard->prepare);
+      uv_prepare_start(&shard->prepare, [](uv_prepare_t *handle) {
+        auto shard = reinterpret_cast<EventLoopShard *>(handle->data);
+        shard->stats.iterations++;
+      });
+      uv_unref((uv_handle_t *) &shard->prepare);
+
+      eventLoopShards.push_back(shard);
+    }
+
+#if SSC_EVENT_LOOP_GSOURCE
     GSource *source = g_source_new(&loopSourceFunctions, sizeof(UVSource));
     UVSource *uvSource = (UVSource *) source;
     uvSource->core = this;
@@ -69,6 +296,62 @@ namespace SSC {
     return &eventLoop;
   }
 
+  size_t Core::getEventLoopIndex (uint64_t id) {
+    initEventLoop();
+    if (eventLoopCount <= 1) {
+      return 0;
+    }
+
+    // ids are usually random, but mix them anyway so sequential ids
+    // from user land still spread evenly (fibonacci hashing)
+    return ((id * 0x9E3779B97F4A7C15ull) >> 32) % eventLoopCount;
+  }
+
+  uv_loop_t* Core::getEventLoop (uint64_t id) {
+    auto index = getEventLoopIndex(id);
+    if (index == 0) {
+      return getEventLoop();
+    }
+
+    return &eventLoopShards[index - 1]->loop;
+  }
+
+  // only use the pools of the loop the caller is running on
+  FSRequestContextPools& Core::getFSRequestContextPools () {
+    return fsRequestContexts;
+  }
+
+  FSRequestContextPools& Core::getFSRequestContextPools (uint64_t id) {
+    auto index = getEventLoopIndex(id);
+    if (index == 0) {
+      return fsRequestContexts;
+    }
+
+    return eventLoopShards[index - 1]->fsRequestContexts;
+  }
+
+  String Core::getEventLoopStats () {
+    initEventLoop();
+    StringStream value;
+
+    value
+      << "{\"source\":\"loop.stats\",\"data\":{"
+      << "\"stallThreshold\":" << SSC_EVENT_LOOP_STALL_THRESHOLD << ","
+      << "\"loops\":["
+      << eventLoopStats.json(0, eventLoopDispatchQueue.size(), fsRequestContexts);
+
+    for (auto shard : eventLoopShards) {
+      value << "," << shard->stats.json(
+        shard->index,
+        shard->dispatchQueue.size(),
+        shard->fsRequestContexts
+      );
+    }
+
+    value << "]}}";
+    return value.str();
+  }
+
   int Core::getEventLoopTimeout () {
     auto loop = getEventLoop();
     uv_update_time(loop);
@@ -81,10 +364,34 @@ namespace SSC {
 
   void Core::stopEventLoop() {
     isLoopRunning = false;
+#if SSC_EVENT_LOOP_BLOCKING && !SSC_EVENT_LOOP_GSOURCE
+    // `uv_stop()` is not thread safe and does not interrupt a blocked
+    // `uv_run()`, so schedule it on the loop thread and wake it up
+    eventLoopDispatchQueue.push({
+      [this]() { uv_stop(&eventLoop); },
+      "uv_stop",
+      now(),
+      EVENT_LOOP_PRIORITY_REALTIME
+    });
+    uv_async_send(&eventLoopAsync);
+#else
     uv_stop(&eventLoop);
+#endif
+
+    for (auto shard : eventLoopShards) {
+      shard->isRunning = false;
+      shard->dispatchQueue.push({
+        [shard]() { uv_stop(&shard->loop); },
+        "uv_stop",
+        now(),
+        EVENT_LOOP_PRIORITY_REALTIME
+      });
+      uv_async_send(&shard->async);
+    }
+
 #if defined(__APPLE__)
     // noop
-#elif defined(__ANDROID__) || !defined(__linux__)
+#elif !SSC_EVENT_LOOP_GSOURCE
     std::lock_guard<std::recursive_mutex> lock(loopMutex);
     if (eventLoopThread != nullptr) {
       if (eventLoopThread->joinable()) {
@@ -95,6 +402,18 @@ namespace SSC {
       eventLoopThread = nullptr;
     }
 #endif
+
+    std::lock_guard<std::recursive_mutex> guard(loopMutex);
+    for (auto shard : eventLoopShards) {
+      if (shard->thread != nullptr) {
+        if (shard->thread->joinable()) {
+          shard->thread->join();
+        }
+
+        delete shard->thread;
+        shard->thread = nullptr;
+      }
+    }
   }
 
   void Core::sleepEventLoop (int64_t ms) {
@@ -116,14 +435,67 @@ namespace SSC {
   }
 
   void Core::dispatchEventLoop (EventLoopDispatchCallback callback) {
-    std::lock_guard<std::recursive_mutex> lock(loopMutex);
-    eventLoopDispatchQueue.push(callback);
+    dispatchEventLoop(EVENT_LOOP_PRIORITY_NORMAL, nullptr, std::move(callback));
+  }
+
+  void Core::dispatchEventLoop (uint64_t id, EventLoopDispatchCallback callback) {
+    dispatchEventLoop(EVENT_LOOP_PRIORITY_NORMAL, nullptr, id, std::move(callback));
+  }
+
+  void Core::dispatchEventLoop (
+    event_loop_priority_t priority,
+    const char *name,
+    EventLoopDispatchCallback callback
+  ) {
+    eventLoopDispatchQueue.push({ std::move(callback), name, now(), priority });
+    eventLoopStats.recordQueueDepth(eventLoopDispatchQueue.size());
     signalDispatchEventLoop();
   }
 
+  void Core::dispatchEventLoop (
+    event_loop_priority_t priority,
+    const char *name,
+    uint64_t id,
+    EventLoopDispatchCallback callback
+  ) {
+    auto index = getEventLoopIndex(id);
+    if (index == 0) {
+      return dispatchEventLoop(priority, name, std::move(callback));
+    }
+
+    auto shard = eventLoopShards[index - 1];
+    shard->dispatchQueue.push({ std::move(callback), name, now(), priority });
+    shard->stats.recordQueueDepth(shard->dispatchQueue.size());
+    runEventLoop();
+    uv_async_send(&shard->async);
+  }
+
+  void Core::dispatchEachEventLoop (std::function<void(size_t)> callback) {
+    initEventLoop();
+    dispatchEventLoop(EVENT_LOOP_PRIORITY_REALTIME, nullptr, [=]() { callback(0); });
+    for (auto shard : eventLoopShards) {
+      auto index = shard->index;
+      shard->dispatchQueue.push({
+        [=]() { callback(index); },
+        nullptr,
+        now(),
+        EVENT_LOOP_PRIORITY_REALTIME
+      });
+      uv_async_send(&shard->async);
+    }
+  }
+
   void pollEventLoop (Core *core) {
     auto loop = core->getEventLoop();
 
+#if SSC_EVENT_LOOP_BLOCKING
+    // `eventLoopAsync` keeps the loop alive, so `uv_run()` only returns
+    // after `uv_stop()` and the thread sleeps in the backend poll until
+    // there is I/O, a timer, or a `uv_async_send()` from a dispatch
+    while (core->isLoopRunning && core->isLoopAlive()) {
+      uv_run(loop, UV_RUN_DEFAULT);
+    }
+#else
     while (core->isLoopRunning) {
       core->sleepEventLoop(EVENT_LOOP_POLL_TIMEOUT);
 
@@ -131,17 +503,18 @@ namespace SSC {
         uv_run(loop, UV_RUN_DEFAULT);
       } while (core->isLoopRunning && core->isLoopAlive());
     }
+#endif
 
     core->isLoopRunning = false;
   }
 
   void Core::runEventLoop () {
-    if (isLoopRunning) {
+    // every producer may start the loop, only the first one to flip the
+    // flag initializes it and starts the threads
+    if (isLoopRunning.exchange(true)) {
       return;
     }
 
-    isLoopRunning = true;
-
     initEventLoop();
     dispatchEventLoop([=, this]() {
       initTimers();
@@ -151,7 +524,7 @@ namespace SSC {
 #if defined(__APPLE__)
     std::lock_guard<std::recursive_mutex> lock(loopMutex);
     dispatch_async(eventLoopQueue, ^{ pollEventLoop(this); });
-#elif defined(__ANDROID__) || !defined(__linux__)
+#elif !SSC_EVENT_LOOP_GSOURCE
     std::lock_guard<std::recursive_mutex> lock(loopMutex);
     // clean up old thread if still running
     if (eventLoopThread != nullptr) {
@@ -165,5 +538,19 @@ namespace SSC {
 
     eventLoopThread = new std::thread(&pollEventLoop, this);
 #endif
+
+    std::lock_guard<std::recursive_mutex> guard(loopMutex);
+    for (auto shard : eventLoopShards) {
+      if (shard->thread != nullptr) {
+        if (shard->thread->joinable()) {
+          shard->thread->join();
+        }
+
+        delete shard->thread;
+      }
+
+      shard->isRunning = true;
+      shard->thread = new std::thread(&pollEventLoopShard, shard);
+    }
   }
 }
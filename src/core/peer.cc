@@ -2,32 +2,58 @@
 
 namespace SSC {
   void Core::resumeAllPeers () {
-    dispatchEventLoop([=, this]() {
-      std::lock_guard<std::recursive_mutex> guard(this->peersMutex);
-      for (auto const &tuple : this->peers) {
-        auto peer = tuple.second;
-        if (peer != nullptr && (peer->isBound() || peer->isConnected())) {
+    // each loop only touches the handles it owns, filtered by id so peers
+    // of other loops are never dereferenced
+    dispatchEachEventLoop([=, this](size_t index) {
+      this->peers.forEach([&](auto id, auto peer) {
+        if (getEventLoopIndex(id) != index) {
+          return;
+        }
+
+        if (peer->isBound() || peer->isConnected()) {
           peer->resume();
         }
-      }
+      });
     });
   }
 
   void Core::pauseAllPeers () {
-    dispatchEventLoop([=, this]() {
-      std::lock_guard<std::recursive_mutex> guard(this->peersMutex);
-      for (auto const &tuple : this->peers) {
-        auto peer = tuple.second;
-        if (peer != nullptr && (peer->isBound() || peer->isConnected())) {
+    // each loop only touches the handles it owns, filtered by id so peers
+    // of other loops are never dereferenced
+    dispatchEachEventLoop([=, this](size_t index) {
+      this->peers.forEach([&](auto id, auto peer) {
+        if (getEventLoopIndex(id) != index) {
+          return;
+        }
+
+        if (peer->isBound() || peer->isConnected()) {
           peer->pause();
         }
-      }
+      });
+    });
+  }
+
+  void Core::applyPostsBackPressure () {
+    // the budget is read when each loop gets to it, so racing updates
+    // settle on the latest state
+    dispatchEachEventLoop([=, this](size_t index) {
+      auto throttle = isPostsOverBudget.load();
+      this->peers.forEach([&](auto id, auto peer) {
+        if (getEventLoopIndex(id) != index) {
+          return;
+        }
+
+        if (throttle) {
+          peer->throttle();
+        } else if (!peer->isClosing() && !peer->isClosed()) {
+          peer->unthrottle();
+        }
+      });
     });
   }
 
   bool Core::hasPeer (uint64_t peerId) {
-    std::lock_guard<std::recursive_mutex> guard(this->peersMutex);
-    return this->peers.find(peerId) != this->peers.end();
+    return this->peers.has(peerId);
   }
 
   void Core::removePeer (uint64_t peerId) {
@@ -35,23 +61,21 @@ namespace SSC {
   }
 
   void Core::removePeer (uint64_t peerId, bool autoClose) {
-    if (this->hasPeer(peerId)) {
-      if (autoClose) {
-        auto peer = this->getPeer(peerId);
-        if (peer != nullptr) {
-          peer->close();
-        }
-      }
+    auto peer = this->peers.get(peerId);
 
-      std::lock_guard<std::recursive_mutex> guard(this->peersMutex);
-      this->peers.erase(peerId);
+    if (peer == nullptr) {
+      return;
+    }
+
+    if (autoClose) {
+      peer->close();
     }
+
+    this->peers.remove(peerId);
   }
 
   Peer* Core::getPeer (uint64_t peerId) {
-    if (!this->hasPeer(peerId)) return nullptr;
-    std::lock_guard<std::recursive_mutex> guard(this->peersMutex);
-    return this->peers.at(peerId);
+    return this->peers.get(peerId);
   }
 
   Peer* Core::createPeer (peer_type_t peerType, uint64_t peerId) {
@@ -63,21 +87,17 @@ namespace SSC {
     uint64_t peerId,
     bool isEphemeral
   ) {
-    if (this->hasPeer(peerId)) {
-      auto peer = this->getPeer(peerId);
-      if (peer != nullptr) {
-        if (isEphemeral) {
-          std::lock_guard<std::recursive_mutex> guard(peer->mutex);
-          peer->flags = (peer_flag_t) (peer->flags | PEER_FLAG_EPHEMERAL);
-        }
+    if (auto peer = this->peers.get(peerId)) {
+      if (isEphemeral) {
+        std::lock_guard<std::recursive_mutex> guard(peer->mutex);
+        peer->flags = (peer_flag_t) (peer->flags | PEER_FLAG_EPHEMERAL);
       }
 
       return peer;
     }
 
     auto peer = new Peer(this, peerType, peerId, isEphemeral);
-    std::lock_guard<std::recursive_mutex> guard(this->peersMutex);
-    this->peers[peer->id] = peer;
+    this->peers.set(peer->id, peer);
     return peer;
   }
 
@@ -213,7 +233,7 @@ namespace SSC {
 
   int Peer::init () {
     std::lock_guard<std::recursive_mutex> guard(this->mutex);
-    auto loop = this->core->getEventLoop();
+    auto loop = this->core->getEventLoop(this->id);
     int err = 0;
 
     memset(&this->handle, 0, sizeof(this->handle));
@@ -552,12 +572,24 @@ namespace SSC {
 
     this->addState(PEER_STATE_UDP_RECV_STARTED);
 
+    // started with `onrecv` by `unthrottle()` once posts are back under budget
+    if (this->core->isPostsOverBudget) {
+      std::lock_guard<std::recursive_mutex> guard(this->mutex);
+      this->recv = onrecv;
+      this->addState(PEER_STATE_UDP_RECV_THROTTLED);
+      return 0;
+    }
+
     auto allocate = [](uv_handle_t *handle, size_t size, uv_buf_t *buf) {
-      if (size > 0) {
-        buf->base = (char *) new char[size]{0};
-        buf->len = size;
-        memset(buf->base, 0, buf->len);
+      auto peer = (Peer *) handle->data;
+
+      // reused until a datagram read into it is handed off
+      if (!peer->recvBuffer.unique()) {
+        peer->recvBuffer = peer->core->udpRecvBufferPool.acquire();
       }
+
+      auto &buffer = peer->recvBuffer;
+      *buf = uv_buf_init(buffer.data(), (unsigned int) buffer.size());
     };
 
     auto receive = [](
@@ -569,12 +601,6 @@ namespace SSC {
     ) {
       auto peer = (Peer *) handle->data;
 
-      if (nread <= 0) {
-        if (buf && buf->base) {
-          free(buf->base);
-        }
-      }
-
       if (nread == UV_ENOTCONN) {
         peer->recvstop();
         return;
@@ -601,12 +627,17 @@ namespace SSC {
           content-length: $i
         )MSG", (int) nread);
 
-        Post post = {0};
+        Post post;
         post.id = SSC::rand64();
-        post.body = buf->base;
-        post.length = (int) nread;
         post.headers = headers;
-        post.bodyNeedsFree = true;
+
+        // large datagrams are handed off in place, small ones are copied
+        // out so they do not each hold on to a whole block
+        if ((size_t) nread * 4 >= peer->recvBuffer.size()) {
+          post.body = peer->recvBuffer.slice(0, nread);
+        } else {
+          post.body = Buffer::copy(buf->base, nread);
+        }
 
         auto msg = SSC::format(R"MSG({
           "source": "udp.readStart",
@@ -618,7 +649,7 @@ namespace SSC {
           }
         })MSG",
         std::to_string(peer->id),
-        std::to_string(post.length),
+        std::to_string(post.body.size()),
         port,
         address);
 
@@ -635,6 +666,8 @@ namespace SSC {
   int Peer::recvstop () {
     int err = 0;
 
+    this->removeState(PEER_STATE_UDP_RECV_THROTTLED);
+
     if (this->hasState(PEER_STATE_UDP_RECV_STARTED)) {
       this->removeState(PEER_STATE_UDP_RECV_STARTED);
       std::lock_guard<std::recursive_mutex> lock(this->core->loopMutex);
@@ -644,6 +677,37 @@ namespace SSC {
     return err;
   }
 
+  // Stops reading while posts are over budget. The peer stays started, so
+  // `udp.readStop` still works and `unthrottle()` knows to read again.
+  int Peer::throttle () {
+    if (
+      !this->hasState(PEER_STATE_UDP_RECV_STARTED) ||
+      this->hasState(PEER_STATE_UDP_RECV_THROTTLED)
+    ) {
+      return 0;
+    }
+
+    this->addState(PEER_STATE_UDP_RECV_THROTTLED);
+    std::lock_guard<std::recursive_mutex> lock(this->core->loopMutex);
+    return uv_udp_recv_stop((uv_udp_t *) &this->handle);
+  }
+
+  // reads again if still started, `recvstop()` clears the throttle
+  int Peer::unthrottle () {
+    if (!this->hasState(PEER_STATE_UDP_RECV_THROTTLED)) {
+      return 0;
+    }
+
+    this->removeState(PEER_STATE_UDP_RECV_THROTTLED);
+
+    if (!this->hasState(PEER_STATE_UDP_RECV_STARTED)) {
+      return 0;
+    }
+
+    this->removeState(PEER_STATE_UDP_RECV_STARTED);
+    return this->recvstart();
+  }
+
   int Peer::resume () {
     int err = 0;
 
@@ -1,43 +1,159 @@
 #include "core.hh"
 
 namespace SSC {
-  static Timer releaseWeakDescriptors = {
-    .timeout = 256, // in milliseconds
-    .invoke = [](uv_timer_t *handle) {
-      auto core = reinterpret_cast<Core *>(handle->data);
-      std::vector<uint64_t> ids;
-      SSC::String msg = "";
+  static constexpr uint64_t RELEASE_WEAK_DESCRIPTORS_INTERVAL = 256; // in milliseconds
+  static constexpr uint64_t EXPIRE_POSTS_INTERVAL = 1024; // in milliseconds
+
+  void TimerWheel::schedule (uint64_t id, uint64_t expires) {
+    // timers due on the current tick only come from a cascade, which runs
+    // before the level 0 slot for the tick is fired, so they go there
+    auto delta = expires > this->now ? expires - this->now : 0;
+    int level = 0;
+
+    // the lowest level whose span covers `delta`, timers beyond the top
+    // level's span land there anyway and are rescheduled as it cascades
+    while (level < LEVELS - 1 && delta >= (1ull << (SLOT_BITS * (level + 1)))) {
+      level++;
+    }
+
+    auto index = (expires >> (SLOT_BITS * level)) & SLOT_MASK;
+    this->slots[level][index].push_back({ id, expires });
+  }
 
-      std::lock_guard<std::recursive_mutex> descriptorsGuard(core->descriptorsMutex);
-      for (auto const &tuple : core->descriptors) {
-        ids.push_back(tuple.first);
+  void TimerWheel::cascade (int level, uint64_t index) {
+    Slot slot;
+    std::swap(slot, this->slots[level][index]);
+
+    for (const auto& tuple : slot) {
+      auto entry = this->entries.find(tuple.first);
+      if (entry != this->entries.end() && entry->second.expires == tuple.second) {
+        this->schedule(tuple.first, tuple.second);
       }
+    }
+  }
 
-      for (auto const id : ids) {
-        std::lock_guard<std::recursive_mutex> descriptorsGuard(core->descriptorsMutex);
-        auto desc = core->descriptors.at(id);
+  void TimerWheel::set (uint64_t id, uint64_t timeout, uint64_t interval, TimerCallback callback) {
+    auto expires = this->now + (timeout > 0 ? timeout : 1);
+    // replaces an existing timer, its old slot entry becomes stale
+    this->entries.insert_or_assign(id, Entry { expires, interval, callback });
+    this->schedule(id, expires);
+  }
 
-        if (desc == nullptr) {
-          core->descriptors.erase(id);
-          continue;
+  bool TimerWheel::clear (uint64_t id) {
+    return this->entries.erase(id) > 0;
+  }
+
+  bool TimerWheel::has (uint64_t id) const {
+    return this->entries.find(id) != this->entries.end();
+  }
+
+  size_t TimerWheel::size () const {
+    return this->entries.size();
+  }
+
+  void TimerWheel::advance (uint64_t now) {
+    if (this->entries.size() == 0) {
+      // nothing to fire, drop stale slot entries and jump ahead
+      for (auto& level : this->slots) {
+        for (auto& slot : level) {
+          slot.clear();
+        }
+      }
+
+      this->now = std::max(this->now, now);
+      return;
+    }
+
+    std::vector<TimerCallback> callbacks;
+
+    while (this->now < now) {
+      auto tick = ++this->now;
+
+      // moving into a new block of a level pulls its next slot down
+      for (int level = 1; level < LEVELS; ++level) {
+        auto shift = SLOT_BITS * level;
+        if ((tick & ((1ull << shift) - 1)) != 0) {
+          break;
         }
 
-        if (desc->isRetained() || !desc->isStale()) {
+        this->cascade(level, (tick >> shift) & SLOT_MASK);
+      }
+
+      Slot slot;
+      std::swap(slot, this->slots[0][tick & SLOT_MASK]);
+
+      for (const auto& tuple : slot) {
+        auto id = tuple.first;
+        auto entry = this->entries.find(id);
+
+        if (entry == this->entries.end() || entry->second.expires != tuple.second) {
           continue;
         }
 
-        if (desc->isDirectory()) {
-          core->fsClosedir("", id, [](auto seq, auto msg, auto post) {});
-        } else if (desc->isFile()) {
-          core->fsClose("", id, [](auto seq, auto msg, auto post) {});
+        callbacks.push_back(entry->second.callback);
+
+        if (entry->second.interval > 0) {
+          entry->second.expires = tick + entry->second.interval;
+          this->schedule(id, entry->second.expires);
         } else {
-          // free
-          core->descriptors.erase(id);
-          delete desc;
+          this->entries.erase(entry);
         }
       }
     }
-  };
+
+    // callbacks may set or clear timers, so call them once the wheel is settled
+    for (const auto& callback : callbacks) {
+      if (callback != nullptr) {
+        callback();
+      }
+    }
+  }
+
+  uint64_t TimerWheel::timeout () const {
+    if (this->entries.size() == 0) {
+      return IDLE;
+    }
+
+    // the next occupied level 0 slot, or the next cascade, whichever is first
+    for (uint64_t i = 1; i < SLOTS; ++i) {
+      auto tick = this->now + i;
+      if ((tick & SLOT_MASK) == 0 || this->slots[0][tick & SLOT_MASK].size() > 0) {
+        return i;
+      }
+    }
+
+    return SLOTS - (this->now & SLOT_MASK);
+  }
+
+  static void releaseWeakDescriptors (Core *core) {
+    // closing removes descriptors, so walk handles instead of the table
+    for (auto handle : core->descriptors.handles()) {
+      auto desc = core->descriptors.resolve(handle);
+
+      if (desc == nullptr) {
+        continue;
+      }
+
+      if (desc->isRetained() || !desc->isStale()) {
+        continue;
+      }
+
+      // this runs every interval, a close still in flight is left to finish
+      if (desc->closing.exchange(true)) {
+        continue;
+      }
+
+      if (desc->isDirectory()) {
+        core->fsClosedir("", desc->id, [](auto seq, auto msg, auto post) {});
+      } else if (desc->isFile()) {
+        core->fsClose("", desc->id, [](auto seq, auto msg, auto post) {});
+      } else {
+        // free
+        core->descriptors.remove(desc->id);
+        delete desc;
+      }
+    }
+  }
 
   void Core::initTimers () {
     if (didTimersInit) {
@@ -48,62 +164,132 @@ namespace SSC {
 
     auto loop = getEventLoop();
 
-    std::vector<Timer *> timersToInit = {
-      &releaseWeakDescriptors
-    };
+    uv_timer_init(loop, &timerWheelHandle);
+    timerWheelHandle.data = (void *) this;
+    timerWheel.now = uv_now(loop);
 
-    for (const auto& timer : timersToInit) {
-      uv_timer_init(loop, &timer->handle);
-      timer->handle.data = (void *) this;
-    }
+    timerWheel.set(rand64(), RELEASE_WEAK_DESCRIPTORS_INTERVAL, RELEASE_WEAK_DESCRIPTORS_INTERVAL, [this]() {
+      releaseWeakDescriptors(this);
+    });
+
+    timerWheel.set(rand64(), EXPIRE_POSTS_INTERVAL, EXPIRE_POSTS_INTERVAL, [this]() {
+      expirePosts();
+    });
+
+#if DEBUG
+    // periodic `loop.stats` dump so loop stalls can be lined up with UI jank
+    timerWheel.set(rand64(), EVENT_LOOP_STATS_DUMP_INTERVAL, EVENT_LOOP_STATS_DUMP_INTERVAL, [this]() {
+      debug("%s", getEventLoopStats().c_str());
+    });
+#endif
 
     didTimersInit = true;
   }
 
   void Core::startTimers () {
     std::lock_guard<std::recursive_mutex> guard(timersMutex);
+    didTimersStart = true;
+    scheduleTimers();
+  }
 
-    std::vector<Timer *> timersToStart = {
-      &releaseWeakDescriptors
-    };
-
-    for (const auto &timer : timersToStart) {
-      if (timer->started) {
-        uv_timer_again(&timer->handle);
-      } else {
-        timer->started = 0 == uv_timer_start(
-          &timer->handle,
-          timer->invoke,
-          timer->timeout,
-          !timer->repeated
-            ? 0
-            : timer->interval > 0
-              ? timer->interval
-              : timer->timeout
-        );
-      }
+  void Core::stopTimers () {
+    if (didTimersStart == false) {
+      return;
     }
 
+    std::lock_guard<std::recursive_mutex> guard(timersMutex);
+    uv_timer_stop(&timerWheelHandle);
     didTimersStart = false;
   }
 
-  void Core::stopTimers () {
-    if (didTimersStart == false) {
+  // must be called on the primary event loop
+  void Core::scheduleTimers () {
+    std::lock_guard<std::recursive_mutex> guard(timersMutex);
+
+    if (!didTimersInit || !didTimersStart) {
       return;
     }
 
-    std::lock_guard<std::recursive_mutex> guard(timersMutex);
+    auto timeout = timerWheel.timeout();
 
-    std::vector<Timer *> timersToStop = {
-      &releaseWeakDescriptors
-    };
+    if (timeout == TimerWheel::IDLE) {
+      uv_timer_stop(&timerWheelHandle);
+      return;
+    }
+
+    uv_timer_start(&timerWheelHandle, [](uv_timer_t *handle) {
+      auto core = reinterpret_cast<Core *>(handle->data);
+      core->timerWheel.advance(uv_now(handle->loop));
+      core->scheduleTimers();
+    }, timeout, 0);
+  }
+
+  void Core::setTimer (uint64_t id, uint64_t timeout, uint64_t interval, TimerCallback callback) {
+    dispatchEventLoop(EVENT_LOOP_PRIORITY_REALTIME, "timer.set", [=, this]() {
+      initTimers();
+      timerWheel.advance(uv_now(getEventLoop()));
+      timerWheel.set(id, timeout, interval, callback);
+      scheduleTimers();
+    });
+  }
+
+  void Core::clearTimer (uint64_t id) {
+    dispatchEventLoop(EVENT_LOOP_PRIORITY_REALTIME, "timer.clear", [=, this]() {
+      timerWheel.clear(id);
+      scheduleTimers();
+    });
+  }
+
+  void Core::timerSet (String seq, uint64_t id, uint64_t timeout, uint64_t interval, Callback cb) {
+    setTimer(id, timeout, interval, [=]() {
+      auto msg = SSC::format(R"MSG({
+        "source": "timer.fire",
+        "data": {
+          "id": "$S",
+          "interval": $S
+        }
+      })MSG", std::to_string(id), std::to_string(interval));
 
-    for (const auto& timer : timersToStop) {
-      if (timer->started) {
-        uv_timer_stop(&timer->handle);
+      cb("-1", msg, Post{});
+    });
+
+    auto msg = SSC::format(R"MSG({
+      "source": "timer.set",
+      "data": {
+        "id": "$S"
       }
-    }
+    })MSG", std::to_string(id));
 
-    didTimersStart = false;
+    cb(seq, msg, Post{});
+  }
+
+  void Core::timerClear (String seq, uint64_t id, Callback cb) {
+    dispatchEventLoop(EVENT_LOOP_PRIORITY_REALTIME, "timer.clear", [=, this]() {
+      if (!timerWheel.clear(id)) {
+        auto msg = SSC::format(R"MSG({
+          "source": "timer.clear",
+          "err": {
+            "id": "$S",
+            "code": "NOT_FOUND_ERR",
+            "type": "NotFoundError",
+            "message": "No timer with specified id"
+          }
+        })MSG", std::to_string(id));
+
+        cb(seq, msg, Post{});
+        return;
+      }
+
+      scheduleTimers();
+
+      auto msg = SSC::format(R"MSG({
+        "source": "timer.clear",
+        "data": {
+          "id": "$S"
+        }
+      })MSG", std::to_string(id));
+
+      cb(seq, msg, Post{});
+    });
   }
 }
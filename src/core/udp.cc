@@ -15,7 +15,7 @@ namespace SSC {
       return;
     }
 
-    dispatchEventLoop([=, this]() {
+    dispatchEventLoop(EVENT_LOOP_PRIORITY_REALTIME, "udp.bind", peerId, [=, this]() {
       auto peer = createPeer(PEER_TYPE_UDP, peerId);
       auto err = peer->bind(address, port, reuseAddr);
 
@@ -61,7 +61,7 @@ namespace SSC {
   }
 
   void Core::udpConnect (String seq, uint64_t peerId, String address, int port, Callback cb) {
-    dispatchEventLoop([=, this]() {
+    dispatchEventLoop(EVENT_LOOP_PRIORITY_REALTIME, "udp.connect", peerId, [=, this]() {
       auto peer = createPeer(PEER_TYPE_UDP, peerId);
       auto err = peer->connect(address, port);
 
@@ -106,7 +106,7 @@ namespace SSC {
   }
 
   void Core::udpDisconnect (String seq, uint64_t peerId, Callback cb) {
-    dispatchEventLoop([=, this]() {
+    dispatchEventLoop(EVENT_LOOP_PRIORITY_REALTIME, "udp.disconnect", peerId, [=, this]() {
       if (!hasPeer(peerId)) {
         auto msg = SSC::format(R"MSG({
           "source": "udp.disconnect",
@@ -288,110 +288,190 @@ namespace SSC {
     cb(seq, msg, Post{});
   }
 
-  void Core::udpSend (String seq, uint64_t peerId, char* buf, int len, int port, String address, bool ephemeral, Callback cb) {
-    auto buffer = new char[len > 0 ? len : 1]{0};
-    auto peer = createPeer(PEER_TYPE_UDP, peerId, ephemeral);
-    auto ctx = new PeerRequestContext(seq, cb);
-
-    memcpy(buffer, buf, len);
-    ctx->bufsize = len;
-    ctx->buf = buffer;
-    ctx->port = port;
-    ctx->address = address;
-    ctx->peer = peer;
-
-    dispatchEventLoop([=, this]() {
-      ctx->peer->send(ctx->seq, ctx->buf, ctx->bufsize, ctx->port, ctx->address, [ctx](auto seq, auto msg, auto post) {
-        ctx->cb(seq, msg, post);
-        delete [] ctx->buf;
-      });
-    });
-  }
+  void UDPSendAwaiter::await_suspend (std::coroutine_handle<> handle) {
+    this->handle = handle;
 
-  void Core::udpReadStart (String seq, uint64_t peerId, Callback cb) {
-    if (!hasPeer(peerId)) {
-      auto msg = SSC::format(R"MSG({
-        "source": "udp.readStart",
-        "err": {
-          "id": "$S",
-          "message": "No such peer"
+    core->dispatchEventLoop(EVENT_LOOP_PRIORITY_REALTIME, "udp.send", peerId, [this]() {
+      // peers own a uv handle, so they must be created on the loop thread
+      int err = 0;
+      peer = core->createPeer(PEER_TYPE_UDP, peerId, ephemeral);
+
+      {
+        std::lock_guard<std::recursive_mutex> guard(peer->mutex);
+        struct sockaddr *sockaddr = nullptr;
+
+        if (!peer->isConnected()) {
+          sockaddr = (struct sockaddr *) &peer->addr;
+          err = uv_ip4_addr((char *) address.c_str(), port, &peer->addr);
         }
-      })MSG", std::to_string(peerId));
 
-      cb(seq, msg, Post{});
-      return;
-    }
+        if (err == 0) {
+          auto buffer = uv_buf_init(bytes, (unsigned int) size);
+          req.data = (void *) this;
+          err = uv_udp_send(&req, (uv_udp_t *) &peer->handle, &buffer, 1, sockaddr, [](uv_udp_send_t *req, int status) {
+            auto awaiter = reinterpret_cast<UDPSendAwaiter *>(req->data);
 
-    auto peer = getPeer(peerId);
+            if (awaiter->peer->isEphemeral()) {
+              awaiter->peer->close();
+            }
 
-    if (peer->isActive()) {
-      auto msg = SSC::format(R"MSG({
-        "source": "udp.readStart",
-        "data": {
-          "id": "$S"
+            awaiter->resolve(status);
+          });
         }
-      })MSG", std::to_string(peerId));
-      cb(seq, msg, Post{});
-      return;
-    }
+      }
 
-    if (peer->isClosing()) {
-      auto msg = SSC::format(R"MSG({
-        "source": "udp.readStart",
-        "err": {
-          "id": "$S",
-          "message": "Peer is closing"
-        }
-      })MSG", std::to_string(peerId));
+      if (err < 0) {
+        resolve(err);
+      }
+    });
+  }
 
-      cb(seq, msg, Post{});
-      return;
-    }
+  void UDPSendAwaiter::resolve (int status) {
+    this->status = status;
+    this->handle.resume();
+  }
+
+  Task<AsyncResult<int>> Core::UDP::send (
+    uint64_t peerId,
+    char *bytes,
+    size_t size,
+    int port,
+    String address,
+    bool ephemeral
+  ) {
+    auto request = UDPSendAwaiter {
+      core, peerId, bytes, size, port, address, ephemeral
+    };
+
+    auto status = co_await request;
+
+    co_return AsyncResult<int> { status < 0 ? status : 0, status };
+  }
+
+  void Core::udpSend (String seq, uint64_t peerId, char* buf, int len, int port, String address, bool ephemeral, Callback cb) {
+    this->udpSend(seq, peerId, Buffer::copy(buf, len > 0 ? len : 0), port, address, ephemeral, cb);
+  }
+
+  void Core::udpSend (String seq, uint64_t peerId, Buffer data, int port, String address, bool ephemeral, Callback cb) {
+    auto buffer = std::move(data);
+
+    // the callback holds `buffer` until the datagram is sent
+    udp.send(peerId, buffer.data(), buffer.size(), port, address, ephemeral).start([=, buffer = buffer](auto result) {
+      if (!result.ok()) {
+        auto msg = SSC::format(R"MSG({
+          "source": "udp.send",
+          "err": {
+            "id": "$S",
+            "message": "$S"
+          }
+        })MSG",
+        std::to_string(peerId),
+        SSC::String(uv_strerror(result.err)));
+
+        cb(seq, msg, Post{});
+        return;
+      }
 
-    if (peer->hasState(PEER_STATE_UDP_RECV_STARTED)) {
       auto msg = SSC::format(R"MSG({
-       "source": "udp.readStart",
-        "err": {
+        "source": "udp.send",
+        "data": {
           "id": "$S",
-          "message": "Peer is already receiving"
+          "status": "$i"
         }
-      })MSG", std::to_string(peerId));
+      })MSG",
+      std::to_string(peerId),
+      result.value);
 
       cb(seq, msg, Post{});
-      return;
-    }
+    });
+  }
 
-    auto err = peer->recvstart(cb);
+  void Core::udpReadStart (String seq, uint64_t peerId, Callback cb) {
+    dispatchEventLoop(EVENT_LOOP_PRIORITY_REALTIME, "udp.readStart", peerId, [=, this]() {
+      if (!hasPeer(peerId)) {
+        auto msg = SSC::format(R"MSG({
+          "source": "udp.readStart",
+          "err": {
+            "id": "$S",
+            "message": "No such peer"
+          }
+        })MSG", std::to_string(peerId));
+
+        cb(seq, msg, Post{});
+        return;
+      }
+
+      auto peer = getPeer(peerId);
 
-    // `UV_EALREADY || UV_EBUSY` means there is active IO on the underlying handle
-    if (err < 0 && err != UV_EALREADY && err != UV_EBUSY) {
-      auto msg = SSC::format(
-        R"MSG({
+      if (peer->isActive()) {
+        auto msg = SSC::format(R"MSG({
+          "source": "udp.readStart",
+          "data": {
+            "id": "$S"
+          }
+        })MSG", std::to_string(peerId));
+        cb(seq, msg, Post{});
+        return;
+      }
+
+      if (peer->isClosing()) {
+        auto msg = SSC::format(R"MSG({
           "source": "udp.readStart",
           "err": {
             "id": "$S",
-            "message": "$S"
+            "message": "Peer is closing"
           }
-        })MSG",
-        std::to_string(peerId),
-        SSC::String(uv_strerror(err))
-      );
+        })MSG", std::to_string(peerId));
 
-      cb(seq, msg, Post{});
-      return;
-    }
+        cb(seq, msg, Post{});
+        return;
+      }
 
-    auto msg = SSC::format(R"MSG({
-      "source": "udp.readStart",
-      "data": {
-        "id": "$S"
+      if (peer->hasState(PEER_STATE_UDP_RECV_STARTED)) {
+        auto msg = SSC::format(R"MSG({
+         "source": "udp.readStart",
+          "err": {
+            "id": "$S",
+            "message": "Peer is already receiving"
+          }
+        })MSG", std::to_string(peerId));
+
+        cb(seq, msg, Post{});
+        return;
       }
-    })MSG", std::to_string(peerId));
-    cb(seq, msg, Post{});
+
+      auto err = peer->recvstart(cb);
+
+      // `UV_EALREADY || UV_EBUSY` means there is active IO on the underlying handle
+      if (err < 0 && err != UV_EALREADY && err != UV_EBUSY) {
+        auto msg = SSC::format(
+          R"MSG({
+            "source": "udp.readStart",
+            "err": {
+              "id": "$S",
+              "message": "$S"
+            }
+          })MSG",
+          std::to_string(peerId),
+          SSC::String(uv_strerror(err))
+        );
+
+        cb(seq, msg, Post{});
+        return;
+      }
+
+      auto msg = SSC::format(R"MSG({
+        "source": "udp.readStart",
+        "data": {
+          "id": "$S"
+        }
+      })MSG", std::to_string(peerId));
+      cb(seq, msg, Post{});
+    });
   }
 
   void Core::udpReadStop (String seq, uint64_t peerId, Callback cb) {
-    dispatchEventLoop([=, this] {
+    dispatchEventLoop(EVENT_LOOP_PRIORITY_REALTIME, "udp.readStop", peerId, [=, this] {
       if (!hasPeer(peerId)) {
         auto msg = SSC::format(R"MSG({
           "source": "udp.readStop",
@@ -461,7 +541,7 @@ namespace SSC {
   }
 
   void Core::udpClose (String seq, uint64_t peerId, Callback cb) {
-    dispatchEventLoop([=, this]() {
+    dispatchEventLoop(EVENT_LOOP_PRIORITY_REALTIME, "udp.close", peerId, [=, this]() {
       if (!hasPeer(peerId)) {
         auto msg = SSC::format(R"MSG({
           "source": "udp.close",
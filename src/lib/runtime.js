@@ -34,6 +34,12 @@ document.addEventListener('DOMContentLoaded', () => {
       const result = window.external.invoke(`ipc://event?value=domcontentloaded&index=${index}`)
       if (result.catch) result.catch(console.error)
     } catch (err) { console.error(err) }
+
+    if (/linux/i.test(window.process?.platform)) {
+      window._ipc.poll().catch(console.error)
+    }
+
+    window._ipc.negotiate().catch(console.error)
   })
 })
 
@@ -41,6 +47,10 @@ window._ipc = new class IPC {
   nextSeq = 1
   streams = {}
 
+  // settled by `negotiate()`, version 0 is the `ipc://` URI format and
+  // `transport` is how request bodies reach native code on linux
+  protocol = { version: 0, commands: {}, transport: 'string' }
+
   async resolve (seq, status, value) {
     if (typeof value === 'string') {
       let didDecodeURIComponent = false
@@ -82,6 +92,164 @@ window._ipc = new class IPC {
     delete this[seq];
   }
 
+  // asks for the binary frame format, anything but a usable answer (such
+  // as a platform without `ipc.negotiate`) keeps the URI format
+  async negotiate () {
+    const index = window.process?.index || 0
+    const result = await new Promise(resolve => {
+      const xhr = new XMLHttpRequest()
+      xhr.onload = () => resolve(xhr.responseText)
+      xhr.onerror = () => resolve(null)
+      xhr.open('GET', `ipc://ipc.negotiate?version=1&index=${index}`)
+      xhr.send()
+    })
+
+    let data = null
+    try { data = JSON.parse(result)?.data } catch {}
+
+    if (data?.version >= 1 && data.commands) {
+      this.protocol = { ...this.protocol, version: data.version, commands: data.commands }
+    }
+
+    if (typeof data?.transport === 'string') {
+      this.protocol.transport = data.transport
+    }
+
+    return this.protocol
+  }
+
+  //  <header>                                                       | <fields>
+  // version(1) type(1) command(2) seq(4) index(4) fields(2) pad(2) LE | type(1) key(1) key value
+  encodeFrame (command, seq, index, params) {
+    const encoder = new TextEncoder()
+    const fields = []
+    let size = 16
+
+    for (const key in params) {
+      const value = params[key]
+      const name = encoder.encode(key)
+
+      if (value === undefined || value === null || name.length > 255) continue
+
+      if (typeof value === 'number' && Number.isSafeInteger(value)) {
+        fields.push({ type: 2, name, value })
+        size += 2 + name.length + 8
+      } else if (value instanceof ArrayBuffer || ArrayBuffer.isView(value)) {
+        const bytes = value instanceof ArrayBuffer
+          ? new Uint8Array(value)
+          : new Uint8Array(value.buffer, value.byteOffset, value.byteLength)
+
+        fields.push({ type: 3, name, value: bytes })
+        size += 2 + name.length + 4 + bytes.length
+      } else {
+        const bytes = encoder.encode(String(value))
+        fields.push({ type: 1, name, value: bytes })
+        size += 2 + name.length + 4 + bytes.length
+      }
+    }
+
+    const frame = new Uint8Array(size)
+    const view = new DataView(frame.buffer)
+    let offset = 16
+
+    view.setUint8(0, 1)
+    view.setUint8(1, 1)
+    view.setUint16(2, command, true)
+    view.setUint32(4, seq, true)
+    view.setInt32(8, index, true)
+    view.setUint16(12, fields.length, true)
+
+    for (const field of fields) {
+      view.setUint8(offset, field.type)
+      view.setUint8(offset + 1, field.name.length)
+      frame.set(field.name, offset + 2)
+      offset += 2 + field.name.length
+
+      if (field.type === 2) {
+        view.setBigInt64(offset, BigInt(field.value), true)
+        offset += 8
+      } else {
+        view.setUint32(offset, field.value.length, true)
+        frame.set(field.value, offset + 4)
+        offset += 4 + field.value.length
+      }
+    }
+
+    return frame
+  }
+
+  //  <header>                                                                | <data>
+  // version(1) type(1) pad(2) seq(4) message(4) headers(4) body(4) LE | message + headers + body
+  decodeFrame (buffer) {
+    const view = new DataView(buffer)
+    const decoder = new TextDecoder()
+
+    if (buffer.byteLength < 20 || view.getUint8(0) !== 1 || view.getUint8(1) !== 2) {
+      throw new Error('Malformed IPC response frame')
+    }
+
+    const messageLength = view.getUint32(8, true)
+    const headersLength = view.getUint32(12, true)
+    const bodyLength = view.getUint32(16, true)
+    let offset = 20
+
+    const message = decoder.decode(new Uint8Array(buffer, offset, messageLength))
+    offset += messageLength
+    const headers = decoder.decode(new Uint8Array(buffer, offset, headersLength))
+    offset += headersLength
+    const body = bodyLength > 0 ? buffer.slice(offset, offset + bodyLength) : null
+
+    return { seq: view.getUint32(4, true), message, headers, body }
+  }
+
+  sendFrame (command, seq, index, params) {
+    const frame = this.encodeFrame(command, Number(seq.slice(1)), index, params)
+    const xhr = new XMLHttpRequest()
+
+    xhr.responseType = 'arraybuffer'
+    xhr.onerror = () => this.resolve(seq, 1, new Error('IPC frame request failed'))
+    xhr.onload = () => {
+      let response = null
+      let value = null
+
+      try {
+        response = this.decodeFrame(xhr.response)
+        value = JSON.parse(response.message)
+      } catch (err) {
+        this.resolve(seq, 1, err)
+        return
+      }
+
+      // binary results are delivered like posts, see `Core::createPost()`
+      if (response.body) {
+        const params = value && typeof value === 'object' ? { ...value, seq } : value
+        const detail = {
+          data: response.body,
+          sid: '0',
+          headers: Object.fromEntries(
+            response.headers.trim().split(/[\r\n]+/).filter(Boolean)
+              .map(l => l.trim().split(/\s*:\s*/))
+          ),
+          params
+        }
+
+        queueMicrotask(() => this.emit('data', detail))
+      }
+
+      this.resolve(seq, 0, value)
+    }
+
+    xhr.open('POST', `ipc://frame?index=${index}`)
+    xhr.send(frame)
+  }
+
+  // results coalesced natively into one script, see `Bridge::flushDeliveries()`
+  deliver (entries) {
+    for (const [seq, status, value] of entries) {
+      this.resolve(seq, status, value).catch(console.error)
+    }
+  }
+
   send (name, value) {
     const seq = 'R' + this.nextSeq++
     const index = window.process.index
@@ -99,6 +267,13 @@ window._ipc = new class IPC {
         value = { value }
       }
 
+      const command = this.protocol.commands[name]
+
+      if (this.protocol.version >= 1 && command) {
+        this.sendFrame(command, seq, index, value)
+        return Object.assign(promise, { index, seq })
+      }
+
       const params = {
         ...value,
         index,
@@ -118,6 +293,123 @@ window._ipc = new class IPC {
     return Object.assign(promise, { index, seq })
   }
 
+  // sends `[name, value]` pairs as one `batch` command, the native side
+  // replies once with every result, in order, as `{ data }` or `{ err }`
+  async sendBatch (commands) {
+    const index = window.process.index
+    const uris = commands.map(([name, value], i) => {
+      if (({}).toString.call(value) !== '[object Object]') {
+        value = { value }
+      }
+
+      const params = new URLSearchParams({ ...value, index, seq: `B${i}` })
+      return `ipc://${name}?${params.toString().replace(/\+/g, '%20')}`
+    })
+
+    const result = await this.send('batch', { commands: uris.join('\n') })
+    return result?.data ?? []
+  }
+
+  // unsolicited data is delivered in batches over a long-poll request,
+  // see `Bridge::pollPosts()`, and falls back to eval'd posts when it stops
+  async poll () {
+    const index = window.process?.index || 0
+
+    while (true) {
+      const buffer = await new Promise(resolve => {
+        const xhr = new XMLHttpRequest()
+        xhr.responseType = 'arraybuffer'
+        xhr.onload = () => resolve(xhr.response)
+        xhr.onerror = () => resolve(null)
+        xhr.open('GET', `ipc://post.poll?index=${index}`)
+        xhr.send()
+      })
+
+      if (!buffer) break
+      this.receivePosts(buffer)
+    }
+  }
+
+  //  <header>                                             | <data>
+  // sid(4) + seq(4) + params(4) + headers(4) + body(4) LE | sid + seq + params + headers + body
+  receivePosts (buffer) {
+    const view = new DataView(buffer)
+    const decoder = new TextDecoder()
+    let offset = 0
+
+    const read = length => {
+      const value = decoder.decode(new Uint8Array(buffer, offset, length))
+      offset += length
+      return value
+    }
+
+    while (offset + 20 <= buffer.byteLength) {
+      const lengths = [0, 1, 2, 3, 4].map(i => view.getUint32(offset + i * 4, true))
+      offset += 20
+
+      const sid = read(lengths[0])
+      const seq = read(lengths[1])
+      let params = read(lengths[2])
+      const headers = read(lengths[3])
+      const data = buffer.slice(offset, offset + lengths[4])
+      offset += lengths[4]
+
+      try { params = JSON.parse(params) } catch (err) {
+        console.error(err.stack || err, params)
+      }
+
+      if (params && typeof params === 'object') params.seq = seq
+
+      const detail = {
+        data,
+        sid,
+        headers: Object.fromEntries(
+          headers.trim().split(/[\r\n]+/).filter(Boolean)
+            .map(l => l.trim().split(/\s*:\s*/))
+        ),
+        params
+      }
+
+      queueMicrotask(() => this.emit('data', detail))
+    }
+  }
+
+  // pull based stream over `fs.readStream`, each pull fetches one chunk that
+  // was read ahead natively, so at most a couple of chunks are in memory
+  readStream (id, options = {}) {
+    const index = window.process?.index || 0
+    let offset = Number(options.offset) || 0
+
+    return new ReadableStream({
+      pull: async controller => {
+        const seq = 'R' + this.nextSeq++
+        const xhr = await new Promise((resolve, reject) => {
+          const xhr = new XMLHttpRequest()
+          xhr.responseType = 'arraybuffer'
+          xhr.onload = () => resolve(xhr)
+          xhr.onerror = () => reject(new Error('fs.readStream request failed'))
+          xhr.open('GET', `ipc://fs.readStream?id=${id}&offset=${offset}&index=${index}&seq=${seq}`)
+          xhr.send()
+        })
+
+        if (/json/.test(xhr.getResponseHeader('content-type'))) {
+          let message = new TextDecoder().decode(xhr.response)
+          try { message = JSON.parse(message)?.err?.message || message } catch {}
+          controller.error(new Error(message))
+          return
+        }
+
+        if (xhr.response.byteLength === 0) {
+          controller.close()
+          return
+        }
+
+        offset += xhr.response.byteLength
+        controller.enqueue(new Uint8Array(xhr.response))
+      }
+    })
+  }
+
   emit (name, value, target, options) {
     let detail = value
 
@@ -180,7 +472,8 @@ void (() => {
       const { method, seq, url } = this
       const index = window.process.index
 
-      if (url?.protocol === 'ipc:') {
+      // frames already carry their bytes, see `_ipc.sendFrame()`
+      if (url?.protocol === 'ipc:' && !url.href.startsWith('ipc://frame')) {
         if (
           /put|post/i.test(method) &&
           typeof body !== 'undefined' &&
@@ -192,12 +485,19 @@ void (() => {
           }
 
           if (/linux/i.test(window.process?.platform)) {
+            const transport = window._ipc?.protocol?.transport
+
+            if (body?.buffer instanceof ArrayBuffer && transport === 'body') {
+              // read by the `ipc` scheme handler as is
+              return send.call(this, body)
+            }
+
             if (body?.buffer instanceof ArrayBuffer) {
               const header = new Uint8Array(24)
               const buffer = new Uint8Array(
                 B5_PREFIX_BUFFER.length +
                 header.length +
-                body.length
+                body.byteLength
               )
 
               header.set(encoder.encode(index))
@@ -207,20 +507,28 @@ void (() => {
               // "b5"(2) | index(2) + seq(2) | body(n)
               buffer.set(B5_PREFIX_BUFFER)
               buffer.set(header, B5_PREFIX_BUFFER.length)
-              buffer.set(body, B5_PREFIX_BUFFER.length + header.length)
+              buffer.set(
+                new Uint8Array(body.buffer, body.byteOffset, body.byteLength),
+                B5_PREFIX_BUFFER.length + header.length
+              )
 
-              let data = []
-              const quota = 64 * 1024
-              for (let i = 0; i < buffer.length; i += quota) {
-                data.push(String.fromCharCode(...buffer.subarray(i, i + quota)))
-              }
+              if (transport === 'typed-array') {
+                // native code views the posted bytes directly
+                await window.external.invoke(buffer)
+              } else {
+                let data = []
+                const quota = 64 * 1024
+                for (let i = 0; i < buffer.length; i += quota) {
+                  data.push(String.fromCharCode(...buffer.subarray(i, i + quota)))
+                }
 
-              data = data.join('')
+                data = data.join('')
 
-              try { data = decodeURIComponent(escape(data)) }
-              catch (err) { void err }
+                try { data = decodeURIComponent(escape(data)) }
+                catch (err) { void err }
 
-              await window.external.invoke(data)
+                await window.external.invoke(data)
+              }
             }
 
             body = null
@@ -602,17 +602,13 @@ extern "C" {
     }
 
     auto coreId = GetNativeCoreIDFromJString(env, id);
+    auto size = env->GetArrayLength(bytes);
+    auto body = SSC::Buffer::heap(size);
+    env->GetByteArrayRegion(bytes, 0, size, (jbyte *) body.data());
+
     if (core->hasPost(coreId)) {
       auto post = core->getPost(coreId);
-      auto size = env->GetArrayLength(bytes);
-      auto body = new char[size];
-      if (post.bodyNeedsFree && post.body) {
-        delete (char *) post.body;
-      }
-
       post.body = body;
-      post.length = size;
-      post.bodyNeedsFree = true;
 
       auto js = core->createPost(
         NativeString(env, seq).str(),
@@ -622,10 +618,6 @@ extern "C" {
 
       return env->NewStringUTF(js.c_str());
     } else {
-      auto size = env->GetArrayLength(bytes);
-      auto body = new char[size];
-      env->GetByteArrayRegion(bytes, 0, size, (jbyte *) body);
-
       auto js = core->createPost(
         NativeString(env, seq).str(),
         NativeString(env, params).str(),
@@ -633,9 +625,7 @@ extern "C" {
           .id = coreId,
           .ttl = 0,
           .body = body,
-          .length = size,
-          .headers = NativeString(env, headers).str(),
-          .bodyNeedsFree = true
+          .headers = NativeString(env, headers).str()
         }
       );
 
@@ -657,9 +647,9 @@ extern "C" {
 
     auto postId = GetNativeCoreIDFromJString(env, id);
     auto post = reinterpret_cast<SSC::Core *>(core)->getPost(postId);
-    auto bytes = env->NewByteArray(post.length);
+    auto bytes = env->NewByteArray(post.body.size());
 
-    env->SetByteArrayRegion(bytes, 0, post.length, (jbyte *) post.body);
+    env->SetByteArrayRegion(bytes, 0, post.body.size(), (jbyte *) post.body.data());
 
     return bytes;
   }
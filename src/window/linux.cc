@@ -31,10 +31,35 @@ namespace SSC {
       G_CALLBACK(+[](WebKitUserContentManager*, WebKitJavascriptResult* r, gpointer arg) {
         auto *window = static_cast<Window*>(arg);
         auto value = webkit_javascript_result_get_js_value(r);
-        auto str = SSC::String(jsc_value_to_string(value));
+        auto bridge = window->app.bridge;
+
+        // "b5" | index(4) | seq(20) | body(n), bodies for `fs.write(v)` and
+        // `udp.send` go straight into the bridge's buffer registry
+        constexpr size_t offset = 2 + 4 + 20;
+        auto getIndex = [](const char *data) {
+          int index = -1;
+          std::from_chars(data + 2, data + 2 + strnlen(data + 2, 4), index);
+          return index;
+        };
+
+#if SSC_IPC_TYPED_ARRAYS
+        if (jsc_value_is_typed_array(value)) {
+          gsize size = 0;
+          auto data = (const char *) jsc_value_typed_array_get_data(value, &size);
+
+          // copied once, JSC may move the bytes once this returns
+          if (data != nullptr && size >= offset && data[0] == 'b' && data[1] == '5') {
+            auto seq = SSC::String(data + 2 + 4, strnlen(data + 2 + 4, 20));
+            bridge->queueBuffer(getIndex(data), seq, Buffer::copy(data + offset, size - offset));
+          }
+
+          return;
+        }
+#endif
 
-        char *buf = nullptr;
-        size_t bufsize = 0;
+        auto string = jsc_value_to_string(value);
+        auto str = SSC::String(string);
+        g_free(string);
 
         // 'b5' for 'buffer'
         if (str.size() >= 2 && str.at(0) == 'b' && str.at(1) == '5') {
@@ -42,35 +67,31 @@ namespace SSC {
           auto bytes = jsc_value_to_string_as_bytes(value);
           auto data = (char *) g_bytes_get_data(bytes, &size);
 
-          if (size > 6) {
-            size_t offset = 2 + 4 + 20; // buf offset
-            auto index = new char[4]{0};
-            auto seq = new char[20]{0};
+          if (size >= offset) {
+            char header[4 + 20 + 2] = {0};
+            decodeUTF8(header + 2, data + 2, 4);
+            decodeUTF8(header + 2 + 4, data + 2 + 4, 20);
 
-            decodeUTF8(index, data + 2, 4);
-            decodeUTF8(seq, data + 2 + 4, 20);
+            // the decoded body is handed over as is, not copied again
+            auto buf = new char[size - offset]{0};
+            auto bufsize = decodeUTF8(buf, data + offset, size - offset);
+            auto buffer = Buffer::adopt(buf, bufsize, [](char *bytes, size_t, void *) {
+              delete [] bytes;
+            });
 
-            buf = new char[size - offset]{0};
-            bufsize = decodeUTF8(buf, data + offset, size - offset);
-
-            str = SSC::String("ipc://buffer.queue?")
-              + SSC::String("index=") + SSC::String(index)
-              + SSC::String("&seq=") + SSC::String(seq);
-
-            delete [] index;
-            delete [] seq;
+            auto seq = SSC::String(header + 2 + 4, strnlen(header + 2 + 4, 20));
+            bridge->queueBuffer(getIndex(header), seq, std::move(buffer));
           }
+
+          g_bytes_unref(bytes);
+          return;
         }
 
-        if (!window->app.bridge->route(str, buf, bufsize)) {
+        if (!bridge->route(str, nullptr, 0)) {
           if (window->onMessage != nullptr) {
             window->onMessage(str);
           }
         }
-
-        if (buf != nullptr) {
-          delete [] buf;
-        }
       }),
       this
     );
@@ -0,0 +1,131 @@
+//
+// Checks that with `SSC_LINUX_EVENT_LOOP_THREAD=1` UDP receive does not
+// wait on the UI thread. The main thread stands in for GTK and is blocked
+// for a second while datagrams stamped with their send time arrive, each
+// one must reach `udpReadStart()` quickly. Prints TAP, see `test/udp-latency.sh`.
+//
+#include <arpa/inet.h>
+#include <future>
+#include <sys/socket.h>
+
+#include "../src/core/core.hh"
+
+using namespace SSC;
+
+using Clock = std::chrono::steady_clock;
+
+constexpr int DATAGRAMS = 100;
+constexpr auto SEND_INTERVAL = std::chrono::milliseconds(10);
+constexpr auto UI_BLOCKED = std::chrono::milliseconds(1000);
+constexpr uint64_t MAX_LATENCY = 50; // in milliseconds
+
+static int tests = 0;
+static int failures = 0;
+
+static void ok (bool value, const String& name) {
+  tests++;
+
+  if (!value) {
+    failures++;
+    std::cout << "not ok " << tests << " - " << name << std::endl;
+  } else {
+    std::cout << "ok " << tests << " - " << name << std::endl;
+  }
+}
+
+static uint64_t now () {
+  return std::chrono::duration_cast<std::chrono::microseconds>(
+    Clock::now().time_since_epoch()
+  ).count();
+}
+
+int main () {
+  auto core = new Core();
+  std::cout << "TAP version 13" << std::endl;
+
+#if !SSC_LINUX_EVENT_LOOP_THREAD
+  ok(false, "built with SSC_LINUX_EVENT_LOOP_THREAD=1");
+  return 1;
+#endif
+
+  std::promise<String> bound;
+  core->udpBind("1", 1, "127.0.0.1", 0, false, [&](auto seq, auto msg, auto post) {
+    bound.set_value(msg);
+  });
+
+  auto msg = bound.get_future().get();
+  auto offset = msg.find("\"port\": ");
+  ok(offset != String::npos, "a peer was bound");
+
+  if (offset == String::npos) {
+    std::cout << "# " << msg << std::endl;
+    return 1;
+  }
+
+  auto port = std::stoi(msg.substr(offset + 8));
+
+  std::mutex mutex;
+  std::vector<uint64_t> latencies;
+  std::promise<void> started;
+
+  core->udpReadStart("2", 1, [&](auto seq, auto msg, auto post) {
+    if (seq != "-1") {
+      started.set_value();
+      return;
+    }
+
+    if (post.body.size() != sizeof(uint64_t)) return;
+
+    uint64_t sent = 0;
+    memcpy(&sent, post.body.data(), sizeof(sent));
+
+    std::lock_guard<std::mutex> guard(mutex);
+    latencies.push_back(now() - sent);
+  });
+
+  started.get_future().get();
+
+  auto sender = std::thread([port] {
+    auto fd = socket(AF_INET, SOCK_DGRAM, 0);
+    struct sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    inet_pton(AF_INET, "127.0.0.1", &addr.sin_addr);
+
+    for (int i = 0; i < DATAGRAMS; ++i) {
+      auto sent = now();
+      sendto(fd, &sent, sizeof(sent), 0, (struct sockaddr *) &addr, sizeof(addr));
+      std::this_thread::sleep_for(SEND_INTERVAL);
+    }
+
+    close(fd);
+  });
+
+  // the UI thread is busy for the whole burst, as with a long layout
+  std::this_thread::sleep_for(UI_BLOCKED);
+  sender.join();
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+  std::lock_guard<std::mutex> guard(mutex);
+  std::sort(latencies.begin(), latencies.end());
+
+  ok(latencies.size() == DATAGRAMS, "every datagram was received while the UI thread was blocked");
+
+  if (latencies.size() > 0) {
+    auto p50 = latencies[latencies.size() / 2];
+    auto max = latencies.back();
+
+    std::cout << "# latency p50 " << p50 << "us, max " << max << "us" << std::endl;
+    ok(max < MAX_LATENCY * 1000, "no datagram waited on the UI thread");
+  }
+
+  auto stats = core->getEventLoopStats();
+  std::cout << "# " << stats << std::endl;
+  ok(stats.find("\"stalls\":0") != String::npos, "loop.stats reports no stalls");
+
+  std::cout << "1.." << tests << std::endl;
+
+  // the loop thread is still running, skip static destructors
+  std::cout << std::flush;
+  _exit(failures > 0 ? 1 : 0);
+}
@@ -0,0 +1,27 @@
+#!/bin/bash
+# Builds `test/udp-latency.cc` against the core with the Linux event loop
+# thread enabled and runs it. Run from the repository root, extra include
+# and library paths for libuv can be given in `CXXFLAGS` and `LDFLAGS`.
+CXX=${CXX:-c++}
+
+function die {
+  if [ ! $1 = 0 ]; then
+    echo "not ok - $2" && exit 1
+  fi
+  echo "ok - $2"
+}
+
+mkdir -p test/tmp
+
+"$CXX" -std=c++2a -O2 -DSSC_LINUX_EVENT_LOOP_THREAD=1 ${CXXFLAGS} \
+  `pkg-config --cflags gtk+-3.0 webkit2gtk-4.1 2>/dev/null` \
+  src/core/{core,fs,ipc,javascript,loop,peer,timers,udp}.cc \
+  test/udp-latency.cc \
+  ${LDFLAGS} -luv -lpthread \
+  -o test/tmp/udp-latency
+die $? "the udp latency test was built"
+
+./test/tmp/udp-latency
+die $? "udp receive does not wait on a blocked ui thread"
+
+rm -rf test/tmp
@@ -0,0 +1,225 @@
+//
+// Checks `encodeURIComponent()` and `decodeURIComponent()` against the
+// scalar implementations they replaced, byte for byte, on inputs that
+// cross every 16 byte block boundary. Prints TAP, see `test/uri.sh`.
+//
+#include <random>
+
+#include "../src/core/common.hh"
+
+namespace reference {
+  using SSC::String;
+
+  static const signed char HEX2DEC[256] = {
+    /*       0  1  2  3   4  5  6  7   8  9  A  B   C  D  E  F */
+    /* 0 */ -1,-1,-1,-1, -1,-1,-1,-1, -1,-1,-1,-1, -1,-1,-1,-1,
+    /* 1 */ -1,-1,-1,-1, -1,-1,-1,-1, -1,-1,-1,-1, -1,-1,-1,-1,
+    /* 2 */ -1,-1,-1,-1, -1,-1,-1,-1, -1,-1,-1,-1, -1,-1,-1,-1,
+    /* 3 */  0, 1, 2, 3,  4, 5, 6, 7,  8, 9,-1,-1, -1,-1,-1,-1,
+
+    /* 4 */ -1,10,11,12, 13,14,15,-1, -1,-1,-1,-1, -1,-1,-1,-1,
+    /* 5 */ -1,-1,-1,-1, -1,-1,-1,-1, -1,-1,-1,-1, -1,-1,-1,-1,
+    /* 6 */ -1,10,11,12, 13,14,15,-1, -1,-1,-1,-1, -1,-1,-1,-1,
+    /* 7 */ -1,-1,-1,-1, -1,-1,-1,-1, -1,-1,-1,-1, -1,-1,-1,-1,
+
+    /* 8 */ -1,-1,-1,-1, -1,-1,-1,-1, -1,-1,-1,-1, -1,-1,-1,-1,
+    /* 9 */ -1,-1,-1,-1, -1,-1,-1,-1, -1,-1,-1,-1, -1,-1,-1,-1,
+    /* A */ -1,-1,-1,-1, -1,-1,-1,-1, -1,-1,-1,-1, -1,-1,-1,-1,
+    /* B */ -1,-1,-1,-1, -1,-1,-1,-1, -1,-1,-1,-1, -1,-1,-1,-1,
+
+    /* C */ -1,-1,-1,-1, -1,-1,-1,-1, -1,-1,-1,-1, -1,-1,-1,-1,
+    /* D */ -1,-1,-1,-1, -1,-1,-1,-1, -1,-1,-1,-1, -1,-1,-1,-1,
+    /* E */ -1,-1,-1,-1, -1,-1,-1,-1, -1,-1,-1,-1, -1,-1,-1,-1,
+    /* F */ -1,-1,-1,-1, -1,-1,-1,-1, -1,-1,-1,-1, -1,-1,-1,-1
+  };
+
+  static const char SAFE[256] = {
+      /*      0 1 2 3  4 5 6 7  8 9 A B  C D E F */
+      /* 0 */ 0,0,0,0, 0,0,0,0, 0,0,0,0, 0,0,0,0,
+      /* 1 */ 0,0,0,0, 0,0,0,0, 0,0,0,0, 0,0,0,0,
+      /* 2 */ 0,0,0,0, 0,0,0,0, 0,0,0,0, 0,0,0,0,
+      /* 3 */ 1,1,1,1, 1,1,1,1, 1,1,0,0, 0,0,0,0,
+
+      /* 4 */ 0,1,1,1, 1,1,1,1, 1,1,1,1, 1,1,1,1,
+      /* 5 */ 1,1,1,1, 1,1,1,1, 1,1,1,0, 0,0,0,0,
+      /* 6 */ 0,1,1,1, 1,1,1,1, 1,1,1,1, 1,1,1,1,
+      /* 7 */ 1,1,1,1, 1,1,1,1, 1,1,1,0, 0,0,0,0,
+
+      /* 8 */ 0,0,0,0, 0,0,0,0, 0,0,0,0, 0,0,0,0,
+      /* 9 */ 0,0,0,0, 0,0,0,0, 0,0,0,0, 0,0,0,0,
+      /* A */ 0,0,0,0, 0,0,0,0, 0,0,0,0, 0,0,0,0,
+      /* B */ 0,0,0,0, 0,0,0,0, 0,0,0,0, 0,0,0,0,
+
+      /* C */ 0,0,0,0, 0,0,0,0, 0,0,0,0, 0,0,0,0,
+      /* D */ 0,0,0,0, 0,0,0,0, 0,0,0,0, 0,0,0,0,
+      /* E */ 0,0,0,0, 0,0,0,0, 0,0,0,0, 0,0,0,0,
+      /* F */ 0,0,0,0, 0,0,0,0, 0,0,0,0, 0,0,0,0
+  };
+
+  // the scalar `decodeURIComponent()` as it was before the block kernels
+  String decodeURIComponent (const String& sSrc) {
+    auto s = SSC::replace(sSrc, "\\+", " ");
+    const unsigned char* pSrc = (const unsigned char *) s.c_str();
+    const int SRC_LEN = (int) sSrc.length();
+    const unsigned char* const SRC_END = pSrc + SRC_LEN;
+    const unsigned char* const SRC_LAST_DEC = SRC_END - 2;
+
+    char* const pStart = new char[SRC_LEN];
+    char* pEnd = pStart;
+
+    while (pSrc < SRC_LAST_DEC) {
+      if (*pSrc == '%') {
+        char dec1, dec2;
+        if (-1 != (dec1 = HEX2DEC[*(pSrc + 1)])
+            && -1 != (dec2 = HEX2DEC[*(pSrc + 2)])) {
+
+            *pEnd++ = (dec1 << 4) + dec2;
+            pSrc += 3;
+            continue;
+        }
+      }
+      *pEnd++ = *pSrc++;
+    }
+
+    // the last 2- chars
+    while (pSrc < SRC_END) {
+      *pEnd++ = *pSrc++;
+    }
+
+    String sResult(pStart, pEnd);
+    delete [] pStart;
+    return sResult;
+  }
+
+  // the scalar `encodeURIComponent()` as it was before the block kernels
+  String encodeURIComponent (const String& sSrc) {
+    const char DEC2HEX[16 + 1] = "0123456789ABCDEF";
+    const unsigned char* pSrc = (const unsigned char*) sSrc.c_str();
+    const int SRC_LEN = (int) sSrc.length();
+    unsigned char* const pStart = new unsigned char[SRC_LEN* 3];
+    unsigned char* pEnd = pStart;
+    const unsigned char* const SRC_END = pSrc + SRC_LEN;
+
+    for (; pSrc < SRC_END; ++pSrc) {
+      if (SAFE[*pSrc]) {
+        *pEnd++ = *pSrc;
+      } else {
+        // escape this char
+        *pEnd++ = '%';
+        *pEnd++ = DEC2HEX[*pSrc >> 4];
+        *pEnd++ = DEC2HEX[*pSrc & 0x0F];
+      }
+    }
+
+    String sResult((char*) pStart, (char*) pEnd);
+    delete [] pStart;
+    return sResult;
+  }
+}
+
+static int tests = 0;
+static int failures = 0;
+
+static void ok (bool value, const SSC::String& name) {
+  tests++;
+
+  if (!value) {
+    failures++;
+    std::cout << "not ok " << tests << " - " << name << std::endl;
+  } else {
+    std::cout << "ok " << tests << " - " << name << std::endl;
+  }
+}
+
+// the first input that does not match, if any
+template <typename Generate> static std::optional<SSC::String> mismatch (int count, Generate generate) {
+  for (int i = 0; i < count; ++i) {
+    auto input = generate(i);
+
+    if (
+      SSC::encodeURIComponent(input) != reference::encodeURIComponent(input) ||
+      SSC::decodeURIComponent(input) != reference::decodeURIComponent(input) ||
+      SSC::decodeURIComponent(SSC::encodeURIComponent(input)) != input
+    ) {
+      return input;
+    }
+  }
+
+  return std::nullopt;
+}
+
+int main () {
+  std::mt19937 random(7);
+  auto byte = [&](const char *alphabet) {
+    auto size = strlen(alphabet);
+    return alphabet[random() % size];
+  };
+
+  std::cout << "TAP version 13" << std::endl;
+
+#if SSC_URI_SSE2
+  std::cout << "# block kernels: SSE2" << std::endl;
+#elif SSC_URI_NEON
+  std::cout << "# block kernels: NEON" << std::endl;
+#else
+  std::cout << "# block kernels: none (scalar)" << std::endl;
+#endif
+
+  auto empty = mismatch(1, [](int) { return SSC::String(); });
+  ok(!empty, "the empty string matches");
+
+  // every length up to a few blocks, so each tail size is covered
+  auto lengths = mismatch(64 * 8, [&](int i) {
+    SSC::String input;
+    for (int j = 0; j < i / 8; ++j) {
+      input.push_back(i % 8 == 0 ? byte("%+ aZ09") : byte("abcXYZ019"));
+    }
+    return input;
+  });
+  ok(!lengths, "inputs of every length up to 64 bytes match");
+
+  auto bytes = mismatch(100000, [&](int) {
+    SSC::String input(random() % 80, '\0');
+    for (auto& c : input) {
+      c = (char) (random() % 256);
+    }
+    return input;
+  });
+  ok(!bytes, "random bytes match");
+
+  // escapes split across block boundaries, truncated and invalid ones
+  auto escapes = mismatch(100000, [&](int) {
+    SSC::String input(random() % 80, '\0');
+    for (auto& c : input) {
+      c = byte("%%%++aZ09fF%2B%zz%4");
+    }
+    return input;
+  });
+  ok(!escapes, "'%' and '+' heavy inputs match");
+
+  auto text = mismatch(20000, [&](int) {
+    SSC::String input(random() % 200, '\0');
+    for (auto& c : input) {
+      c = random() % 16 == 0 ? byte("%+ /\"{}:,") : byte("abcdefghijklmnopqrstuvwxyz0123456789");
+    }
+    return input;
+  });
+  ok(!text, "mostly alphanumeric inputs match");
+
+  SSC::String json;
+  for (int i = 0; i < 4096; ++i) {
+    json += R"({"source":"fs.read","data":{"id":"1234567890","bytes":4096}})";
+  }
+
+  auto large = mismatch(1, [&](int) { return json; });
+  ok(!large, "a large JSON payload matches");
+
+  for (const auto& input : { empty, lengths, bytes, escapes, text, large }) {
+    if (input) {
+      std::cout << "# first mismatch: " << reference::encodeURIComponent(*input) << std::endl;
+    }
+  }
+
+  std::cout << "1.." << tests << std::endl;
+  return failures > 0 ? 1 : 0;
+}
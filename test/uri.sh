@@ -0,0 +1,27 @@
+#!/bin/bash
+# Builds and runs `test/uri.cc` with the block kernels of this machine and
+# with the scalar fallback. Run from the repository root.
+CXX=${CXX:-c++}
+
+function die {
+  if [ ! $1 = 0 ]; then
+    echo "not ok - $2" && exit 1
+  fi
+  echo "ok - $2"
+}
+
+mkdir -p test/tmp
+
+$CXX -std=c++2a -O2 test/uri.cc -o test/tmp/uri
+die $? "the uri test was built"
+
+./test/tmp/uri
+die $? "uri components match the scalar reference"
+
+$CXX -std=c++2a -O2 -DSSC_URI_SCALAR test/uri.cc -o test/tmp/uri-scalar
+die $? "the scalar uri test was built"
+
+./test/tmp/uri-scalar
+die $? "scalar uri components match the scalar reference"
+
+rm -rf test/tmp